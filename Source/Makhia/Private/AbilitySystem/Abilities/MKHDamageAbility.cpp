@@ -6,6 +6,10 @@
 #include "AbilitySystemGlobals.h"
 #include "AbilitySystem/MKHAbilityTypes.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "AbilitySystem/Tasks/MKHAbilityTask_CombatTimeline.h"
+#include "Animation/AnimMontage.h"
+#include "Character/CharacterBase.h"
+#include "Combat/AnimNotify_CombatEvent.h"
 #include "Equipment/EquipmentInstance.h"
 #include "Equipment/EquipmentManagerComponent.h"
 #include "Equipment/Weapon/MKHWeaponBase.h"
@@ -14,27 +18,100 @@
 #include "Abilities/Tasks/AbilityTask_PlayMontageAndWait.h"
 #include "Abilities/Tasks/AbilityTask_WaitGameplayEvent.h"
 #include "Data/GenericClassReference.h"
+#include "HAL/IConsoleManager.h"
 #include "Player/PlayerController/MKHPlayerController.h"
+#include "UObject/ObjectSaveContext.h"
 
-UMKHDamageAbility::UMKHDamageAbility()
+namespace DamageAbilityTimeline
 {
-	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
-}
+	bool bServerTimeline = true;
+	FAutoConsoleVariableRef CVarServerTimeline(
+		TEXT("Makhia.Combat.ServerTimeline"),
+		bServerTimeline,
+		TEXT("Servers send the combat events of damage abilities from their baked timeline instead of montage notifies."));
+
+#if WITH_EDITOR
+	/** Event name without the "Event." root and separators, e.g. "HitScanStart". */
+	FString GetMatchName(const FGameplayTag& Tag)
+	{
+		FString Name = Tag.ToString();
+		Name.RemoveFromStart(TEXT("Event."));
+		return Name.Replace(TEXT("."), TEXT(""));
+	}
 
-void UMKHDamageAbility::SetDamagePercent(float InDamagePercent)
-{
-	DamagePercent = FMath::Max(0.f, InDamagePercent);
+	/** Notify or class name without separators, so "AN_HitScan_Start" matches "HitScanStart". */
+	FString Normalize(const FString& Name)
+	{
+		return Name.Replace(TEXT("_"), TEXT("")).Replace(TEXT(" "), TEXT(""));
+	}
+
+	FGameplayTag ResolveEventTag(const FAnimNotifyEvent& NotifyEvent)
+	{
+		if (const UAnimNotify_CombatEvent* CombatNotify = Cast<UAnimNotify_CombatEvent>(NotifyEvent.Notify))
+		{
+			return CombatNotify->EventTag;
+		}
+
+		const FString NotifyName = Normalize(NotifyEvent.NotifyName.ToString());
+		const FString ClassName = NotifyEvent.Notify ? Normalize(NotifyEvent.Notify->GetClass()->GetName()) : FString();
+
+		const FGameplayTag EventTags[] = {
+			MKHGameplayTags::Event::HitScanStart,
+			MKHGameplayTags::Event::HitScanEnd,
+			MKHGameplayTags::Event::ContinueComboStart,
+			MKHGameplayTags::Event::ContinueComboEnd,
+			MKHGameplayTags::Event::SpawnProjectile
+		};
+		for (const FGameplayTag& EventTag : EventTags)
+		{
+			const FString MatchName = GetMatchName(EventTag);
+			if (NotifyName.Contains(MatchName) || ClassName.Contains(MatchName))
+			{
+				return EventTag;
+			}
+		}
+		return FGameplayTag();
+	}
+
+	/** Notify states standing for a whole window open it at their start and close it at their end. */
+	bool ResolveWindowTags(const FAnimNotifyEvent& NotifyEvent, FGameplayTag& OutStartTag, FGameplayTag& OutEndTag)
+	{
+		if (!NotifyEvent.NotifyStateClass)
+		{
+			return false;
+		}
+
+		const FString Name = Normalize(NotifyEvent.NotifyStateClass->GetClass()->GetName() + NotifyEvent.NotifyName.ToString());
+		if (Name.Contains(TEXT("HitScan")))
+		{
+			OutStartTag = MKHGameplayTags::Event::HitScanStart;
+			OutEndTag = MKHGameplayTags::Event::HitScanEnd;
+			return true;
+		}
+		if (Name.Contains(TEXT("ContinueCombo")))
+		{
+			OutStartTag = MKHGameplayTags::Event::ContinueComboStart;
+			OutEndTag = MKHGameplayTags::Event::ContinueComboEnd;
+			return true;
+		}
+		return false;
+	}
+#endif
 }
 
-void UMKHDamageAbility::SetCooldownData(float InCooldownTime, const FGameplayTagContainer& InCooldownTagContainer)
+UMKHDamageAbility::UMKHDamageAbility()
 {
-	CooldownTime = FMath::Max(0.f, InCooldownTime);
-	CooldownTagContainer = InCooldownTagContainer;
+	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
 }
 
-void UMKHDamageAbility::SetIsSkillAbility(bool InIsSkillAbility)
+void UMKHDamageAbility::ApplyGrantConfig(const FMKHAbilityGrantConfig& Config)
 {
-	bIsSkillAbility = InIsSkillAbility;
+	Super::ApplyGrantConfig(Config);
+
+	DamagePercent = Config.DamagePercent;
+	bIsSkillAbility = Config.bIsSkillAbility;
+	CooldownTime = Config.CooldownTime;
+	CooldownTagContainer = Config.CooldownTags;
 }
 
 void UMKHDamageAbility::CaptureDamageEffectInfo(AActor* TargetActor, FDamageEffectInfo& OutInfo)
@@ -47,6 +124,7 @@ void UMKHDamageAbility::CaptureDamageEffectInfo(AActor* TargetActor, FDamageEffe
 		OutInfo.BaseDamage = GetBaseDamageValue(WeaponBaseDamage);
 		OutInfo.DamageEffect = DamageEffect;
 		OutInfo.SourceASC = GetAbilitySystemComponentFromActorInfo();
+		OutInfo.SourceAbility = this;
 		// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("Captured Damage Info: BaseDamage = %f , WeaponDamage = %f"), OutInfo.BaseDamage, WeaponBaseDamage));
 		if (IsValid(TargetActor) && TargetActor->GetClass()->ImplementsInterface(UAbilitySystemInterface::StaticClass()))
 		{
@@ -113,9 +191,74 @@ void UMKHDamageAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
 	{
 		return EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
 	}
+
+	bUsingServerTimeline = ShouldUseServerTimeline(ActorInfo);
+	if (bUsingServerTimeline)
+	{
+		if (UMKHAbilityTask_CombatTimeline* TimelineTask = UMKHAbilityTask_CombatTimeline::PlayCombatTimeline(this, AttackMontageToPlay, CombatTimeline))
+		{
+			TimelineTask->ReadyForActivation();
+		}
+	}
+	else if (ActorInfo && ActorInfo->IsNetAuthority())
+	{
+		// No timeline for this montage: its notifies need the animation evaluated
+		AcquireServerPose();
+	}
 	OnMontageStarted();
 }
 
+void UMKHDamageAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled)
+{
+	while (NumServerPoseHolds > 0)
+	{
+		ReleaseServerPose();
+	}
+	bUsingServerTimeline = false;
+
+	Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+}
+
+bool UMKHDamageAbility::ShouldUseServerTimeline(const FGameplayAbilityActorInfo* ActorInfo) const
+{
+	if (!DamageAbilityTimeline::bServerTimeline || !ActorInfo || !ActorInfo->IsNetAuthority() || !CombatTimeline.IsBakedFor(AttackMontageToPlay))
+	{
+		return false;
+	}
+
+	// A listen server's own character is animated for its player anyway
+	return GetWorld()->GetNetMode() == NM_DedicatedServer || !ActorInfo->IsLocallyControlled();
+}
+
+bool UMKHDamageAbility::AcceptsCombatEvent(const FGameplayEventData& Payload) const
+{
+	return !bUsingServerTimeline || Payload.OptionalObject == this;
+}
+
+void UMKHDamageAbility::AcquireServerPose()
+{
+	if (ACharacterBase* Character = Cast<ACharacterBase>(GetAvatarActorFromActorInfo()))
+	{
+		Character->AcquireServerPose();
+		++NumServerPoseHolds;
+	}
+}
+
+void UMKHDamageAbility::ReleaseServerPose()
+{
+	if (NumServerPoseHolds == 0)
+	{
+		return;
+	}
+
+	--NumServerPoseHolds;
+	if (ACharacterBase* Character = Cast<ACharacterBase>(GetAvatarActorFromActorInfo()))
+	{
+		Character->ReleaseServerPose();
+	}
+}
+
 void UMKHDamageAbility::PreActivate(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
 	const FGameplayAbilityActivationInfo ActivationInfo,FOnGameplayAbilityEnded::FDelegate* OnGameplayAbilityEndedDelegate, 
 	const FGameplayEventData* TriggerEventData)
@@ -129,14 +272,6 @@ void UMKHDamageAbility::PreActivate(const FGameplayAbilitySpecHandle Handle, con
 void UMKHDamageAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
 {
 	Super::OnGiveAbility(ActorInfo, Spec);
-	
-	// Settings the config value from GAS.GrantsAbility() to the specific instance (previously was set only the CDO)
-	if(const UMKHDamageAbility* CDO = Cast<UMKHDamageAbility>(Spec.Ability))
-	{
-		SetDamagePercent(CDO->DamagePercent);
-		SetIsSkillAbility(CDO->bIsSkillAbility);
-		SetCooldownData(CDO->CooldownTime, CDO->CooldownTagContainer);
-	}
 
 	AssignBPClasses(ActorInfo);
 }
@@ -170,9 +305,115 @@ void UMKHDamageAbility::ApplyCooldown(const FGameplayAbilitySpecHandle Handle,
 
 const FGameplayTagContainer* UMKHDamageAbility::GetCooldownTags() const
 {
+	if (const FMKHAbilityGrantConfig* Config = GetGrantConfig())
+	{
+		return &Config->CooldownTags;
+	}
 	return &CooldownTagContainer;
 }
 
+#if WITH_EDITOR
+void UMKHDamageAbility::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// Blueprint defaults live on the class default object; re-bake it on every save, cooks included.
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		TArray<FString> Errors;
+		if (!BakeCombatTimeline(Errors))
+		{
+			for (const FString& Error : Errors)
+			{
+				UE_LOG(LogTemp, Error, TEXT("UMKHDamageAbility::PreSave - %s"), *Error);
+			}
+		}
+	}
+}
+
+bool UMKHDamageAbility::BakeCombatTimeline(TArray<FString>& OutErrors)
+{
+	using namespace DamageAbilityTimeline;
+
+	FMKHCombatTimeline Baked;
+	if (!IsValid(AttackMontageToPlay))
+	{
+		CombatTimeline = Baked;
+		return true;
+	}
+
+	Baked.SourceMontage = AttackMontageToPlay;
+	Baked.NotifyHash = FMKHCombatTimeline::HashNotifies(AttackMontageToPlay);
+
+	auto AddEvent = [&Baked](const FGameplayTag& EventTag, float Time)
+	{
+		FMKHCombatTimelineEvent& Event = Baked.Events.AddDefaulted_GetRef();
+		Event.EventTag = EventTag;
+		Event.Time = Time;
+	};
+
+	for (const FAnimNotifyEvent& NotifyEvent : AttackMontageToPlay->Notifies)
+	{
+		FGameplayTag StartTag;
+		FGameplayTag EndTag;
+		if (ResolveWindowTags(NotifyEvent, StartTag, EndTag))
+		{
+			AddEvent(StartTag, NotifyEvent.GetTriggerTime());
+			AddEvent(EndTag, NotifyEvent.GetEndTriggerTime());
+			continue;
+		}
+
+		const FGameplayTag EventTag = ResolveEventTag(NotifyEvent);
+		if (EventTag.IsValid())
+		{
+			AddEvent(EventTag, NotifyEvent.GetTriggerTime());
+		}
+	}
+
+	Baked.Events.StableSort([](const FMKHCombatTimelineEvent& A, const FMKHCombatTimelineEvent& B)
+	{
+		return A.Time < B.Time;
+	});
+
+	// Without events the server would never scan or spawn, since it ignores the montage's own notifies on the timeline
+	const int32 NumErrorsBefore = OutErrors.Num();
+	if (Baked.Events.IsEmpty())
+	{
+		OutErrors.Add(FString::Printf(TEXT("%s: %s has no combat event notifies"), *GetName(), *AttackMontageToPlay->GetName()));
+	}
+
+	// Every window must close after it opens, or the server would keep scanning (or buffering combo input) to the end
+	auto CheckWindows = [&](const FGameplayTag& OpenTag, const FGameplayTag& CloseTag)
+	{
+		int32 NumOpen = 0;
+		for (const FMKHCombatTimelineEvent& Event : Baked.Events)
+		{
+			NumOpen += Event.EventTag == OpenTag ? 1 : Event.EventTag == CloseTag ? -1 : 0;
+			if (NumOpen < 0 || NumOpen > 1)
+			{
+				break;
+			}
+		}
+		if (NumOpen != 0)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s: %s and %s of %s do not pair up"),
+				*GetName(), *OpenTag.ToString(), *CloseTag.ToString(), *AttackMontageToPlay->GetName()));
+		}
+	};
+	CheckWindows(MKHGameplayTags::Event::HitScanStart, MKHGameplayTags::Event::HitScanEnd);
+	CheckWindows(MKHGameplayTags::Event::ContinueComboStart, MKHGameplayTags::Event::ContinueComboEnd);
+
+	if (OutErrors.Num() != NumErrorsBefore)
+	{
+		CombatTimeline = FMKHCombatTimeline();
+		return false;
+	}
+
+	CombatTimeline = MoveTemp(Baked);
+	return true;
+}
+#endif
+
 void UMKHDamageAbility::OnMontageStarted_Implementation()
 {
 	// Does Nothing; To be Overriden
@@ -2,9 +2,10 @@
 
 
 #include "AbilitySystem/Abilities/MKHGameplayAbility.h"
-#include "Abilities/Tasks/AbilityTask_WaitInputPress.h"
-#include "Abilities/Tasks/AbilityTask_WaitInputRelease.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystem/MKHAbilitySystemComponent.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "Combat/AbilityLatencySubsystem.h"
 #include "Player/MKHPlayerCharacter.h"
 
 UMKHGameplayAbility::UMKHGameplayAbility()
@@ -16,12 +17,10 @@ UMKHGameplayAbility::UMKHGameplayAbility()
 
 void UMKHGameplayAbility::OnAbilityActivatedAgain_Implementation(float TimeWaited)
 {
-	BindInputPressEvent();
 }
 
 void UMKHGameplayAbility::OnAbilityReleased_Implementation(float TimeWaited)
 {
-	BindInputReleaseEvent();
 }
 
 void UMKHGameplayAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
@@ -30,19 +29,72 @@ void UMKHGameplayAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handl
 {
 	Super::ActivateAbility(Handle, ActorInfo, ActivationInfo, TriggerEventData);
 	
-	BindInputPressEvent();
-	BindInputReleaseEvent();
+	UAbilityLatencySubsystem::MarkActivated(this, ActivationInfo);
+	ApplyGrantConfigToInstance();
+
+	ConsumeInputTimeWaited();
+	BindRemoteInputEvents();
 		
 	CommitAbility(Handle, ActorInfo, ActivationInfo);
 }
 
+void UMKHGameplayAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled)
+{
+	UnbindRemoteInputEvents();
+	UAbilityLatencySubsystem::EndTimeline(this);
+	
+	Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+}
+
+void UMKHGameplayAbility::InputPressed(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	const FGameplayAbilityActivationInfo ActivationInfo)
+{
+	Super::InputPressed(Handle, ActorInfo, ActivationInfo);
+	
+	OnAbilityActivatedAgain(ConsumeInputTimeWaited());
+}
+
+void UMKHGameplayAbility::InputReleased(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	const FGameplayAbilityActivationInfo ActivationInfo)
+{
+	Super::InputReleased(Handle, ActorInfo, ActivationInfo);
+	
+	OnAbilityReleased(ConsumeInputTimeWaited());
+}
+
 void UMKHGameplayAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
 {
 	Super::OnGiveAbility(ActorInfo, Spec);
 	
-	if (const UMKHGameplayAbility* CDO = Cast<UMKHGameplayAbility>(Spec.Ability))
+	ApplyGrantConfigToInstance();
+}
+
+const FMKHAbilityGrantConfig* UMKHGameplayAbility::GetGrantConfig() const
+{
+	const UMKHAbilitySystemComponent* ASC = Cast<UMKHAbilitySystemComponent>(GetAbilitySystemComponentFromActorInfo());
+	return ASC ? ASC->FindAbilityGrantConfig(GetCurrentAbilitySpecHandle()) : nullptr;
+}
+
+void UMKHGameplayAbility::ApplyGrantConfigToInstance()
+{
+	// Non-instanced abilities run on the class default object, which every grant shares.
+	if (!IsInstantiated())
+	{
+		return;
+	}
+	
+	if (const FMKHAbilityGrantConfig* Config = GetGrantConfig())
+	{
+		ApplyGrantConfig(*Config);
+	}
+}
+
+void UMKHGameplayAbility::ApplyGrantConfig(const FMKHAbilityGrantConfig& Config)
+{
+	if (Config.InputTag.IsValid())
 	{
-		InputTag = CDO->InputTag;
+		InputTag = Config.InputTag;
 	}
 }
 
@@ -66,24 +118,81 @@ void UMKHGameplayAbility::SetCharacterOrientation(bool bFollowCamera)
 	}
 }
 
-void UMKHGameplayAbility::BindInputPressEvent()
+void UMKHGameplayAbility::BindRemoteInputEvents()
 {
-	UAbilityTask_WaitInputPress* InputPressEvent = UAbilityTask_WaitInputPress::WaitInputPress(this);
+	const FGameplayAbilityActorInfo* ActorInfo = GetCurrentActorInfo();
+	UAbilitySystemComponent* ASC = GetAbilitySystemComponentFromActorInfo();
+	if (!ActorInfo || !IsValid(ASC) || !ActorInfo->IsNetAuthority() || ActorInfo->IsLocallyControlled())
+	{
+		return;
+	}
+	
+	const FPredictionKey ActivationKey = GetCurrentActivationInfo().GetActivationPredictionKey();
+	
+	RemoteInputPressedHandle = ASC->AbilityReplicatedEventDelegate(EAbilityGenericReplicatedEvent::InputPressed, GetCurrentAbilitySpecHandle(), ActivationKey)
+		.AddUObject(this, &UMKHGameplayAbility::OnRemoteInputPressed);
+	RemoteInputReleasedHandle = ASC->AbilityReplicatedEventDelegate(EAbilityGenericReplicatedEvent::InputReleased, GetCurrentAbilitySpecHandle(), ActivationKey)
+		.AddUObject(this, &UMKHGameplayAbility::OnRemoteInputReleased);
+}
+
+void UMKHGameplayAbility::UnbindRemoteInputEvents()
+{
+	UAbilitySystemComponent* ASC = GetAbilitySystemComponentFromActorInfo();
+	if (!IsValid(ASC))
+	{
+		return;
+	}
+	
+	const FPredictionKey ActivationKey = GetCurrentActivationInfo().GetActivationPredictionKey();
+	
+	if (RemoteInputPressedHandle.IsValid())
+	{
+		ASC->AbilityReplicatedEventDelegate(EAbilityGenericReplicatedEvent::InputPressed, GetCurrentAbilitySpecHandle(), ActivationKey)
+			.Remove(RemoteInputPressedHandle);
+		RemoteInputPressedHandle.Reset();
+	}
 	
-	if (IsValid(InputPressEvent))
+	if (RemoteInputReleasedHandle.IsValid())
 	{
-		InputPressEvent->OnPress.AddDynamic(this, &UMKHGameplayAbility::OnAbilityActivatedAgain);
-		InputPressEvent->ReadyForActivation();
+		ASC->AbilityReplicatedEventDelegate(EAbilityGenericReplicatedEvent::InputReleased, GetCurrentAbilitySpecHandle(), ActivationKey)
+			.Remove(RemoteInputReleasedHandle);
+		RemoteInputReleasedHandle.Reset();
 	}
 }
 
-void UMKHGameplayAbility::BindInputReleaseEvent()
+void UMKHGameplayAbility::OnRemoteInputPressed()
 {
-	UAbilityTask_WaitInputRelease* InputReleaseEvent = UAbilityTask_WaitInputRelease::WaitInputRelease(this);
+	if (UAbilitySystemComponent* ASC = GetAbilitySystemComponentFromActorInfo(); IsValid(ASC))
+	{
+		ASC->ConsumeGenericReplicatedEvent(EAbilityGenericReplicatedEvent::InputPressed, GetCurrentAbilitySpecHandle(),
+			GetCurrentActivationInfo().GetActivationPredictionKey());
+	}
 	
-	if (IsValid(InputReleaseEvent))
+	InputPressed(GetCurrentAbilitySpecHandle(), GetCurrentActorInfo(), GetCurrentActivationInfo());
+}
+
+void UMKHGameplayAbility::OnRemoteInputReleased()
+{
+	if (UAbilitySystemComponent* ASC = GetAbilitySystemComponentFromActorInfo(); IsValid(ASC))
 	{
-		InputReleaseEvent->OnRelease.AddDynamic(this, &UMKHGameplayAbility::OnAbilityReleased);
-		InputReleaseEvent->ReadyForActivation();
+		ASC->ConsumeGenericReplicatedEvent(EAbilityGenericReplicatedEvent::InputReleased, GetCurrentAbilitySpecHandle(),
+			GetCurrentActivationInfo().GetActivationPredictionKey());
 	}
+	
+	InputReleased(GetCurrentAbilitySpecHandle(), GetCurrentActorInfo(), GetCurrentActivationInfo());
+}
+
+float UMKHGameplayAbility::ConsumeInputTimeWaited()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 0.f;
+	}
+	
+	const double Now = World->GetTimeSeconds();
+	const float TimeWaited = static_cast<float>(Now - LastInputTime);
+	LastInputTime = Now;
+	
+	return TimeWaited;
 }
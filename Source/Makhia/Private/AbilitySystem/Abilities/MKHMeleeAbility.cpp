@@ -4,7 +4,9 @@
 #include "AbilitySystem/Abilities/MKHMeleeAbility.h"
 
 #include "Abilities/Tasks/AbilityTask_WaitGameplayEvent.h"
+#include "AbilitySystem/MKHAbilitySystemComponent.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "Combat/AbilityLatencySubsystem.h"
 #include "Equipment/Weapon/MKHWeaponBase.h"
 
 void UMKHMeleeAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
@@ -17,6 +19,11 @@ void UMKHMeleeAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
 	{
 		BindHitScanEvents();
 	}
+	else if (UMKHAbilitySystemComponent* ASC = Cast<UMKHAbilitySystemComponent>(GetAbilitySystemComponentFromActorInfo()))
+	{
+		// Lets the server rewind targets to what this client sees when the hit scans run
+		ASC->ReportClientViewTime();
+	}
 }
 
 void UMKHMeleeAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
@@ -24,7 +31,8 @@ void UMKHMeleeAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const
 {
 	Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
 	
-	OnHitScanEndReceived(FGameplayEventData());
+	bHitScanHoldsPose = false;
+	HitScanEnd();
 }
 
 void UMKHMeleeAbility::OnMontageStarted_Implementation()
@@ -125,22 +133,55 @@ void UMKHMeleeAbility::BindOnContinueComboEvents()
 
 void UMKHMeleeAbility::OnHitScanStartReceived(FGameplayEventData Payload)
 {
+	if (!AcceptsCombatEvent(Payload))
+	{
+		return;
+	}
+
+	if (!bHitScanHoldsPose)
+	{
+		AcquireServerPose();
+		bHitScanHoldsPose = true;
+	}
+
+	UAbilityLatencySubsystem::MarkStage(this, EAbilityLatencyStage::HitScanStart);
 	HitScanStart();
 }
 
 void UMKHMeleeAbility::OnHitScanEndReceived(FGameplayEventData Payload)
 {
+	if (!AcceptsCombatEvent(Payload))
+	{
+		return;
+	}
+
 	HitScanEnd();
+
+	if (bHitScanHoldsPose)
+	{
+		ReleaseServerPose();
+		bHitScanHoldsPose = false;
+	}
 }
 
 void UMKHMeleeAbility::OnContinueComboStartReceived(FGameplayEventData Payload)
 {
+	if (!AcceptsCombatEvent(Payload))
+	{
+		return;
+	}
+
 	bIsWithinComboWindow = true;
 	bContinueCombo = false;
 }
 
 void UMKHMeleeAbility::OnContinueComboEndReceived(FGameplayEventData Payload)
 {
+	if (!AcceptsCombatEvent(Payload))
+	{
+		return;
+	}
+
 	bIsWithinComboWindow = false;
 	if (bContinueCombo)
 	{
@@ -6,10 +6,24 @@
 #include "Abilities/Tasks/AbilityTask_WaitGameplayEvent.h"
 #include "Abilities/Tasks/AbilityTask_SpawnActor.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "Character/CharacterBase.h"
 #include "Projectiles/MKHProjectileBase.h"
 #include "Data/ProjectileInfo.h"
 #include "Equipment/Weapon/MKHWeaponBase.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
 #include "Libraries/MKHAbilitySystemLibrary.h"
+#include "Projectiles/ProjectilePredictionSubsystem.h"
+#include "Projectiles/ProjectileSimulationSubsystem.h"
+
+namespace ProjectileAbility
+{
+	float MaxCatchUpMs = 200.f;
+	FAutoConsoleVariableRef CVarMaxCatchUpMs(
+		TEXT("Makhia.Combat.ProjectileMaxCatchUpMs"),
+		MaxCatchUpMs,
+		TEXT("Longest the server advances a remote shooter's new projectile to meet its predicted copy. 0 disables catching up."));
+}
 
 void UMKHProjectileAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
 	const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo,
@@ -17,6 +31,8 @@ void UMKHProjectileAbility::ActivateAbility(const FGameplayAbilitySpecHandle Han
 {
 	Super::ActivateAbility(Handle, ActorInfo, ActivationInfo, TriggerEventData);
 	
+	NumShots = 0;
+	bBoundPredictionRejected = false;
 	BindSpawnProjectileEvent();
 	
 }
@@ -24,36 +40,65 @@ void UMKHProjectileAbility::ActivateAbility(const FGameplayAbilitySpecHandle Han
 void UMKHProjectileAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
 {
 	Super::OnGiveAbility(ActorInfo, Spec);
+	
+	AvatarActorFromInfo = GetAvatarActorFromActorInfo();
+}
 
-	// If primary instance (instanced per actor) it doesn't have the tag set in GrantAbility
-	// because CDO does , so we get the tag from CDO to set it in this instance
-	if (const UMKHProjectileAbility* CDO = Cast<UMKHProjectileAbility>(Spec.Ability))
+void UMKHProjectileAbility::ApplyGrantConfig(const FMKHAbilityGrantConfig& Config)
+{
+	Super::ApplyGrantConfig(Config);
+
+	if (!Config.ContextTag.IsValid() || (Config.ContextTag == ProjectileToSpawnTag && IsValid(CurrentProjectileParams.ProjectileClass)))
 	{
-		ProjectileToSpawnTag = CDO->ProjectileToSpawnTag;
+		return;
 	}
-	
-	AvatarActorFromInfo = GetAvatarActorFromActorInfo();
-	if (!ProjectileToSpawnTag.IsValid() || !IsValid(AvatarActorFromInfo)) return;
 
-	if (UProjectileInfo* ProjectileInfo = UMKHAbilitySystemLibrary::GetProjectileInfo(AvatarActorFromInfo))
+	ProjectileToSpawnTag = Config.ContextTag;
+	if (UProjectileInfo* ProjectileInfo = UMKHAbilitySystemLibrary::GetProjectileInfo(GetAvatarActorFromActorInfo()))
 	{
-		CurrentProjectileParams = *ProjectileInfo->ProjectileInfoMap.Find(ProjectileToSpawnTag);
+		if (const FProjectileParams* Params = ProjectileInfo->ProjectileInfoMap.Find(ProjectileToSpawnTag))
+		{
+			CurrentProjectileParams = *Params;
+		}
 	}
 }
 
 void UMKHProjectileAbility::SpawnProjectile(const FVector& TargetLocation)
 {
-	if (!IsValid(CurrentProjectileParams.ProjectileClass)) return;
+	if (!CurrentProjectileParams.bSimulated && !IsValid(CurrentProjectileParams.ProjectileClass)) return;
 	if (!IsValid(AvatarActorFromInfo)) return;
 
+	const bool bAuthority = HasAuthority(&CurrentActivationInfo);
+	if (!bAuthority && !IsPredictingClient()) return;
+
+	// The spawn point follows a weapon socket, which dedicated servers do not update every frame
+	if (ACharacterBase* Character = Cast<ACharacterBase>(AvatarActorFromInfo))
+	{
+		Character->RefreshServerPose();
+	}
+
 	const FVector SpawnPoint = GetSpawnLocation();
 	const FRotator TargetRotation = (TargetLocation - SpawnPoint).Rotation();
 
+	if (CurrentProjectileParams.bSimulated)
+	{
+		// No predicted stand-in: every machine flies the server's volley from its spawn time
+		if (bAuthority)
+		{
+			SpawnSimulatedProjectile(SpawnPoint, TargetRotation.Vector());
+		}
+		return;
+	}
+
 	FTransform SpawnTransform;
 	SpawnTransform.SetLocation(SpawnPoint);
 	SpawnTransform.SetRotation(TargetRotation.Quaternion());
 
-	SpawnedProjectile = GetWorld()->SpawnActorDeferred<AMKHProjectileBase>(
+	FMKHProjectileShotId ShotId;
+	ShotId.PredictionKey = CurrentActivationInfo.GetActivationPredictionKey().Current;
+	ShotId.ShotIndex = NumShots++;
+
+	AMKHProjectileBase* Projectile = GetWorld()->SpawnActorDeferred<AMKHProjectileBase>(
 		CurrentProjectileParams.ProjectileClass, 
 		SpawnTransform, 
 		AvatarActorFromInfo, 
@@ -61,20 +106,64 @@ void UMKHProjectileAbility::SpawnProjectile(const FVector& TargetLocation)
 		ESpawnActorCollisionHandlingMethod::AlwaysSpawn
 	);
 
-	if (IsValid(SpawnedProjectile))
+	if (!IsValid(Projectile))
+	{
+		return;
+	}
+
+	Projectile->SetProjectileParams(CurrentProjectileParams);
+
+	if (!bAuthority)
 	{
-		SpawnedProjectile->SetProjectileParams(CurrentProjectileParams);
+		// Cosmetic stand-in; damage and the ability's projectile reference stay with the server's projectile
+		Projectile->InitPredicted(ShotId);
+		Projectile->FinishSpawning(SpawnTransform);
+
+		if (UProjectilePredictionSubsystem* Prediction = UWorld::GetSubsystem<UProjectilePredictionSubsystem>(GetWorld()))
+		{
+			Prediction->AddPrediction(ShotId, Projectile);
+
+			if (!bBoundPredictionRejected)
+			{
+				bBoundPredictionRejected = true;
+				const int16 PredictionKey = ShotId.PredictionKey;
+				FPredictionKey ActivationKey = CurrentActivationInfo.GetActivationPredictionKey();
+				ActivationKey.NewRejectedDelegate().BindWeakLambda(Prediction, [Prediction, PredictionKey]()
+				{
+					Prediction->CullPredictions(PredictionKey);
+				});
+			}
+		}
+		return;
+	}
+
+	SpawnedProjectile = Projectile;
 
-		FDamageEffectInfo DamageEffectInfo;
-		CaptureDamageEffectInfo(nullptr, DamageEffectInfo);
+	FDamageEffectInfo DamageEffectInfo;
+	CaptureDamageEffectInfo(nullptr, DamageEffectInfo);
 
-		SpawnedProjectile->DamageEffectInfo = DamageEffectInfo;
+	SpawnedProjectile->DamageEffectInfo = DamageEffectInfo;
+	SpawnedProjectile->SetShotId(ShotId);
+
+	// Bind Destruction Event
+	SpawnedProjectile->OnDestroyed.AddDynamic(this, &UMKHProjectileAbility::OnProjectileDestroyed);
+	
+	SpawnedProjectile->FinishSpawning(SpawnTransform);
+	SpawnedProjectile->CatchUp(GetCatchUpTime());
+}
 
-		// Bind Destruction Event
-		SpawnedProjectile->OnDestroyed.AddDynamic(this, &UMKHProjectileAbility::OnProjectileDestroyed);
-		
-		SpawnedProjectile->FinishSpawning(SpawnTransform);
+void UMKHProjectileAbility::SpawnSimulatedProjectile(const FVector& SpawnPoint, const FVector& Direction)
+{
+	UProjectileSimulationSubsystem* Simulation = UWorld::GetSubsystem<UProjectileSimulationSubsystem>(GetWorld());
+	if (!Simulation)
+	{
+		return;
 	}
+
+	FDamageEffectInfo DamageEffectInfo;
+	CaptureDamageEffectInfo(nullptr, DamageEffectInfo);
+
+	Simulation->SpawnVolley(ProjectileToSpawnTag, SpawnPoint, { Direction }, AvatarActorFromInfo, DamageEffectInfo);
 }
 
 void UMKHProjectileAbility::BindSpawnProjectileEvent()
@@ -86,11 +175,31 @@ void UMKHProjectileAbility::BindSpawnProjectileEvent()
 	
 	if (IsValid(SpawnProjectileEvent))
 	{
-		SpawnProjectileEvent->EventReceived.AddDynamic(this, &UMKHProjectileAbility::OnSpawnProjectileEvent);
+		SpawnProjectileEvent->EventReceived.AddDynamic(this, &UMKHProjectileAbility::OnSpawnProjectileEventReceived);
 		SpawnProjectileEvent->ReadyForActivation();
 	}
 }
 
+void UMKHProjectileAbility::OnSpawnProjectileEventReceived(FGameplayEventData Payload)
+{
+	if (AcceptsCombatEvent(Payload))
+	{
+		OnSpawnProjectileEvent(Payload);
+	}
+}
+
+float UMKHProjectileAbility::GetCatchUpTime() const
+{
+	const APawn* Pawn = Cast<APawn>(AvatarActorFromInfo);
+	if (!Pawn || Pawn->IsLocallyControlled() || !CurrentActivationInfo.GetActivationPredictionKey().IsValidKey())
+	{
+		return 0.f;
+	}
+
+	const APlayerState* PlayerState = Pawn->GetPlayerState();
+	return PlayerState ? FMath::Min(PlayerState->GetPingInMilliseconds() * 0.5f, ProjectileAbility::MaxCatchUpMs) * 0.001f : 0.f;
+}
+
 FVector UMKHProjectileAbility::GetSpawnLocation() const
 {
 	if (IsValid(OwningWeapon))
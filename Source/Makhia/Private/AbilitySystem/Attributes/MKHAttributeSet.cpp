@@ -4,20 +4,35 @@
 #include "AbilitySystem/Attributes/MKHAttributeSet.h"
 #include "Net/UnrealNetwork.h"
 #include "GameplayEffectExtension.h"
+#include "Abilities/GameplayAbility.h"
 #include "AbilitySystem/MKHAbilityTypes.h"
+#include "AbilitySystem/MKHGameplayTags.h"
+#include "Combat/CombatHitNotifySubsystem.h"
+#include "Combat/CombatTelemetry.h"
+#include "AbilitySystemInterface.h"
+#include "EngineUtils.h"
+#include "GameplayEffect.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
 
 void UMKHAttributeSet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Health, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxHealth, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Stamina, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxStamina, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, DodgeStaminaCost, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Shield, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxShield, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, CritChance, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, CritDamageMod, COND_None, REPNOTIFY_Always);
+
+	// Public: every client draws health and shield bars. Only the server changes them (no client prediction),
+	// so an unchanged value never needs a notify to undo a predicted one.
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Health, COND_None, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxHealth, COND_None, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Shield, COND_None, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxShield, COND_None, REPNOTIFY_OnChanged);
+
+	// Private: only the owning client reads them. Stamina is spent by predicted dodges, so it keeps
+	// REPNOTIFY_Always to roll the prediction back even when the server lands on the same value.
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, Stamina, COND_OwnerOnly, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, MaxStamina, COND_OwnerOnly, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, DodgeStaminaCost, COND_OwnerOnly, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, CritChance, COND_OwnerOnly, REPNOTIFY_OnChanged);
+	DOREPLIFETIME_CONDITION_NOTIFY(UMKHAttributeSet, CritDamageMod, COND_OwnerOnly, REPNOTIFY_OnChanged);
 }
 
 void UMKHAttributeSet::PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue)
@@ -94,7 +109,7 @@ void UMKHAttributeSet::AdjustAttributeForMaxChange(
 	const float Ratio = CurrentValue / OldMaxValue;
 	const float NewCurrentValue = FMath::RoundToFloat(Ratio * NewMaxValue);
 
-	ASC->ApplyModToAttribute(AffectedAttribute, EGameplayModOp::Override, NewCurrentValue);
+	ASC->SetNumericAttributeBase(AffectedAttribute, NewCurrentValue);
 }
 
 // â”€â”€â”€ Shield Absorption Tuning â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
@@ -120,6 +135,127 @@ static constexpr float ShieldAbsorption_ReferenceShield = 100.f;  // Shield valu
 // â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
 static constexpr float ShieldBreak_DamageMultiplier = 2.f;
 
+namespace DamageBench
+{
+	/**
+	 * Makhia.Combat.DamageBench [NumEvents=100000] [Damage=5]
+	 * Applies NumEvents damage events to the first character with a Makhia attribute set (server only), once through
+	 * the single-pass resolution and once through the old pair of ApplyModToAttribute calls, and logs events per
+	 * second per target for both. Shield and Health are refilled whenever the target would die and restored at the end.
+	 * Finally checks that hits taken under an active Shield modifier only remove the damage from the base value.
+	 */
+	void CheckBaseUnderModifier(UAbilitySystemComponent* ASC, UMKHAttributeSet* AttributeSet, float Damage)
+	{
+		constexpr float ShieldBonus = 50.f;
+		constexpr int32 NumHits = 10;
+		const FGameplayAttribute ShieldAttribute = UMKHAttributeSet::GetShieldAttribute();
+
+		UGameplayEffect* ShieldBuff = NewObject<UGameplayEffect>(GetTransientPackage());
+		ShieldBuff->DurationPolicy = EGameplayEffectDurationType::Infinite;
+		FGameplayModifierInfo& Modifier = ShieldBuff->Modifiers.AddDefaulted_GetRef();
+		Modifier.Attribute = ShieldAttribute;
+		Modifier.ModifierOp = EGameplayModOp::Additive;
+		Modifier.ModifierMagnitude = FScalableFloat(ShieldBonus);
+
+		ASC->SetNumericAttributeBase(ShieldAttribute, FMath::Max(AttributeSet->GetMaxShield() - ShieldBonus, 0.f));
+		ASC->SetNumericAttributeBase(UMKHAttributeSet::GetHealthAttribute(), AttributeSet->GetMaxHealth());
+		const FActiveGameplayEffectHandle BuffHandle = ASC->ApplyGameplayEffectToSelf(ShieldBuff, 1.f, ASC->MakeEffectContext());
+		const float BaseBefore = ASC->GetNumericAttributeBase(ShieldAttribute);
+
+		float ShieldDamage = 0.f;
+		for (int32 i = 0; i < NumHits && AttributeSet->GetHealth() > Damage; ++i)
+		{
+			const FMKHDamageResolution Resolution = AttributeSet->ApplyResolvedDamage(Damage);
+			ShieldDamage += Resolution.OldShield - Resolution.NewShield;
+		}
+
+		const float BaseAfter = ASC->GetNumericAttributeBase(ShieldAttribute);
+		ASC->RemoveActiveGameplayEffect(BuffHandle);
+
+		if (FMath::IsNearlyEqual(BaseAfter, BaseBefore - ShieldDamage, 0.01f))
+		{
+			UE_LOG(LogTemp, Display, TEXT("Damage bench: Shield base %.1f -> %.1f under a +%.0f modifier, only the %.1f shield damage removed"),
+				BaseBefore, BaseAfter, ShieldBonus, ShieldDamage);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("Damage bench: Shield base %.1f -> %.1f under a +%.0f modifier, expected %.1f after %.1f shield damage"),
+				BaseBefore, BaseAfter, ShieldBonus, BaseBefore - ShieldDamage, ShieldDamage);
+		}
+	}
+
+	void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		UMKHAttributeSet* AttributeSet = nullptr;
+		UAbilitySystemComponent* ASC = nullptr;
+		for (TActorIterator<APawn> It(World); It && !AttributeSet; ++It)
+		{
+			if (IAbilitySystemInterface* AbilityInterface = Cast<IAbilitySystemInterface>(*It))
+			{
+				ASC = AbilityInterface->GetAbilitySystemComponent();
+				AttributeSet = ASC ? const_cast<UMKHAttributeSet*>(ASC->GetSet<UMKHAttributeSet>()) : nullptr;
+			}
+		}
+		if (!AttributeSet || !ASC->IsOwnerActorAuthoritative())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Makhia.Combat.DamageBench needs a server world with a character owning a UMKHAttributeSet."));
+			return;
+		}
+
+		const int32 NumEvents = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		const float Damage = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 0.01f) : 5.f;
+		const float SavedShield = AttributeSet->GetShield();
+		const float SavedHealth = AttributeSet->GetHealth();
+
+		const auto Refill = [&]()
+		{
+			ASC->SetNumericAttributeBase(UMKHAttributeSet::GetShieldAttribute(), AttributeSet->GetMaxShield());
+			ASC->SetNumericAttributeBase(UMKHAttributeSet::GetHealthAttribute(), AttributeSet->GetMaxHealth());
+		};
+
+		Refill();
+		double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumEvents; ++i)
+		{
+			if (AttributeSet->GetHealth() <= Damage)
+			{
+				Refill();
+			}
+			AttributeSet->ApplyResolvedDamage(Damage);
+		}
+		const double SinglePassSeconds = FPlatformTime::Seconds() - Start;
+
+		Refill();
+		Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumEvents; ++i)
+		{
+			if (AttributeSet->GetHealth() <= Damage)
+			{
+				Refill();
+			}
+			const FMKHDamageResolution Resolution = UMKHAttributeSet::ResolveDamage(Damage, AttributeSet->GetShield(), AttributeSet->GetHealth());
+			ASC->ApplyModToAttribute(UMKHAttributeSet::GetShieldAttribute(), EGameplayModOp::Additive, Resolution.NewShield - Resolution.OldShield);
+			ASC->ApplyModToAttribute(UMKHAttributeSet::GetHealthAttribute(), EGameplayModOp::Additive, Resolution.NewHealth - Resolution.OldHealth);
+		}
+		const double TwoModSeconds = FPlatformTime::Seconds() - Start;
+
+		CheckBaseUnderModifier(ASC, AttributeSet, Damage);
+
+		ASC->SetNumericAttributeBase(UMKHAttributeSet::GetShieldAttribute(), SavedShield);
+		ASC->SetNumericAttributeBase(UMKHAttributeSet::GetHealthAttribute(), SavedHealth);
+
+		UE_LOG(LogTemp, Display, TEXT("Damage bench on %s, %d events of %.1f damage: single pass %.0f events/s (%.2f us), ApplyModToAttribute x2 %.0f events/s (%.2f us)"),
+			*GetNameSafe(ASC->GetAvatarActor()), NumEvents, Damage,
+			NumEvents / FMath::Max(SinglePassSeconds, UE_DOUBLE_SMALL_NUMBER), SinglePassSeconds * 1e6 / NumEvents,
+			NumEvents / FMath::Max(TwoModSeconds, UE_DOUBLE_SMALL_NUMBER), TwoModSeconds * 1e6 / NumEvents);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs Command(
+		TEXT("Makhia.Combat.DamageBench"),
+		TEXT("Makhia.Combat.DamageBench [NumEvents] [Damage]: measures damage events per second per target."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
 float UMKHAttributeSet::CalculateShieldAbsorption(const float CurrentShield)
 {
 	if (CurrentShield <= 0.f)
@@ -145,7 +281,7 @@ float UMKHAttributeSet::CalculateShieldAbsorption(const float CurrentShield)
 
 void UMKHAttributeSet::HandleIncomingDamage(const FGameplayEffectModCallbackData& Data)
 {
-	float LocalDamage = GetIncomingDamage();
+	const float LocalDamage = GetIncomingDamage();
 	SetIncomingDamage(0.f);
 
 	if (LocalDamage <= 0.f)
@@ -153,13 +289,33 @@ void UMKHAttributeSet::HandleIncomingDamage(const FGameplayEffectModCallbackData
 		return;
 	}
 
-	UAbilitySystemComponent* ASC = GetOwningAbilitySystemComponent();
-	if (!IsValid(ASC))
+	if (!IsValid(GetOwningAbilitySystemComponent()))
 	{
 		return;
 	}
 
-	const float CurrentShield = GetShield();
+	const FMKHDamageResolution Resolution = ApplyResolvedDamage(LocalDamage);
+
+	if (UCombatHitNotifySubsystem* HitNotifies = UWorld::GetSubsystem<UCombatHitNotifySubsystem>(GetWorld()))
+	{
+		const FMKHGameplayEffectContext* RPGContext = FMKHGameplayEffectContext::GetEffectContext(Data.EffectSpec.GetContext());
+		HitNotifies->QueueHit(GetOwningAbilitySystemComponent()->GetAvatarActor(), Resolution, RPGContext && RPGContext->IsCriticalHit());
+	}
+
+	if (FCombatTelemetry::IsEnabled())
+	{
+		RecordDamageTelemetry(Data, Resolution);
+	}
+}
+
+FMKHDamageResolution UMKHAttributeSet::ResolveDamage(const float Damage, const float CurrentShield, const float CurrentHealth)
+{
+	FMKHDamageResolution Resolution;
+	Resolution.Damage = Damage;
+	Resolution.OldShield = CurrentShield;
+	Resolution.OldHealth = CurrentHealth;
+
+	float HealthDamage = Damage;
 
 	if (CurrentShield > 0.f)
 	{
@@ -167,48 +323,70 @@ void UMKHAttributeSet::HandleIncomingDamage(const FGameplayEffectModCallbackData
 		* If damage exceeds (Shield * Multiplier) the shield shatters completely.
 		* All damage beyond the shield value flows through to Health unmitigated.
 		*/
-		if (LocalDamage >= CurrentShield * ShieldBreak_DamageMultiplier)
+		if (Damage >= CurrentShield * ShieldBreak_DamageMultiplier)
 		{
-			ApplyShieldBreak(ASC, LocalDamage, CurrentShield);
+			Resolution.bShieldBroken = true;
+			Resolution.NewShield = 0.f;
+			HealthDamage = Damage - CurrentShield;
 		}
 		else
 		{
-			ApplyShieldDamageMitigation(ASC, LocalDamage, CurrentShield);
+			// The shield absorbs a percentage of the damage; the rest hits Health.
+			const float ShieldDamage = FMath::RoundToFloat(Damage * CalculateShieldAbsorption(CurrentShield));
+			Resolution.NewShield = FMath::Max(CurrentShield - ShieldDamage, 0.f);
+			HealthDamage = Damage - ShieldDamage;
 		}
 	}
-	else
-	{
-		// No shield: all damage goes directly to Health
-		ASC->ApplyModToAttribute(GetHealthAttribute(), EGameplayModOp::Additive, -LocalDamage);
-	}
+
+	// No shield: all damage goes directly to Health
+	Resolution.NewHealth = FMath::Max(CurrentHealth - FMath::Max(HealthDamage, 0.f), 0.f);
+	return Resolution;
 }
 
-void UMKHAttributeSet::ApplyShieldBreak(UAbilitySystemComponent* ASC, float Damage, float CurrentShield) const
+FMKHDamageResolution UMKHAttributeSet::ApplyResolvedDamage(const float Damage)
 {
-	if (!IsValid(ASC)) return;
-
-	// Destroy the full shield
-	ASC->ApplyModToAttribute(GetShieldAttribute(), EGameplayModOp::Additive, -CurrentShield);
+	const FMKHDamageResolution Resolution = ResolveDamage(Damage, GetShield(), GetHealth());
 
-	// Only the surplus damage (beyond the shield value) hits Health
-	const float HealthDamage = Damage - CurrentShield;
-	if (HealthDamage > 0.f)
 	{
-		ASC->ApplyModToAttribute(GetHealthAttribute(), EGameplayModOp::Additive, -HealthDamage);
+		// Base writes only: no temporary spec and no execute callbacks, unlike ApplyModToAttribute.
+		// The resolution works on current values but only its delta goes to the base, so active modifiers stay out of it.
+		TGuardValue<bool> ResolvingGuard(bResolvingDamage, true);
+
+		if (Resolution.NewShield != Resolution.OldShield)
+		{
+			SetShield(Shield.GetBaseValue() + (Resolution.NewShield - Resolution.OldShield));
+		}
+		if (Resolution.NewHealth != Resolution.OldHealth)
+		{
+			SetHealth(Health.GetBaseValue() + (Resolution.NewHealth - Resolution.OldHealth));
+		}
 	}
+
+	OnDamageResolved.Broadcast(Resolution);
+	return Resolution;
 }
 
-void UMKHAttributeSet::ApplyShieldDamageMitigation(UAbilitySystemComponent* ASC, float Damage, float CurrentShield) const
+void UMKHAttributeSet::RecordDamageTelemetry(const FGameplayEffectModCallbackData& Data, const FMKHDamageResolution& Resolution) const
 {
-	if (!IsValid(ASC)) return;
-
-	// The shield absorbs a percentage of the damage; the rest hits Health.
-	const float AbsorptionRate  = CalculateShieldAbsorption(CurrentShield);
-	const float ShieldDamage    = FMath::RoundToFloat(Damage * AbsorptionRate);
-	const float HealthDamage    = Damage - ShieldDamage;
-
-	ASC->ApplyModToAttribute(GetShieldAttribute(), EGameplayModOp::Additive, -ShieldDamage);
-	ASC->ApplyModToAttribute(GetHealthAttribute(), EGameplayModOp::Additive, -HealthDamage);
+	const FGameplayEffectContextHandle& Context = Data.EffectSpec.GetContext();
+	const UGameplayAbility* Ability = Context.GetAbility();
+	const FMKHGameplayEffectContext* RPGContext = FMKHGameplayEffectContext::GetEffectContext(Context);
+	const UAbilitySystemComponent* ASC = GetOwningAbilitySystemComponent();
+	const AActor* TargetAvatar = ASC ? ASC->GetAvatarActor() : nullptr;
+	const UWorld* World = GetWorld();
+
+	FCombatTelemetryRecord Record;
+	Record.Timestamp = World ? World->GetTimeSeconds() : 0.0;
+	Record.Source = Context.GetOriginalInstigator() ? Context.GetOriginalInstigator()->GetFName() : NAME_None;
+	Record.Target = TargetAvatar ? TargetAvatar->GetFName() : NAME_None;
+	Record.Ability = Ability ? Ability->GetClass()->GetFName() : NAME_None;
+	Record.BaseDamage = Data.EffectSpec.GetSetByCallerMagnitude(MKHGameplayTags::Combat::Data_Damage, false, 0.f);
+	Record.FinalDamage = Resolution.Damage;
+	Record.bCriticalHit = RPGContext && RPGContext->IsCriticalHit();
+	Record.ShieldAbsorbed = Resolution.OldShield - Resolution.NewShield;
+	Record.HealthLost = Resolution.OldHealth - Resolution.NewHealth;
+
+	FCombatTelemetry::Get().Record(Record);
 }
 
 void UMKHAttributeSet::OnRep_Shield(const FGameplayAttributeData& OldShield)
@@ -6,13 +6,15 @@
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystem/MKHGameplayTags.h"
 #include "AbilitySystem/Abilities/MKHGameplayAbility.h"
-#include "AbilitySystem/Abilities/MKHDamageAbility.h"
-#include "AbilitySystem/Abilities/MKHProjectileAbility.h"
+#include "Combat/LagCompensationSubsystem.h"
 #include "Equipment/EquipmentManagerComponent.h"
 #include "Equipment/EquipmentTypes.h"
 #include "Interfaces/EquipmentInterface.h"
 #include "Engine/StreamableManager.h"
 #include "Engine/AssetManager.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
 
 void UMKHAbilitySystemComponent::AddCharacterAbilities(const TArray<TSubclassOf<UGameplayAbility>>& AbilitiesToGrant)
 {
@@ -58,21 +60,25 @@ void UMKHAbilitySystemComponent::AbilityInputPressed(const FGameplayTag& InputTa
 	if (!InputTag.IsValid())
 		return;
 
-	ABILITYLIST_SCOPE_LOCK();
-
 	const bool bIsQuickSlotInput = IsQuickSlotInput(InputTag);
 
-	for (const FGameplayAbilitySpec& Spec : GetActivatableAbilities())
+	TArray<FInputBoundSpec>* BoundSpecs = FindInputBoundSpecs(InputTag, bIsQuickSlotInput);
+	if (!BoundSpecs)
+		return;
+
+	if (bIsQuickSlotInput)
 	{
-		if (!DoesSpecMatchInput(Spec, InputTag, bIsQuickSlotInput))
-			continue;
+		SendQuickSlotEvent(InputTag);
+	}
+
+	ABILITYLIST_SCOPE_LOCK();
 
-		if (bIsQuickSlotInput)
+	for (FInputBoundSpec& BoundSpec : *BoundSpecs)
+	{
+		if (FGameplayAbilitySpec* Spec = ResolveInputBoundSpec(BoundSpec))
 		{
-			SendQuickSlotEvent(InputTag);
+			HandleAbilityInputPressedForSpec(*Spec);
 		}
-
-		HandleAbilityInputPressedForSpec(Spec);
 	}
 }
 
@@ -81,20 +87,79 @@ void UMKHAbilitySystemComponent::AbilityInputReleased(const FGameplayTag& InputT
 	if (!InputTag.IsValid())
 		return;
 
+	const bool bIsQuickSlotInput = IsQuickSlotInput(InputTag);
+	if (bIsQuickSlotInput)
+		return;
+
+	TArray<FInputBoundSpec>* BoundSpecs = FindInputBoundSpecs(InputTag, bIsQuickSlotInput);
+	if (!BoundSpecs)
+		return;
+
 	ABILITYLIST_SCOPE_LOCK();
 
-	const bool bIsQuickSlotInput = IsQuickSlotInput(InputTag);
+	for (FInputBoundSpec& BoundSpec : *BoundSpecs)
+	{
+		if (FGameplayAbilitySpec* Spec = ResolveInputBoundSpec(BoundSpec))
+		{
+			HandleAbilityInputReleasedForSpec(*Spec);
+		}
+	}
+}
 
-	for (const FGameplayAbilitySpec& Spec : GetActivatableAbilities())
+void UMKHAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnGiveAbility(AbilitySpec);
+
+	if (AbilitySpec.Ability)
 	{
-		if (!DoesSpecMatchInput(Spec, InputTag, bIsQuickSlotInput))
-			continue;
+		if (const FGameplayTagContainer* CooldownTags = AbilitySpec.Ability->GetCooldownTags())
+		{
+			AbilityCooldownTags.AppendTags(*CooldownTags);
+		}
+	}
 
-		if (bIsQuickSlotInput)
-			continue;
-		
-		HandleAbilityInputReleasedForSpec(Spec);
+	for (const FGameplayTag& Tag : AbilitySpec.GetDynamicSpecSourceTags())
+	{
+		TArray<FInputBoundSpec>& BoundSpecs = InputTagToSpecs.FindOrAdd(Tag);
+		const bool bAlreadyBound = BoundSpecs.ContainsByPredicate([&AbilitySpec](const FInputBoundSpec& BoundSpec)
+		{
+			return BoundSpec.Handle == AbilitySpec.Handle;
+		});
+
+		if (!bAlreadyBound)
+		{
+			BoundSpecs.Add(FInputBoundSpec{ AbilitySpec.Handle });
+		}
+	}
+}
+
+void UMKHAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	if (IsOwnerActorAuthoritative())
+	{
+		AbilityGrantConfigs.RemoveAllSwap([&AbilitySpec](const FMKHAbilityGrantConfig& Config)
+		{
+			return Config.Handle == AbilitySpec.Handle;
+		});
+	}
+
+	for (const FGameplayTag& Tag : AbilitySpec.GetDynamicSpecSourceTags())
+	{
+		if (TArray<FInputBoundSpec>* BoundSpecs = InputTagToSpecs.Find(Tag))
+		{
+			BoundSpecs->RemoveAllSwap([&AbilitySpec](const FInputBoundSpec& BoundSpec)
+			{
+				return BoundSpec.Handle == AbilitySpec.Handle;
+			});
+
+			if (BoundSpecs->IsEmpty())
+			{
+				InputTagToSpecs.Remove(Tag);
+			}
+		}
 	}
+
+	Super::OnRemoveAbility(AbilitySpec);
 }
 
 bool UMKHAbilitySystemComponent::IsQuickSlotInput(const FGameplayTag& InputTag) const
@@ -102,14 +167,28 @@ bool UMKHAbilitySystemComponent::IsQuickSlotInput(const FGameplayTag& InputTag)
 	return InputTag.MatchesTag(MKHGameplayTags::Input::QuickSlot);
 }
 
-bool UMKHAbilitySystemComponent::DoesSpecMatchInput(const FGameplayAbilitySpec& Spec, const FGameplayTag& InputTag,
-	const bool bIsQuickSlotInput) const
+TArray<UMKHAbilitySystemComponent::FInputBoundSpec>* UMKHAbilitySystemComponent::FindInputBoundSpecs(const FGameplayTag& InputTag,
+	const bool bIsQuickSlotInput)
 {
-	FGameplayTag TagToConfront = InputTag;
-	if (bIsQuickSlotInput)
-		TagToConfront = MKHGameplayTags::Input::QuickSlot;
+	// Every quick slot shares one spec, bound to the parent tag; the slot travels in the event payload
+	return InputTagToSpecs.Find(bIsQuickSlotInput ? MKHGameplayTags::Input::QuickSlot : InputTag);
+}
 
-	return Spec.GetDynamicSpecSourceTags().HasTagExact(TagToConfront);
+FGameplayAbilitySpec* UMKHAbilitySystemComponent::ResolveInputBoundSpec(FInputBoundSpec& BoundSpec)
+{
+	TArray<FGameplayAbilitySpec>& Specs = ActivatableAbilities.Items;
+	if (Specs.IsValidIndex(BoundSpec.SpecIndex) && Specs[BoundSpec.SpecIndex].Handle == BoundSpec.Handle)
+	{
+		return &Specs[BoundSpec.SpecIndex];
+	}
+
+	// Granting or clearing other abilities moved the spec, look it up once and remember where it went
+	BoundSpec.SpecIndex = Specs.IndexOfByPredicate([&BoundSpec](const FGameplayAbilitySpec& Spec)
+	{
+		return Spec.Handle == BoundSpec.Handle;
+	});
+
+	return Specs.IsValidIndex(BoundSpec.SpecIndex) ? &Specs[BoundSpec.SpecIndex] : nullptr;
 }
 
 void UMKHAbilitySystemComponent::SendQuickSlotEvent(const FGameplayTag& InputTag) const
@@ -119,7 +198,7 @@ void UMKHAbilitySystemComponent::SendQuickSlotEvent(const FGameplayTag& InputTag
 	UAbilitySystemBlueprintLibrary::SendGameplayEventToActor(GetAvatarActor(), MKHGameplayTags::Event::UseQuickSlot, Payload);
 }
 
-void UMKHAbilitySystemComponent::HandleAbilityInputPressedForSpec(const FGameplayAbilitySpec& Spec)
+void UMKHAbilitySystemComponent::HandleAbilityInputPressedForSpec(FGameplayAbilitySpec& Spec)
 {
 	if (!Spec.IsActive())
 	{
@@ -127,19 +206,38 @@ void UMKHAbilitySystemComponent::HandleAbilityInputPressedForSpec(const FGamepla
 		return;
 	}
 
-	if (const UGameplayAbility* PrimaryInstance = Spec.GetPrimaryInstance(); IsValid(PrimaryInstance))
+	// Sets InputPressed and calls UGameplayAbility::InputPressed on the active instances
+	AbilitySpecInputPressed(Spec);
+	ReplicateAbilityInputEvent(EAbilityGenericReplicatedEvent::InputPressed, Spec);
+}
+
+void UMKHAbilitySystemComponent::HandleAbilityInputReleasedForSpec(FGameplayAbilitySpec& Spec)
+{
+	// Clears InputPressed and calls UGameplayAbility::InputReleased on the active instances
+	AbilitySpecInputReleased(Spec);
+
+	if (Spec.IsActive())
 	{
-		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputPressed, Spec.Handle,
-			PrimaryInstance->GetCurrentActivationInfo().GetActivationPredictionKey());
+		ReplicateAbilityInputEvent(EAbilityGenericReplicatedEvent::InputReleased, Spec);
 	}
 }
 
-void UMKHAbilitySystemComponent::HandleAbilityInputReleasedForSpec(const FGameplayAbilitySpec& Spec)
+void UMKHAbilitySystemComponent::ReplicateAbilityInputEvent(const EAbilityGenericReplicatedEvent::Type EventType,
+	const FGameplayAbilitySpec& Spec)
 {
-	if (const UGameplayAbility* PrimaryInstance = Spec.GetPrimaryInstance(); IsValid(PrimaryInstance))
+	const UGameplayAbility* PrimaryInstance = Spec.GetPrimaryInstance();
+	if (!IsValid(PrimaryInstance))
+	{
+		return;
+	}
+
+	const FPredictionKey ActivationKey = PrimaryInstance->GetCurrentActivationInfo().GetActivationPredictionKey();
+
+	// A bound WaitInputPress/Release task forwards the event to the server on its own
+	const bool bHandledByTask = InvokeReplicatedEvent(EventType, Spec.Handle, ActivationKey);
+	if (!bHandledByTask && !IsOwnerActorAuthoritative())
 	{
-		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputReleased, Spec.Handle,
-			PrimaryInstance->GetCurrentActivationInfo().GetActivationPredictionKey());
+		ServerSetReplicatedEvent(EventType, Spec.Handle, ActivationKey, ScopedPredictionKey);
 	}
 }
 
@@ -201,23 +299,205 @@ void UMKHAbilitySystemComponent::GetCooldownRemainingForTag(const FGameplayTag C
 	TimeRemaining = 0.f;
 	CooldownDuration = 0.f;
 
-	if (CooldownTag.IsValid())
+	const FCooldownWindow* Window = CooldownWindows.Find(CooldownTag);
+	const UWorld* World = GetWorld();
+	if (!Window || !World)
+	{
+		return;
+	}
+
+	TimeRemaining = FMath::Max(static_cast<float>(Window->EndTime - World->GetTimeSeconds()), 0.f);
+	CooldownDuration = static_cast<float>(Window->EndTime - Window->StartTime);
+}
+
+void UMKHAbilitySystemComponent::ReportClientViewTime()
+{
+	const UWorld* World = GetWorld();
+	if (!World || IsOwnerActorAuthoritative() || !AbilityActorInfo.IsValid() || !AbilityActorInfo->IsLocallyControlled())
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	if (!GameState)
+	{
+		return;
+	}
+
+	// Other pawns reach this client half a round trip after the server moved them
+	const APlayerController* PlayerController = AbilityActorInfo->PlayerController.Get();
+	const APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState : nullptr;
+	const double HalfRoundTrip = PlayerState ? PlayerState->GetPingInMilliseconds() * 0.0005 : 0.0;
+
+	ServerReportClientViewTime(GameState->GetServerWorldTimeSeconds() - HalfRoundTrip);
+}
+
+void UMKHAbilitySystemComponent::ServerReportClientViewTime_Implementation(const double ClientViewTime)
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// Measured on arrival, so the delay includes the trip of the attack itself
+	ClientViewDelay = FMath::Clamp(static_cast<float>(World->GetTimeSeconds() - ClientViewTime), 0.f, ULagCompensationSubsystem::GetMaxRewindSeconds());
+}
+
+void UMKHAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only the owner activates, predicts cooldowns and shows skills
+	DOREPLIFETIME_CONDITION(UMKHAbilitySystemComponent, AbilityGrantConfigs, COND_OwnerOnly);
+}
+
+void UMKHAbilitySystemComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (!OnActiveGameplayEffectAddedDelegateToSelf.IsBoundToObject(this))
+	{
+		// Fires on the server and on clients (predicted or replicated effects) for every duration effect
+		OnActiveGameplayEffectAddedDelegateToSelf.AddUObject(this, &UMKHAbilitySystemComponent::OnCooldownEffectAdded);
+		OnAnyGameplayEffectRemovedDelegate().AddUObject(this, &UMKHAbilitySystemComponent::OnCooldownEffectRemoved);
+	}
+}
+
+void UMKHAbilitySystemComponent::OnCooldownEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& SpecApplied,
+	const FActiveGameplayEffectHandle ActiveHandle)
+{
+	const FActiveGameplayEffect* ActiveEffect = GetActiveGameplayEffect(ActiveHandle);
+	if (!ActiveEffect || ActiveEffect->GetDuration() <= 0.f)
+	{
+		return;
+	}
+
+	// Includes DynamicGrantedTags, which is how skills set their cooldown tag (UMKHDamageAbility::ApplyCooldown)
+	FGameplayTagContainer GrantedTags;
+	SpecApplied.GetAllGrantedTags(GrantedTags);
+
+	bool bTracked = false;
+	for (const FGameplayTag& Tag : GrantedTags)
+	{
+		if (IsAbilityCooldownTag(Tag))
+		{
+			TrackCooldownWindow(Tag, *ActiveEffect);
+			bTracked = true;
+		}
+	}
+
+	if (!bTracked)
+	{
+		return;
+	}
+
+	// Cooldown reductions change the duration in place, and stacking may refresh it
+	if (FOnActiveGameplayEffectTimeChange* TimeChange = OnGameplayEffectTimeChangeDelegate(ActiveHandle))
+	{
+		TimeChange->AddUObject(this, &UMKHAbilitySystemComponent::OnCooldownEffectTimeChanged);
+	}
+	if (FOnActiveGameplayEffectStackChange* StackChange = OnGameplayEffectStackChangeDelegate(ActiveHandle))
+	{
+		StackChange->AddUObject(this, &UMKHAbilitySystemComponent::OnCooldownEffectStackChanged);
+	}
+}
+
+void UMKHAbilitySystemComponent::OnCooldownEffectTimeChanged(const FActiveGameplayEffectHandle ActiveHandle, float NewStartTime, float NewDuration)
+{
+	RefreshCooldownWindows(ActiveHandle);
+}
+
+void UMKHAbilitySystemComponent::OnCooldownEffectStackChanged(const FActiveGameplayEffectHandle ActiveHandle, int32 NewStackCount,
+	int32 PreviousStackCount)
+{
+	RefreshCooldownWindows(ActiveHandle);
+}
+
+void UMKHAbilitySystemComponent::RefreshCooldownWindows(const FActiveGameplayEffectHandle ActiveHandle)
+{
+	const FActiveGameplayEffect* ActiveEffect = GetActiveGameplayEffect(ActiveHandle);
+	if (!ActiveEffect || ActiveEffect->GetDuration() <= 0.f)
+	{
+		return;
+	}
+
+	FGameplayTagContainer GrantedTags;
+	ActiveEffect->Spec.GetAllGrantedTags(GrantedTags);
+
+	for (const FGameplayTag& Tag : GrantedTags)
 	{
-		// Creating a query to find the Effect that grants the CooldownTag
-		FGameplayEffectQuery const Query = FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(FGameplayTagContainer(CooldownTag));
-        
-		// Gets the Remaining Times of all Effects found with the query
-		TArray<float> Durations = GetActiveEffectsTimeRemaining(Query);
-        
-		if (Durations.Num() > 0)
+		if (!IsAbilityCooldownTag(Tag))
 		{
-			TimeRemaining = FMath::Max(Durations[0], 0.f);
-            
-			// Get the Total Duration as well
-			TArray<float> TotalDurations = GetActiveEffectsDuration(Query);
-			CooldownDuration = TotalDurations[0];
+			continue;
+		}
+
+		// A window this effect owns follows it even when it got shorter
+		if (FCooldownWindow* Window = CooldownWindows.Find(Tag); Window && Window->EffectHandle == ActiveHandle)
+		{
+			Window->EndTime = ActiveEffect->GetEndTime();
+			Window->StartTime = Window->EndTime - ActiveEffect->GetDuration();
+			continue;
 		}
+		TrackCooldownWindow(Tag, *ActiveEffect);
+	}
+}
+
+void UMKHAbilitySystemComponent::OnCooldownEffectRemoved(const FActiveGameplayEffect& RemovedEffect)
+{
+	FGameplayTagContainer GrantedTags;
+	RemovedEffect.Spec.GetAllGrantedTags(GrantedTags);
+
+	// Windows are only ever keyed by cooldown tags, so the handle check below filters the rest
+	for (const FGameplayTag& Tag : GrantedTags)
+	{
+		const FCooldownWindow* Window = CooldownWindows.Find(Tag);
+		if (!Window || Window->EffectHandle != RemovedEffect.Handle)
+		{
+			continue;
+		}
+
+		CooldownWindows.Remove(Tag);
+
+		// Rare: another effect still grants the tag, one lookup here keeps the window right
+		const FGameplayEffectQuery Query = FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(FGameplayTagContainer(Tag));
+		for (const FActiveGameplayEffectHandle& OtherHandle : GetActiveEffects(Query))
+		{
+			if (const FActiveGameplayEffect* OtherEffect = GetActiveGameplayEffect(OtherHandle);
+				OtherEffect && OtherHandle != RemovedEffect.Handle && OtherEffect->GetDuration() > 0.f)
+			{
+				TrackCooldownWindow(Tag, *OtherEffect);
+			}
+		}
+	}
+}
+
+void UMKHAbilitySystemComponent::TrackCooldownWindow(const FGameplayTag& Tag, const FActiveGameplayEffect& ActiveEffect)
+{
+	const double EndTime = ActiveEffect.GetEndTime();
+
+	FCooldownWindow& Window = CooldownWindows.FindOrAdd(Tag);
+	if (Window.EffectHandle.IsValid() && Window.EffectHandle != ActiveEffect.Handle && Window.EndTime >= EndTime)
+	{
+		return;
+	}
+
+	Window.StartTime = EndTime - ActiveEffect.GetDuration();
+	Window.EndTime = EndTime;
+	Window.EffectHandle = ActiveEffect.Handle;
+}
+
+bool UMKHAbilitySystemComponent::IsAbilityCooldownTag(const FGameplayTag& Tag) const
+{
+	if (AbilityCooldownTags.HasTagExact(Tag))
+	{
+		return true;
 	}
+
+	return AbilityGrantConfigs.ContainsByPredicate([&Tag](const FMKHAbilityGrantConfig& Config)
+	{
+		return Config.CooldownTags.HasTagExact(Tag);
+	});
 }
 
 TWeakObjectPtr<UEquipmentManagerComponent> UMKHAbilitySystemComponent::GetWeakEquipmentManager() const
@@ -339,30 +619,45 @@ FGameplayAbilitySpecHandle UMKHAbilitySystemComponent::GrantEquipmentAbility(con
 {
 	FGameplayAbilitySpec Spec = FGameplayAbilitySpec(AbilityDef.AbilityClass.Get(), 1.f);
 
-	if (UMKHGameplayAbility* RPGAbility = Cast<UMKHGameplayAbility>(Spec.Ability))
+	// Everything that varies per grant goes into the config, the ability's class defaults stay untouched
+	FMKHAbilityGrantConfig Config;
+	Config.Handle = Spec.Handle;
+	Config.ContextTag = AbilityDef.ContextTag;
+	Config.DamagePercent = FMath::Max(0.f, AbilityDef.DamagePercent);
+	Config.bIsSkillAbility = AbilityDef.bIsSkillAbility;
+
+	if (AbilityDef.bIsSkillAbility)
 	{
-		if (AbilityDef.bIsSkillAbility)
-		{
-			// Ovveride the input tag for skills because they are set dynamically
-			RPGAbility->InputTag = AbilityDef.SkillInputTag; // AbilityDef.SkillInputTag is set when the skill is rolled
-		}
-		Spec.GetDynamicSpecSourceTags().AddTag(RPGAbility->InputTag);
+		// Skill inputs are rolled with the item, not set on the ability class
+		Config.InputTag = AbilityDef.SkillInputTag;
+		Config.CooldownTime = FMath::Max(0.f, AbilityDef.CooldownTime);
+		Config.CooldownTags = AbilityDef.CooldownTag.GetSingleTagContainer();
+	}
+	else if (const UMKHGameplayAbility* RPGAbility = Cast<UMKHGameplayAbility>(Spec.Ability))
+	{
+		Config.InputTag = RPGAbility->InputTag;
 	}
 
-	if (UMKHProjectileAbility* ProjectileAbility = Cast<UMKHProjectileAbility>(Spec.Ability))
+	if (Config.InputTag.IsValid())
 	{
-		ProjectileAbility->ProjectileToSpawnTag = AbilityDef.ContextTag;
+		Spec.GetDynamicSpecSourceTags().AddTag(Config.InputTag);
 	}
 
-	if (UMKHDamageAbility* DamageAbility = Cast<UMKHDamageAbility>(Spec.Ability))
+	// Added before the grant so OnGiveAbility already finds it on the server
+	AbilityGrantConfigs.Add(Config);
+
+	const FGameplayAbilitySpecHandle Handle = GiveAbility(Spec);
+	if (!Handle.IsValid())
 	{
-		DamageAbility->SetDamagePercent(AbilityDef.DamagePercent);
-		DamageAbility->SetIsSkillAbility(AbilityDef.bIsSkillAbility);
-		if (AbilityDef.bIsSkillAbility)
-		{
-			DamageAbility->SetCooldownData(AbilityDef.CooldownTime, AbilityDef.CooldownTag.GetSingleTagContainer());
-		}
+		AbilityGrantConfigs.RemoveAllSwap([&Config](const FMKHAbilityGrantConfig& Existing) { return Existing.Handle == Config.Handle; });
 	}
+	return Handle;
+}
 
-	return GiveAbility(Spec);
+const FMKHAbilityGrantConfig* UMKHAbilitySystemComponent::FindAbilityGrantConfig(const FGameplayAbilitySpecHandle Handle) const
+{
+	return AbilityGrantConfigs.FindByPredicate([Handle](const FMKHAbilityGrantConfig& Config)
+	{
+		return Config.Handle == Handle;
+	});
 }
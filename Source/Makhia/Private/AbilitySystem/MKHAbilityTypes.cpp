@@ -3,6 +3,333 @@
 
 #include "AbilitySystem/MKHAbilityTypes.h"
 
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemInterface.h"
+#include "Animation/AnimMontage.h"
+#include "Async/Mutex.h"
+#include "Async/UniqueLock.h"
+#include "Combat/AnimNotify_CombatEvent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetSerialization.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/CoreNet.h"
+
+namespace EffectContextNet
+{
+	/** The mesh bone indices refer to: the character mesh, or the first skinned mesh of other actors. */
+	USkinnedMeshComponent* GetBoneMesh(const AActor* Actor)
+	{
+		if (const ACharacter* Character = Cast<ACharacter>(Actor))
+		{
+			return Character->GetMesh();
+		}
+		return Actor ? Actor->FindComponentByClass<USkinnedMeshComponent>() : nullptr;
+	}
+
+	/** Bits and time spent serializing one batch of contexts with each hit encoding. */
+	struct FBenchResult
+	{
+		int64 ContextBits = 0;
+		int64 CompactHitBits = 0;
+		int64 FullHitBits = 0;
+		int64 CritBytes = 0;
+		double CompactSeconds = 0.0;
+		double FullSeconds = 0.0;
+	};
+
+	/**
+	 * Makhia.Net.EffectContextBench [NumHits=10000] [HitsPerSecond=2000]
+	 * Serializes NumHits damage contexts (instigator, source, ability-less, hit on a random bone of a character)
+	 * through a live connection's package map and compares the compact hit with FHitResult::NetSerialize.
+	 * Needs a networked session with at least one connection (listen server, dedicated server or client).
+	 */
+	void RunBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		UNetConnection* Connection = NetDriver
+			? (NetDriver->ServerConnection ? NetDriver->ServerConnection.Get() : (NetDriver->ClientConnections.Num() > 0 ? NetDriver->ClientConnections[0].Get() : nullptr))
+			: nullptr;
+		if (!Connection || !Connection->PackageMap)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Makhia.Net.EffectContextBench needs a networked session with an open connection."));
+			return;
+		}
+
+		TArray<ACharacter*> Characters;
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			if (IsValid(It->GetMesh()) && It->GetMesh()->GetNumBones() > 0)
+			{
+				Characters.Add(*It);
+			}
+		}
+		if (Characters.IsEmpty())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Makhia.Net.EffectContextBench needs at least one character with a skeletal mesh."));
+			return;
+		}
+
+		const int32 NumHits = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		const float HitsPerSecond = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 1.f) : 2000.f;
+		UPackageMap* Map = Connection->PackageMap;
+		FRandomStream Stream(NumHits);
+		FBenchResult Result;
+
+		for (int32 i = 0; i < NumHits; ++i)
+		{
+			ACharacter* Target = Characters[i % Characters.Num()];
+			ACharacter* Instigator = Characters[(i + 1) % Characters.Num()];
+			USkinnedMeshComponent* Mesh = Target->GetMesh();
+
+			FHitResult Hit(Target, Mesh, Target->GetActorLocation() + Stream.GetUnitVector() * 50.f, Stream.GetUnitVector());
+			Hit.TraceStart = Instigator->GetActorLocation();
+			Hit.TraceEnd = Hit.ImpactPoint + (Hit.ImpactPoint - Hit.TraceStart).GetSafeNormal() * 10.f;
+			Hit.ImpactNormal = Hit.Normal;
+			Hit.BoneName = Mesh->GetBoneName(Stream.RandRange(0, Mesh->GetNumBones() - 1));
+			Hit.Distance = FVector::Dist(Hit.TraceStart, Hit.ImpactPoint);
+
+			FMKHGameplayEffectContext Context;
+			Context.AddInstigator(Instigator, Instigator);
+			Context.AddSourceObject(Instigator);
+			Context.AddHitResult(Hit);
+			Context.SetIsCriticalHit(Stream.FRand() < 0.25f);
+
+			bool bSuccess = true;
+			FNetBitWriter ContextWriter(Map, 2048);
+			ContextWriter.SetAllowResize(true);
+			Context.NetSerialize(ContextWriter, Map, bSuccess);
+			Result.ContextBits += ContextWriter.GetNumBits();
+			Result.CritBytes += Context.IsCriticalHit() ? 1 : 0;
+
+			FNetBitWriter CompactWriter(Map, 2048);
+			CompactWriter.SetAllowResize(true);
+			double Start = FPlatformTime::Seconds();
+			NetSerializeCompactHit(CompactWriter, Map, Hit);
+			Result.CompactSeconds += FPlatformTime::Seconds() - Start;
+			Result.CompactHitBits += CompactWriter.GetNumBits();
+
+			FNetBitWriter FullWriter(Map, 2048);
+			FullWriter.SetAllowResize(true);
+			Start = FPlatformTime::Seconds();
+			Hit.NetSerialize(FullWriter, Map, bSuccess);
+			Result.FullSeconds += FPlatformTime::Seconds() - Start;
+			Result.FullHitBits += FullWriter.GetNumBits();
+		}
+
+		// Previous encoding: same context, full hit result and a whole byte for the crit flag
+		const double NewBytes = Result.ContextBits / 8.0 / NumHits;
+		const double OldBytes = (Result.ContextBits - Result.CompactHitBits + Result.FullHitBits + Result.CritBytes * 8) / 8.0 / NumHits;
+
+		UE_LOG(LogTemp, Display, TEXT("Effect context bench: %d hits on %d characters"), NumHits, Characters.Num());
+		UE_LOG(LogTemp, Display, TEXT("  hit result: compact %.1f B (%.2f us), full %.1f B (%.2f us)"),
+			Result.CompactHitBits / 8.0 / NumHits, Result.CompactSeconds * 1e6 / NumHits,
+			Result.FullHitBits / 8.0 / NumHits, Result.FullSeconds * 1e6 / NumHits);
+		UE_LOG(LogTemp, Display, TEXT("  context: %.1f B now, %.1f B before (-%.0f%%) | at %.0f hits/s: %.1f KB/s now, %.1f KB/s before"),
+			NewBytes, OldBytes, OldBytes > 0.0 ? (1.0 - NewBytes / OldBytes) * 100.0 : 0.0,
+			HitsPerSecond, NewBytes * HitsPerSecond / 1024.0, OldBytes * HitsPerSecond / 1024.0);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Makhia.Net.EffectContextBench"),
+		TEXT("Makhia.Net.EffectContextBench [NumHits] [HitsPerSecond]: compares effect context bandwidth with the compact and the full hit encoding."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+namespace EffectContextPool
+{
+	constexpr SIZE_T BlockAlignment = FMath::Max<SIZE_T>(alignof(FMKHGameplayEffectContext), alignof(void*));
+	constexpr SIZE_T BlockSize = Align(sizeof(FMKHGameplayEffectContext), BlockAlignment);
+	constexpr int32 BlocksPerChunk = 256;
+
+	/** A recycled block; the link overlays the dead context. */
+	struct FFreeBlock
+	{
+		FFreeBlock* Next;
+	};
+
+	struct FPool
+	{
+		UE::FMutex Mutex;
+		FFreeBlock* FreeList = nullptr;
+		TArray<uint8*> Chunks;
+		FMKHEffectContextPoolStats Stats;
+
+		bool OwnsBlock(const void* Ptr) const
+		{
+			for (const uint8* Chunk : Chunks)
+			{
+				if (Ptr >= Chunk && Ptr < Chunk + BlockSize * BlocksPerChunk)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	/** Intentionally leaked: handles owned by other statics can still release contexts during shutdown. */
+	FPool& GetPool()
+	{
+		static FPool* Pool = new FPool();
+		return *Pool;
+	}
+
+	void* Allocate(const SIZE_T Size)
+	{
+		FPool& Pool = GetPool();
+		UE::TUniqueLock Lock(Pool.Mutex);
+
+		++Pool.Stats.NumAllocations;
+
+		// Derived context types do not fit a block
+		if (Size > BlockSize)
+		{
+			++Pool.Stats.NumHeapAllocations;
+			return FMemory::Malloc(Size, BlockAlignment);
+		}
+
+		if (!Pool.FreeList)
+		{
+			uint8* Chunk = static_cast<uint8*>(FMemory::Malloc(BlockSize * BlocksPerChunk, BlockAlignment));
+			Pool.Chunks.Add(Chunk);
+			++Pool.Stats.NumHeapAllocations;
+
+			for (int32 Index = BlocksPerChunk - 1; Index >= 0; --Index)
+			{
+				FFreeBlock* Block = reinterpret_cast<FFreeBlock*>(Chunk + Index * BlockSize);
+				Block->Next = Pool.FreeList;
+				Pool.FreeList = Block;
+			}
+			Pool.Stats.NumFree += BlocksPerChunk;
+		}
+
+		FFreeBlock* Block = Pool.FreeList;
+		Pool.FreeList = Block->Next;
+		--Pool.Stats.NumFree;
+		++Pool.Stats.NumLive;
+		return Block;
+	}
+
+	void Free(void* Ptr)
+	{
+		if (!Ptr)
+		{
+			return;
+		}
+
+		FPool& Pool = GetPool();
+		{
+			UE::TUniqueLock Lock(Pool.Mutex);
+			if (Pool.OwnsBlock(Ptr))
+			{
+				FFreeBlock* Block = static_cast<FFreeBlock*>(Ptr);
+				Block->Next = Pool.FreeList;
+				Pool.FreeList = Block;
+				--Pool.Stats.NumLive;
+				++Pool.Stats.NumFree;
+				return;
+			}
+		}
+
+		// Oversized contexts, and contexts the engine mallocs when a handle replicates in
+		FMemory::Free(Ptr);
+	}
+
+	/**
+	 * Makhia.GAS.EffectContextBench [NumHits=100000]
+	 * Runs the context side of the damage path NumHits times on the first character with an ability system: an
+	 * ability context from MakeEffectContext, a per-target duplicate, a hit result and the crit flag, all released
+	 * at the end of the hit. Logs hits per second and how many context blocks the pool had to take from the heap
+	 * (0 once the pool is warm). The pool only covers the context objects: every hit still heap-allocates a
+	 * reference controller per handle and the FHitResult that AddHitResult shares, which this bench does not count.
+	 */
+	void RunBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		UAbilitySystemComponent* ASC = nullptr;
+		ACharacter* Target = nullptr;
+		for (TActorIterator<ACharacter> It(World); It && !ASC; ++It)
+		{
+			if (const IAbilitySystemInterface* AbilityInterface = Cast<IAbilitySystemInterface>(*It))
+			{
+				ASC = AbilityInterface->GetAbilitySystemComponent();
+				Target = *It;
+			}
+		}
+		if (!ASC)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Makhia.GAS.EffectContextBench needs a character with an ability system component."));
+			return;
+		}
+
+		const int32 NumHits = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		FHitResult Hit(Target, Target->GetMesh(), Target->GetActorLocation(), FVector::UpVector);
+
+		const auto RunHits = [&](const int32 Count)
+		{
+			for (int32 i = 0; i < Count; ++i)
+			{
+				FGameplayEffectContextHandle AbilityContext = ASC->MakeEffectContext();
+				FGameplayEffectContextHandle TargetContext = AbilityContext.Duplicate();
+				TargetContext.AddHitResult(Hit, true);
+				if (FMKHGameplayEffectContext* RPGContext = FMKHGameplayEffectContext::GetEffectContext(TargetContext))
+				{
+					RPGContext->SetIsCriticalHit((i & 3) == 0);
+				}
+			}
+		};
+
+		RunHits(1024);
+
+		const FMKHEffectContextPoolStats Before = FMKHGameplayEffectContext::GetPoolStats();
+		const double Start = FPlatformTime::Seconds();
+		RunHits(NumHits);
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		const FMKHEffectContextPoolStats After = FMKHGameplayEffectContext::GetPoolStats();
+
+		const uint64 NumContexts = After.NumAllocations - Before.NumAllocations;
+		const uint64 NumHeap = After.NumHeapAllocations - Before.NumHeapAllocations;
+		UE_LOG(LogTemp, Display, TEXT("Effect context pool bench: %d hits, %.0f hits/s (%.3f us), %llu contexts, %llu pool chunk or oversized allocations (%.4f per hit; handle controllers and hit results not counted), pool %d live / %d free"),
+			NumHits, NumHits / FMath::Max(Seconds, UE_DOUBLE_SMALL_NUMBER), Seconds * 1e6 / NumHits,
+			NumContexts, NumHeap, static_cast<double>(NumHeap) / NumHits, After.NumLive, After.NumFree);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Makhia.GAS.EffectContextBench"),
+		TEXT("Makhia.GAS.EffectContextBench [NumHits]: measures hits per second and the pool's own heap allocations."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBenchmark));
+
+	static FAutoConsoleCommand StatsCommand(
+		TEXT("Makhia.GAS.EffectContextPoolStats"),
+		TEXT("Logs the effect context pool counters."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FMKHEffectContextPoolStats Stats = FMKHGameplayEffectContext::GetPoolStats();
+			UE_LOG(LogTemp, Display, TEXT("Effect context pool: %llu allocations, %llu from the heap, %d live, %d free"),
+				Stats.NumAllocations, Stats.NumHeapAllocations, Stats.NumLive, Stats.NumFree);
+		}));
+}
+
+void* FMKHGameplayEffectContext::operator new(const size_t Size)
+{
+	return EffectContextPool::Allocate(Size);
+}
+
+void FMKHGameplayEffectContext::operator delete(void* Ptr)
+{
+	EffectContextPool::Free(Ptr);
+}
+
+FMKHEffectContextPoolStats FMKHGameplayEffectContext::GetPoolStats()
+{
+	EffectContextPool::FPool& Pool = EffectContextPool::GetPool();
+	UE::TUniqueLock Lock(Pool.Mutex);
+	return Pool.Stats;
+}
+
 FMKHGameplayEffectContext* FMKHGameplayEffectContext::GetEffectContext(FGameplayEffectContextHandle Handle)
 {
 	FGameplayEffectContext* EffectContext = Handle.Get();
@@ -75,6 +402,7 @@ bool FMKHGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, boo
 	{
 		SafeNetSerializeTArray_Default<31>(Ar, Actors);
 	}
+	bool bHitSuccess = true;
 	if (RepBits & (1 << 5))
 	{
 		if (Ar.IsLoading())
@@ -84,7 +412,7 @@ bool FMKHGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, boo
 				HitResult = TSharedPtr<FHitResult>(new FHitResult());
 			}
 		}
-		HitResult->NetSerialize(Ar, Map, bOutSuccess);
+		bHitSuccess = NetSerializeCompactHit(Ar, Map, *HitResult);
 	}
 	if (RepBits & (1 << 6))
 	{
@@ -95,9 +423,9 @@ bool FMKHGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, boo
 	{
 		bHasWorldOrigin = false;
 	}
-	if (RepBits & 1 << 7)
+	if (Ar.IsLoading())
 	{
-		Ar << bCriticalHit;
+		bCriticalHit = (RepBits & (1 << 7)) != 0;
 	}
 
 	if (Ar.IsLoading())
@@ -105,6 +433,85 @@ bool FMKHGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, boo
 		AddInstigator(Instigator.Get(), EffectCauser.Get()); // Just to initialize InstigatorAbilitySystemComponent
 	}
 
-	bOutSuccess = true;
+	bOutSuccess = bHitSuccess;
 	return true;
-}
\ No newline at end of file
+}
+
+bool FMKHGameplayEffectContext::NetSerializeCompactHit(FArchive& Ar, UPackageMap* Map, FHitResult& Hit)
+{
+	FVector_NetQuantize10 ImpactPoint = Hit.ImpactPoint;
+	FVector_NetQuantizeNormal ImpactNormal = Hit.ImpactNormal;
+	TWeakObjectPtr<AActor> HitActor = Hit.GetActor();
+	int16 BoneIndex = INDEX_NONE;
+
+	if (Ar.IsSaving() && Hit.BoneName != NAME_None)
+	{
+		const USkinnedMeshComponent* Mesh = EffectContextNet::GetBoneMesh(HitActor.Get());
+		const int32 MeshBoneIndex = Mesh && Hit.GetComponent() == Mesh ? Mesh->GetBoneIndex(Hit.BoneName) : INDEX_NONE;
+		BoneIndex = MeshBoneIndex >= 0 && MeshBoneIndex <= MAX_int16 ? static_cast<int16>(MeshBoneIndex) : INDEX_NONE;
+	}
+
+	bool bPointSuccess = true;
+	bool bNormalSuccess = true;
+	ImpactPoint.NetSerialize(Ar, Map, bPointSuccess);
+	ImpactNormal.NetSerialize(Ar, Map, bNormalSuccess);
+	Ar << HitActor;
+
+	uint8 bHasBone = BoneIndex != INDEX_NONE ? 1 : 0;
+	Ar.SerializeBits(&bHasBone, 1);
+	if (bHasBone)
+	{
+		Ar << BoneIndex;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Hit = FHitResult();
+		Hit.bBlockingHit = true;
+		Hit.ImpactPoint = ImpactPoint;
+		Hit.Location = ImpactPoint;
+		Hit.ImpactNormal = ImpactNormal;
+		Hit.Normal = ImpactNormal;
+		Hit.HitObjectHandle = FActorInstanceHandle(HitActor.Get());
+
+		USkinnedMeshComponent* Mesh = EffectContextNet::GetBoneMesh(HitActor.Get());
+		if (bHasBone && Mesh)
+		{
+			Hit.Component = Mesh;
+			Hit.BoneName = Mesh->GetBoneName(BoneIndex);
+		}
+	}
+
+	return bPointSuccess && bNormalSuccess && !Ar.IsError();
+}
+
+bool FMKHCombatTimeline::IsBakedFor(const UAnimMontage* Montage) const
+{
+	return Montage && !Events.IsEmpty() && SourceMontage.ToSoftObjectPath() == FSoftObjectPath(Montage)
+		&& NotifyHash == HashNotifies(Montage);
+}
+
+uint32 FMKHCombatTimeline::HashNotifies(const UAnimMontage* Montage)
+{
+	uint32 Hash = 0;
+	if (!Montage)
+	{
+		return Hash;
+	}
+
+	// Everything BakeCombatTimeline resolves events from: names, classes, combat event tags and timing
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent.NotifyName));
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent.Notify ? NotifyEvent.Notify->GetClass()->GetFName() : NAME_None));
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent.NotifyStateClass ? NotifyEvent.NotifyStateClass->GetClass()->GetFName() : NAME_None));
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent.GetTriggerTime()));
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent.GetEndTriggerTime()));
+
+		if (const UAnimNotify_CombatEvent* CombatNotify = Cast<UAnimNotify_CombatEvent>(NotifyEvent.Notify))
+		{
+			Hash = HashCombine(Hash, GetTypeHash(CombatNotify->EventTag));
+		}
+	}
+	return Hash;
+}
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AbilitySystem/Tasks/MKHAbilityTask_CombatTimeline.h"
+
+#include "AbilitySystemComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+
+namespace CombatTimeline
+{
+	/** Extra advance, in montage seconds, tolerated before a position change counts as a section jump. */
+	constexpr float JumpTolerance = 0.05f;
+}
+
+UMKHAbilityTask_CombatTimeline::UMKHAbilityTask_CombatTimeline(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	bTickingTask = true;
+}
+
+UMKHAbilityTask_CombatTimeline* UMKHAbilityTask_CombatTimeline::PlayCombatTimeline(UGameplayAbility* OwningAbility,
+	UAnimMontage* Montage, const FMKHCombatTimeline& Timeline)
+{
+	UMKHAbilityTask_CombatTimeline* Task = NewAbilityTask<UMKHAbilityTask_CombatTimeline>(OwningAbility);
+	Task->Montage = Montage;
+	Task->Events = Timeline.Events;
+	return Task;
+}
+
+void UMKHAbilityTask_CombatTimeline::Activate()
+{
+	Super::Activate();
+
+	if (Events.IsEmpty() || !AbilitySystemComponent.IsValid())
+	{
+		EndTask();
+	}
+}
+
+void UMKHAbilityTask_CombatTimeline::TickTask(float DeltaTime)
+{
+	Super::TickTask(DeltaTime);
+
+	ElapsedTime += DeltaTime;
+
+	float Position = ElapsedTime;
+	float PlayRate = 1.f;
+
+	const FGameplayAbilityActorInfo* ActorInfo = Ability ? Ability->GetCurrentActorInfo() : nullptr;
+	UAnimInstance* AnimInstance = ActorInfo ? ActorInfo->GetAnimInstance() : nullptr;
+	if (AnimInstance && AnimInstance->Montage_IsPlaying(Montage))
+	{
+		Position = AnimInstance->Montage_GetPosition(Montage);
+		PlayRate = FMath::Abs(AnimInstance->Montage_GetPlayRate(Montage));
+
+		// A montage position that went back or leapt forward is a section jump: resume from the new position
+		// instead of replaying or skipping everything in between.
+		const float ExpectedAdvance = DeltaTime * PlayRate;
+		if (bMontageWasPlaying && (Position < LastPosition || Position > LastPosition + ExpectedAdvance + CombatTimeline::JumpTolerance))
+		{
+			LastPosition = Position - ExpectedAdvance - UE_KINDA_SMALL_NUMBER;
+		}
+		bMontageWasPlaying = true;
+	}
+	else if (bMontageWasPlaying)
+	{
+		// The montage ended or was stopped; the ability's montage task takes it from here.
+		EndTask();
+		return;
+	}
+
+	if (SendEvents(Position))
+	{
+		LastPosition = Position;
+	}
+}
+
+bool UMKHAbilityTask_CombatTimeline::SendEvents(float Position)
+{
+	for (const FMKHCombatTimelineEvent& Event : Events)
+	{
+		if (Event.Time <= LastPosition)
+		{
+			continue;
+		}
+		if (Event.Time > Position)
+		{
+			break;
+		}
+
+		UAbilitySystemComponent* ASC = AbilitySystemComponent.Get();
+		if (!ASC)
+		{
+			EndTask();
+			return false;
+		}
+
+		FGameplayEventData Payload;
+		Payload.EventTag = Event.EventTag;
+		Payload.Instigator = GetAvatarActor();
+		Payload.OptionalObject = Ability;
+		ASC->HandleGameplayEvent(Event.EventTag, &Payload);
+
+		// Handlers may end the ability (e.g. a combo window closing without input)
+		if (IsFinished())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
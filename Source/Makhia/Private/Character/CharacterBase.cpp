@@ -5,7 +5,22 @@
 #include "AbilitySystem/MKHGameplayTags.h"
 #include "AbilitySystem/Attributes/MKHAttributeSet.h"
 #include "Libraries/MKHAbilitySystemLibrary.h"
+#include "Combat/LagCompensationSubsystem.h"
 #include "Data/CharacterClassInfo.h"
+#include "Equipment/EquipmentDefinition.h"
+#include "Equipment/EquipmentInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+
+namespace CharacterAnimation
+{
+	bool bServerMontageOnlyAnimation = true;
+	FAutoConsoleVariableRef CVarServerMontageOnlyAnimation(
+		TEXT("Makhia.Combat.ServerMontageOnlyAnimation"),
+		bServerMontageOnlyAnimation,
+		TEXT("Dedicated servers only tick character montages and evaluate poses on demand. Read when characters begin play."));
+}
 
 ACharacterBase::ACharacterBase()
 {
@@ -15,6 +30,16 @@ ACharacterBase::ACharacterBase()
 void ACharacterBase::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (ULagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULagCompensationSubsystem>(GetWorld()))
+		{
+			LagCompensation->RegisterPawn(this);
+		}
+	}
+
+	UpdateMeshAnimTickOption();
 }
 
 void ACharacterBase::Tick(float DeltaTime)
@@ -27,11 +52,155 @@ void ACharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
 }
 
+void ACharacterBase::AcquireServerPose()
+{
+	if (++NumServerPoseHolds == 1)
+	{
+		RefreshServerPose();
+		UpdateMeshAnimTickOption();
+	}
+}
+
+void ACharacterBase::ReleaseServerPose()
+{
+	if (ensure(NumServerPoseHolds > 0) && --NumServerPoseHolds == 0)
+	{
+		UpdateMeshAnimTickOption();
+	}
+}
+
+void ACharacterBase::RefreshServerPose()
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (!MeshComponent || MeshComponent->VisibilityBasedAnimTickOption != EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered)
+	{
+		return;
+	}
+
+	MeshComponent->TickAnimation(0.f, false);
+	MeshComponent->RefreshBoneTransforms();
+}
+
+void ACharacterBase::UpdateMeshAnimTickOption()
+{
+	// Everywhere else the mesh keeps the tick option it was configured with
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (!MeshComponent || !CharacterAnimation::bServerMontageOnlyAnimation || GetNetMode() != NM_DedicatedServer)
+	{
+		return;
+	}
+
+	MeshComponent->VisibilityBasedAnimTickOption = NumServerPoseHolds == 0
+		? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+		: EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+}
+
 UAbilitySystemComponent* ACharacterBase::GetAbilitySystemComponent() const
 {
 	return MKHAbilitySystemComponent;
 }
 
+void ACharacterBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ACharacterBase, EquippedVisuals, COND_SkipOwner);
+}
+
+void ACharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Attached equipment actors are not owned by the character's lifetime, clean up the local copies explicitly.
+	TArray<FGameplayTag> Slots;
+	LocalEquipmentVisuals.GetKeys(Slots);
+	for (const FGameplayTag& SlotTag : Slots)
+	{
+		DestroyLocalEquipmentVisual(SlotTag);
+	}
+
+	if (ULagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULagCompensationSubsystem>(GetWorld()))
+	{
+		LagCompensation->UnregisterPawn(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACharacterBase::SetEquippedVisual(const FGameplayTag& SlotTag, TSubclassOf<UEquipmentDefinition> EquipmentDefinition,
+	bool bSpawnActorsLocally)
+{
+	check(HasAuthority());
+
+	FEquippedVisual* Visual = EquippedVisuals.FindByPredicate([&SlotTag](const FEquippedVisual& Existing) { return Existing.SlotTag.MatchesTagExact(SlotTag); });
+	if (!Visual)
+	{
+		Visual = &EquippedVisuals.AddDefaulted_GetRef();
+		Visual->SlotTag = SlotTag;
+	}
+
+	Visual->EquipmentDefinition = EquipmentDefinition;
+	Visual->bSpawnActorsLocally = bSpawnActorsLocally;
+}
+
+void ACharacterBase::ClearEquippedVisual(const FGameplayTag& SlotTag)
+{
+	check(HasAuthority());
+
+	EquippedVisuals.RemoveAll([&SlotTag](const FEquippedVisual& Visual) { return Visual.SlotTag.MatchesTagExact(SlotTag); });
+}
+
+void ACharacterBase::OnRep_EquippedVisuals(const TArray<FEquippedVisual>& OldVisuals)
+{
+	for (const FEquippedVisual& OldVisual : OldVisuals)
+	{
+		const FEquippedVisual* NewVisual = EquippedVisuals.FindByPredicate([&OldVisual](const FEquippedVisual& Visual) { return Visual.SlotTag.MatchesTagExact(OldVisual.SlotTag); });
+		if (!NewVisual || NewVisual->EquipmentDefinition != OldVisual.EquipmentDefinition
+			|| NewVisual->bSpawnActorsLocally != OldVisual.bSpawnActorsLocally)
+		{
+			DestroyLocalEquipmentVisual(OldVisual.SlotTag);
+		}
+	}
+
+	for (const FEquippedVisual& Visual : EquippedVisuals)
+	{
+		if (!LocalEquipmentVisuals.Contains(Visual.SlotTag))
+		{
+			SpawnLocalEquipmentVisual(Visual);
+		}
+	}
+}
+
+void ACharacterBase::SpawnLocalEquipmentVisual(const FEquippedVisual& Visual)
+{
+	if (!Visual.EquipmentDefinition)
+	{
+		return;
+	}
+
+	const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(Visual.EquipmentDefinition);
+	TSubclassOf<UEquipmentInstance> InstanceType = EquipmentCDO->InstanceType;
+	if (!IsValid(InstanceType))
+	{
+		InstanceType = UEquipmentInstance::StaticClass();
+	}
+
+	UEquipmentInstance* Instance = NewObject<UEquipmentInstance>(this, InstanceType);
+	if (Visual.bSpawnActorsLocally)
+	{
+		Instance->SpawnEquipmentActors(EquipmentCDO->ActorsToSpawn, EquipmentCDO->BaseDamage, false);
+	}
+	Instance->AttachSkinnedMeshes(EquipmentCDO->SkinnedMeshes);
+	LocalEquipmentVisuals.Add(Visual.SlotTag, Instance);
+}
+
+void ACharacterBase::DestroyLocalEquipmentVisual(const FGameplayTag& SlotTag)
+{
+	TObjectPtr<UEquipmentInstance> Instance;
+	if (LocalEquipmentVisuals.RemoveAndCopyValue(SlotTag, Instance) && IsValid(Instance))
+	{
+		Instance->DestroySpawnedActors();
+	}
+}
+
 void ACharacterBase::InitAbilityActorInfo()
 {
 	// Blank for now
@@ -45,14 +214,35 @@ void ACharacterBase::BindCallbacksToDependencies()
 		MKHAbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(UMKHAttributeSet::GetHealthAttribute()).AddLambda(
 			[this](const FOnAttributeChangeData& Data)
 			{
-				OnHealthChanged.Broadcast(Data.OldValue, Data.NewValue, MKHAttributeSet->GetMaxHealth());
+				// Damage is broadcast once, from OnDamageResolved
+				if (!MKHAttributeSet->IsResolvingDamage())
+				{
+					OnHealthChanged.Broadcast(Data.OldValue, Data.NewValue, MKHAttributeSet->GetMaxHealth());
+				}
 			});
 
 		// Shield
 		MKHAbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(UMKHAttributeSet::GetShieldAttribute()).AddLambda(
 			[this](const FOnAttributeChangeData& Data)
 			{
-				OnShieldChanged.Broadcast(Data.OldValue, Data.NewValue, MKHAttributeSet->GetMaxShield());
+				if (!MKHAttributeSet->IsResolvingDamage())
+				{
+					OnShieldChanged.Broadcast(Data.OldValue, Data.NewValue, MKHAttributeSet->GetMaxShield());
+				}
+			});
+
+		// Damage (server): shield and health already hold their final values
+		MKHAttributeSet->OnDamageResolved.AddWeakLambda(this,
+			[this](const FMKHDamageResolution& Resolution)
+			{
+				if (Resolution.NewShield != Resolution.OldShield)
+				{
+					OnShieldChanged.Broadcast(Resolution.OldShield, Resolution.NewShield, MKHAttributeSet->GetMaxShield());
+				}
+				if (Resolution.NewHealth != Resolution.OldHealth)
+				{
+					OnHealthChanged.Broadcast(Resolution.OldHealth, Resolution.NewHealth, MKHAttributeSet->GetMaxHealth());
+				}
 			});
 	}
 }
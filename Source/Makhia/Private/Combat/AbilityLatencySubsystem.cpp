@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/AbilityLatencySubsystem.h"
+
+#include "Abilities/GameplayAbility.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace AbilityLatency
+{
+	bool bEnabled = true;
+	FAutoConsoleVariableRef CVarEnabled(
+		TEXT("Makhia.Ability.LatencyTracking"),
+		bEnabled,
+		TEXT("Records input-to-hit latency of abilities into per-ability histograms (Makhia.Ability.Latency, Makhia.Ability.LatencyDump)."));
+
+	/** A key press older than this when an ability activates is not what activated it. */
+	constexpr double MaxInputToActivationSeconds = 0.5;
+
+	const TCHAR* GetStageName(const EAbilityLatencyStage Stage)
+	{
+		switch (Stage)
+		{
+		case EAbilityLatencyStage::InputPressed:	return TEXT("InputPressed");
+		case EAbilityLatencyStage::Activated:		return TEXT("Activated");
+		case EAbilityLatencyStage::ServerConfirmed:	return TEXT("ServerConfirmed");
+		case EAbilityLatencyStage::HitScanStart:	return TEXT("HitScanStart");
+		case EAbilityLatencyStage::DamageApplied:	return TEXT("DamageApplied");
+		default:									return TEXT("Unknown");
+		}
+	}
+
+	const TCHAR* GetNetModeName(const UWorld* World)
+	{
+		switch (World->GetNetMode())
+		{
+		case NM_Client:				return TEXT("Client");
+		case NM_ListenServer:		return TEXT("ListenServer");
+		case NM_DedicatedServer:	return TEXT("DedicatedServer");
+		default:					return TEXT("Standalone");
+		}
+	}
+
+	/** Runs Func on the latency subsystem of every game world (client and server worlds in PIE). */
+	template<typename FuncType>
+	void ForEachSubsystem(FuncType&& Func)
+	{
+		if (!GEngine)
+		{
+			return;
+		}
+
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if (UAbilityLatencySubsystem* Subsystem = UWorld::GetSubsystem<UAbilityLatencySubsystem>(Context.World()))
+			{
+				Func(*Subsystem);
+			}
+		}
+	}
+
+	static FAutoConsoleCommandWithArgs LatencyCommand(
+		TEXT("Makhia.Ability.Latency"),
+		TEXT("Makhia.Ability.Latency [reset]: logs per-ability input-to-hit latency histograms of every game world, or clears them."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const bool bReset = Args.Num() > 0 && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase);
+			ForEachSubsystem([bReset](UAbilityLatencySubsystem& Subsystem)
+			{
+				if (bReset)
+				{
+					Subsystem.Reset();
+				}
+				else
+				{
+					Subsystem.LogHistograms();
+				}
+			});
+		}));
+
+	static FAutoConsoleCommand DumpCommand(
+		TEXT("Makhia.Ability.LatencyDump"),
+		TEXT("Writes the ability latency histograms of every game world to Saved/Telemetry as CSV."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			ForEachSubsystem([](const UAbilityLatencySubsystem& Subsystem)
+			{
+				const FString FilePath = Subsystem.DumpCsv();
+				if (!FilePath.IsEmpty())
+				{
+					UE_LOG(LogTemp, Display, TEXT("Ability latency written to %s"), *FilePath);
+				}
+			});
+		}));
+}
+
+void FAbilityLatencyHistogram::Add(const double Ms)
+{
+	const int32 Bucket = Ms < 1.0 ? 0 : FMath::Min(FMath::FloorLog2(static_cast<uint32>(Ms)) + 1, NumBuckets - 1);
+	++Buckets[Bucket];
+
+	MinMs = Count == 0 ? Ms : FMath::Min(MinMs, Ms);
+	MaxMs = Count == 0 ? Ms : FMath::Max(MaxMs, Ms);
+	SumMs += Ms;
+	++Count;
+}
+
+double FAbilityLatencyHistogram::GetPercentileMs(const double Percentile) const
+{
+	const int64 Rank = FMath::CeilToInt64(Count * FMath::Clamp(Percentile, 0.0, 1.0));
+	int64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Buckets[Bucket];
+		if (Seen >= Rank && Seen > 0)
+		{
+			return FMath::Min(GetBucketUpperMs(Bucket), MaxMs);
+		}
+	}
+	return MaxMs;
+}
+
+bool UAbilityLatencySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UAbilityLatencySubsystem* UAbilityLatencySubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!AbilityLatency::bEnabled || !WorldContextObject)
+	{
+		return nullptr;
+	}
+	return UWorld::GetSubsystem<UAbilityLatencySubsystem>(WorldContextObject->GetWorld());
+}
+
+void UAbilityLatencySubsystem::MarkInputPressed(const UObject* WorldContextObject)
+{
+	if (UAbilityLatencySubsystem* Subsystem = Get(WorldContextObject))
+	{
+		Subsystem->PendingInputTime = FPlatformTime::Seconds();
+	}
+}
+
+void UAbilityLatencySubsystem::MarkActivated(const UGameplayAbility* Ability, const FGameplayAbilityActivationInfo& ActivationInfo)
+{
+	UAbilityLatencySubsystem* Subsystem = Get(Ability);
+	if (!Subsystem || !Ability->IsInstantiated())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FPredictionKey ActivationKey = ActivationInfo.GetActivationPredictionKey();
+
+	FTimeline& Timeline = Subsystem->Timelines.FindOrAdd(FObjectKey(Ability));
+	Timeline = FTimeline();
+	Timeline.AbilityName = Ability->GetClass()->GetFName();
+	Timeline.PredictionKey = ActivationKey.Current;
+	Timeline.StartTime = Now;
+	Timeline.StageTimes[static_cast<int32>(EAbilityLatencyStage::Activated)] = Now;
+
+	// Only the machine that read the key press measures from it
+	const FGameplayAbilityActorInfo* ActorInfo = Ability->GetCurrentActorInfo();
+	const bool bLocallyControlled = ActorInfo && ActorInfo->IsLocallyControlled();
+	if (bLocallyControlled && Subsystem->PendingInputTime > 0.0 && Now - Subsystem->PendingInputTime <= AbilityLatency::MaxInputToActivationSeconds)
+	{
+		Timeline.StartTime = Subsystem->PendingInputTime;
+		Timeline.StageTimes[static_cast<int32>(EAbilityLatencyStage::InputPressed)] = Subsystem->PendingInputTime;
+		Subsystem->AddSample(Timeline.AbilityName, EAbilityLatencyStage::Activated, (Now - Timeline.StartTime) * 1000.0);
+	}
+	Subsystem->PendingInputTime = 0.0;
+
+	if (ActivationKey.IsLocalClientKey())
+	{
+		// Captured by value: the ability may end before the server catches up
+		ActivationKey.NewCaughtUpDelegate().BindWeakLambda(Subsystem, [Subsystem, AbilityName = Timeline.AbilityName, StartTime = Timeline.StartTime]()
+		{
+			Subsystem->AddSample(AbilityName, EAbilityLatencyStage::ServerConfirmed, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		});
+	}
+}
+
+void UAbilityLatencySubsystem::MarkStage(const UGameplayAbility* Ability, const EAbilityLatencyStage Stage)
+{
+	UAbilityLatencySubsystem* Subsystem = Get(Ability);
+	FTimeline* Timeline = Subsystem ? Subsystem->Timelines.Find(FObjectKey(Ability)) : nullptr;
+	if (!Timeline || Timeline->PredictionKey != Ability->GetCurrentActivationInfo().GetActivationPredictionKey().Current)
+	{
+		return;
+	}
+
+	double& StageTime = Timeline->StageTimes[static_cast<int32>(Stage)];
+	if (StageTime > 0.0)
+	{
+		return;
+	}
+
+	StageTime = FPlatformTime::Seconds();
+	Subsystem->AddSample(Timeline->AbilityName, Stage, (StageTime - Timeline->StartTime) * 1000.0);
+}
+
+void UAbilityLatencySubsystem::EndTimeline(const UGameplayAbility* Ability)
+{
+	if (UAbilityLatencySubsystem* Subsystem = Get(Ability))
+	{
+		Subsystem->Timelines.Remove(FObjectKey(Ability));
+	}
+}
+
+void UAbilityLatencySubsystem::AddSample(const FName AbilityName, const EAbilityLatencyStage Stage, const double Ms)
+{
+	Histograms.FindOrAdd(AbilityName).Stages[static_cast<int32>(Stage)].Add(Ms);
+}
+
+void UAbilityLatencySubsystem::Reset()
+{
+	Histograms.Reset();
+}
+
+void UAbilityLatencySubsystem::LogHistograms() const
+{
+	const UWorld* World = GetWorld();
+	UE_LOG(LogTemp, Display, TEXT("Ability latency (%s, %s): ms since key press on the owning client, since activation on the server"),
+		*GetNameSafe(World), AbilityLatency::GetNetModeName(World));
+
+	for (const TPair<FName, FAbilityHistograms>& Pair : Histograms)
+	{
+		for (int32 Stage = 0; Stage < static_cast<int32>(EAbilityLatencyStage::Count); ++Stage)
+		{
+			const FAbilityLatencyHistogram& Histogram = Pair.Value.Stages[Stage];
+			if (Histogram.Count == 0)
+			{
+				continue;
+			}
+
+			UE_LOG(LogTemp, Display, TEXT("  %-32s %-16s n=%-6lld min %6.1f  mean %6.1f  p50 <%5.0f  p90 <%5.0f  p99 <%5.0f  max %6.1f"),
+				*Pair.Key.ToString(), AbilityLatency::GetStageName(static_cast<EAbilityLatencyStage>(Stage)), Histogram.Count,
+				Histogram.MinMs, Histogram.SumMs / Histogram.Count, Histogram.GetPercentileMs(0.5), Histogram.GetPercentileMs(0.9),
+				Histogram.GetPercentileMs(0.99), Histogram.MaxMs);
+		}
+	}
+}
+
+FString UAbilityLatencySubsystem::DumpCsv() const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return FString();
+	}
+
+	TStringBuilder<4096> Csv;
+	Csv << TEXT("Ability,Stage,Count,MinMs,MeanMs,P50Ms,P90Ms,P99Ms,MaxMs");
+	for (int32 Bucket = 0; Bucket < FAbilityLatencyHistogram::NumBuckets; ++Bucket)
+	{
+		Csv.Appendf(TEXT(",Below%.0fMs"), FAbilityLatencyHistogram::GetBucketUpperMs(Bucket));
+	}
+	Csv << TEXT("\n");
+
+	for (const TPair<FName, FAbilityHistograms>& Pair : Histograms)
+	{
+		for (int32 Stage = 0; Stage < static_cast<int32>(EAbilityLatencyStage::Count); ++Stage)
+		{
+			const FAbilityLatencyHistogram& Histogram = Pair.Value.Stages[Stage];
+			if (Histogram.Count == 0)
+			{
+				continue;
+			}
+
+			Csv.Appendf(TEXT("%s,%s,%lld,%.3f,%.3f,%.0f,%.0f,%.0f,%.3f"),
+				*Pair.Key.ToString(), AbilityLatency::GetStageName(static_cast<EAbilityLatencyStage>(Stage)), Histogram.Count,
+				Histogram.MinMs, Histogram.SumMs / Histogram.Count, Histogram.GetPercentileMs(0.5), Histogram.GetPercentileMs(0.9),
+				Histogram.GetPercentileMs(0.99), Histogram.MaxMs);
+			for (const int64 BucketCount : Histogram.Buckets)
+			{
+				Csv.Appendf(TEXT(",%lld"), BucketCount);
+			}
+			Csv << TEXT("\n");
+		}
+	}
+
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*Directory);
+
+	const FString FilePath = Directory / FString::Printf(TEXT("AbilityLatency-%s-%s.csv"), AbilityLatency::GetNetModeName(World), *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Csv.ToView(), *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Ability latency: could not write %s"), *FilePath);
+		return FString();
+	}
+	return FilePath;
+}
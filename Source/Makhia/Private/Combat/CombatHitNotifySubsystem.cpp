@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatHitNotifySubsystem.h"
+
+#include "AbilitySystem/Attributes/MKHAttributeSet.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Libraries/MKHAbilitySystemLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combat Hit Batch Flush"), STAT_CombatHitBatchFlush, STATGROUP_Game);
+
+namespace CombatHitNotify
+{
+	int32 MaxHitsPerBatch = 256;
+	FAutoConsoleVariableRef CVarMaxHitsPerBatch(
+		TEXT("Makhia.Combat.MaxHitsPerBatch"),
+		MaxHitsPerBatch,
+		TEXT("Hits sent in one multicast per frame; the rest go out on the following frames. Clamped to the receive limits of FMKHHitBatch."));
+}
+
+void UCombatHitNotifySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	NetRelay = InWorld.SpawnActor<AMKHCombatNetRelay>(SpawnParams);
+	if (NetRelay)
+	{
+		NetRelay->SetProjectileInfo(UMKHAbilitySystemLibrary::GetProjectileInfo(NetRelay));
+	}
+}
+
+void UCombatHitNotifySubsystem::Deinitialize()
+{
+	PendingHits.Reset();
+	NetRelay = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UCombatHitNotifySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatHitNotifySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatHitNotifySubsystem, STATGROUP_Tickables);
+}
+
+void UCombatHitNotifySubsystem::QueueHit(AActor* Target, const FMKHDamageResolution& Resolution, const bool bCriticalHit)
+{
+	if (!IsValid(Target) || !NetRelay)
+	{
+		return;
+	}
+
+	FPendingHit& Hit = PendingHits.AddDefaulted_GetRef();
+	Hit.Target = Target;
+	Hit.Damage = Resolution.Damage;
+	Hit.bCriticalHit = bCriticalHit;
+	Hit.bShieldBroken = Resolution.bShieldBroken;
+}
+
+void UCombatHitNotifySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!PendingHits.IsEmpty())
+	{
+		FlushPendingHits();
+	}
+}
+
+void UCombatHitNotifySubsystem::FlushPendingHits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatHitBatchFlush);
+
+	if (!IsValid(NetRelay))
+	{
+		PendingHits.Reset();
+		return;
+	}
+
+	const int32 MaxHits = FMath::Clamp(CombatHitNotify::MaxHitsPerBatch, 1, FMKHHitBatch::MaxHits);
+
+	FMKHHitBatch Batch;
+	Batch.Hits.Reserve(FMath::Min(PendingHits.Num(), MaxHits));
+
+	// Each target goes into the table once; hits only carry its index
+	TMap<AActor*, uint16, TInlineSetAllocator<32>> TargetIndices;
+
+	int32 NumConsumed = 0;
+	for (; NumConsumed < PendingHits.Num() && Batch.Hits.Num() < MaxHits; ++NumConsumed)
+	{
+		const FPendingHit& Pending = PendingHits[NumConsumed];
+		AActor* Target = Pending.Target.Get();
+		if (!Target)
+		{
+			continue;
+		}
+
+		const uint16* ExistingIndex = TargetIndices.Find(Target);
+		if (!ExistingIndex && Batch.Targets.Num() >= FMKHHitBatch::MaxTargets)
+		{
+			break;
+		}
+
+		uint16 TargetIndex;
+		if (ExistingIndex)
+		{
+			TargetIndex = *ExistingIndex;
+		}
+		else
+		{
+			TargetIndex = static_cast<uint16>(Batch.Targets.Add(Target));
+			TargetIndices.Add(Target, TargetIndex);
+		}
+
+		FMKHHitBatch::FHit& Hit = Batch.Hits.AddDefaulted_GetRef();
+		Hit.TargetIndex = TargetIndex;
+		Hit.Damage = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Pending.Damage), 0, MAX_uint16));
+		Hit.bCriticalHit = Pending.bCriticalHit;
+		Hit.bShieldBroken = Pending.bShieldBroken;
+	}
+
+	PendingHits.RemoveAt(0, NumConsumed, EAllowShrinking::No);
+
+	if (!Batch.Hits.IsEmpty())
+	{
+		NetRelay->MulticastHitBatch(Batch);
+		NetRelay->ForceNetUpdate();
+	}
+}
+
+void UCombatHitNotifySubsystem::DispatchHitBatch(const FMKHHitBatch& Batch)
+{
+	if (!OnCombatHit.IsBound())
+	{
+		return;
+	}
+
+	for (const FMKHHitBatch::FHit& Hit : Batch.Hits)
+	{
+		AActor* Target = Batch.Targets.IsValidIndex(Hit.TargetIndex) ? Batch.Targets[Hit.TargetIndex].Get() : nullptr;
+		if (IsValid(Target))
+		{
+			OnCombatHit.Broadcast(Target, Hit.Damage, Hit.bCriticalHit, Hit.bShieldBroken);
+		}
+	}
+}
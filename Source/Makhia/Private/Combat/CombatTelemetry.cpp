@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatTelemetry.h"
+
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+std::atomic<bool> FCombatTelemetry::bEnabled = false;
+
+namespace CombatTelemetry
+{
+	int32 Enabled = 0;
+	FAutoConsoleVariableRef CVarEnabled(
+		TEXT("Makhia.Combat.Telemetry"),
+		Enabled,
+		TEXT("1 writes every resolved hit to Saved/Telemetry/CombatTelemetry-<date>.csv from a background thread, 0 stops and closes the file."),
+		FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Variable)
+		{
+			if (Variable->GetInt() != 0)
+			{
+				FCombatTelemetry::Get().Start();
+			}
+			else
+			{
+				FCombatTelemetry::Get().Stop();
+			}
+		}));
+}
+
+FCombatTelemetry& FCombatTelemetry::Get()
+{
+	static FCombatTelemetry Instance;
+	return Instance;
+}
+
+void FCombatTelemetry::Record(const FCombatTelemetryRecord& Record)
+{
+	checkSlow(IsInGameThread());
+
+	const uint64 Write = WriteIndex.load(std::memory_order_relaxed);
+	if (Write - ReadIndex.load(std::memory_order_acquire) >= Capacity)
+	{
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Records[Write & (Capacity - 1)] = Record;
+	WriteIndex.store(Write + 1, std::memory_order_release);
+}
+
+void FCombatTelemetry::Start()
+{
+	if (Thread)
+	{
+		return;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	const FString FilePath = Directory / FString::Printf(TEXT("CombatTelemetry-%s.csv"), *FDateTime::Now().ToString());
+	File.Reset(PlatformFile.OpenWrite(*FilePath));
+	if (!File)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Combat telemetry: could not open %s"), *FilePath);
+		return;
+	}
+
+	const FTCHARToUTF8 Header(TEXT("Time,Source,Target,Ability,BaseDamage,FinalDamage,Crit,ShieldAbsorbed,HealthLost\n"));
+	File->Write(reinterpret_cast<const uint8*>(Header.Get()), Header.Length());
+
+	if (!Records)
+	{
+		Records = MakeUnique<FCombatTelemetryRecord[]>(Capacity);
+
+		// The thread must not outlive the engine, whoever forgot to turn telemetry off
+		FCoreDelegates::OnEnginePreExit.AddLambda([]()
+		{
+			FCombatTelemetry::Get().Stop();
+		});
+	}
+
+	WriteIndex.store(0, std::memory_order_relaxed);
+	ReadIndex.store(0, std::memory_order_relaxed);
+	NumDropped.store(0, std::memory_order_relaxed);
+	bStopping.store(false, std::memory_order_relaxed);
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("CombatTelemetryWriter"), 0, TPri_BelowNormal);
+
+	bEnabled.store(true, std::memory_order_relaxed);
+	UE_LOG(LogTemp, Log, TEXT("Combat telemetry: writing to %s"), *FilePath);
+}
+
+void FCombatTelemetry::Stop()
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	// Producers are on the game thread, like this call, so nothing is mid-Record past this point
+	bEnabled.store(false, std::memory_order_relaxed);
+
+	bStopping.store(true, std::memory_order_release);
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+
+	File.Reset();
+
+	UE_LOG(LogTemp, Log, TEXT("Combat telemetry: stopped, %llu records written, %llu dropped"),
+		WriteIndex.load(std::memory_order_relaxed), GetNumDropped());
+}
+
+uint32 FCombatTelemetry::Run()
+{
+	while (!bStopping.load(std::memory_order_acquire))
+	{
+		WakeEvent->Wait(FlushIntervalMs);
+		Drain();
+	}
+
+	Drain();
+	return 0;
+}
+
+void FCombatTelemetry::Drain()
+{
+	uint64 Read = ReadIndex.load(std::memory_order_relaxed);
+	const uint64 Write = WriteIndex.load(std::memory_order_acquire);
+	if (Read == Write)
+	{
+		return;
+	}
+
+	FString Chunk;
+	Chunk.Reserve(static_cast<int32>(Write - Read) * 96);
+
+	for (; Read != Write; ++Read)
+	{
+		const FCombatTelemetryRecord& Entry = Records[Read & (Capacity - 1)];
+		Chunk += FString::Printf(TEXT("%.3f,%s,%s,%s,%.2f,%.2f,%d,%.2f,%.2f\n"),
+			Entry.Timestamp, *Entry.Source.ToString(), *Entry.Target.ToString(), *Entry.Ability.ToString(),
+			Entry.BaseDamage, Entry.FinalDamage, Entry.bCriticalHit ? 1 : 0, Entry.ShieldAbsorbed, Entry.HealthLost);
+	}
+
+	// Slots are free again once their content has been formatted
+	ReadIndex.store(Read, std::memory_order_release);
+
+	const FTCHARToUTF8 Utf8(*Chunk);
+	File->Write(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	File->Flush();
+}
@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/LagCompensationSubsystem.h"
+
+#include "Algo/Sort.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_LagCompensationRecord, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Sweep"), STAT_LagCompensationSweep, STATGROUP_Game);
+
+namespace LagCompensation
+{
+	bool bEnabled = true;
+	FAutoConsoleVariableRef CVarEnabled(
+		TEXT("Makhia.LagComp.Enabled"),
+		bEnabled,
+		TEXT("Rewinds pawns to the attacker's view time during melee hit scans. When off, hit scans test current positions."));
+
+	float MaxRewindMs = 200.f;
+	FAutoConsoleVariableRef CVarMaxRewindMs(
+		TEXT("Makhia.LagComp.MaxRewindMs"),
+		MaxRewindMs,
+		TEXT("Longest rewind accepted from a client, in milliseconds. Bounds how far into the past a laggy or lying client can hit."));
+
+	constexpr int32 InitialSlotCapacity = 128;
+}
+
+float ULagCompensationSubsystem::GetMaxRewindSeconds()
+{
+	return LagCompensation::bEnabled ? FMath::Max(LagCompensation::MaxRewindMs, 0.f) * 0.001f : 0.f;
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	Capsules.Empty();
+	Radii.Empty();
+	FreeSlots.Empty();
+	SlotsByPawn.Empty();
+	Locations.Empty();
+	HalfHeights.Empty();
+	Valid.Empty();
+	SlotCapacity = 0;
+	NewestFrame = INDEX_NONE;
+	NumRecordedFrames = 0;
+
+	Super::Deinitialize();
+}
+
+bool ULagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterPawn(APawn* Pawn)
+{
+	UCapsuleComponent* Capsule = IsValid(Pawn) ? Cast<UCapsuleComponent>(Pawn->GetRootComponent()) : nullptr;
+	if (!Capsule || SlotsByPawn.Contains(Pawn))
+	{
+		return;
+	}
+
+	if (FreeSlots.IsEmpty())
+	{
+		const int32 OldCapacity = SlotCapacity;
+		SetSlotCapacity(FMath::Max(OldCapacity * 2, LagCompensation::InitialSlotCapacity));
+		for (int32 Slot = SlotCapacity - 1; Slot >= OldCapacity; --Slot)
+		{
+			FreeSlots.Add(Slot);
+		}
+	}
+
+	const int32 Slot = FreeSlots.Pop(EAllowShrinking::No);
+	Capsules[Slot] = Capsule;
+	Radii[Slot] = Capsule->GetScaledCapsuleRadius();
+	SlotsByPawn.Add(Pawn, Slot);
+}
+
+void ULagCompensationSubsystem::UnregisterPawn(APawn* Pawn)
+{
+	int32 Slot = INDEX_NONE;
+	if (!SlotsByPawn.RemoveAndCopyValue(Pawn, Slot))
+	{
+		return;
+	}
+
+	Capsules[Slot] = nullptr;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Valid[HistoryIndex(Frame, Slot)] = false;
+	}
+	FreeSlots.Add(Slot);
+}
+
+void ULagCompensationSubsystem::SetSlotCapacity(const int32 NewCapacity)
+{
+	TArray<FVector> NewLocations;
+	TArray<float> NewHalfHeights;
+	TBitArray<> NewValid(false, NumFrames * NewCapacity);
+	NewLocations.SetNumZeroed(NumFrames * NewCapacity);
+	NewHalfHeights.SetNumZeroed(NumFrames * NewCapacity);
+
+	for (int32 Frame = 0; Frame < NumFrames && SlotCapacity > 0; ++Frame)
+	{
+		FMemory::Memcpy(&NewLocations[Frame * NewCapacity], &Locations[HistoryIndex(Frame, 0)], SlotCapacity * sizeof(FVector));
+		FMemory::Memcpy(&NewHalfHeights[Frame * NewCapacity], &HalfHeights[HistoryIndex(Frame, 0)], SlotCapacity * sizeof(float));
+		for (int32 Slot = 0; Slot < SlotCapacity; ++Slot)
+		{
+			NewValid[Frame * NewCapacity + Slot] = Valid[HistoryIndex(Frame, Slot)];
+		}
+	}
+
+	Locations = MoveTemp(NewLocations);
+	HalfHeights = MoveTemp(NewHalfHeights);
+	Valid = MoveTemp(NewValid);
+	Capsules.SetNum(NewCapacity);
+	Radii.SetNumZeroed(NewCapacity);
+	SlotCapacity = NewCapacity;
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const UWorld* World = GetWorld();
+	if (SlotsByPawn.IsEmpty() || !World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	RecordFrame(World->GetTimeSeconds());
+}
+
+void ULagCompensationSubsystem::RecordFrame(const double Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	NewestFrame = (NewestFrame + 1) % NumFrames;
+	NumRecordedFrames = FMath::Min(NumRecordedFrames + 1, NumFrames);
+	FrameTimes[NewestFrame] = Time;
+
+	FVector* FrameLocations = &Locations[HistoryIndex(NewestFrame, 0)];
+	float* FrameHalfHeights = &HalfHeights[HistoryIndex(NewestFrame, 0)];
+
+	for (int32 Slot = 0; Slot < SlotCapacity; ++Slot)
+	{
+		const UCapsuleComponent* Capsule = Capsules[Slot].Get();
+		Valid[HistoryIndex(NewestFrame, Slot)] = Capsule != nullptr;
+		if (Capsule)
+		{
+			FrameLocations[Slot] = Capsule->GetComponentLocation();
+			FrameHalfHeights[Slot] = Capsule->GetScaledCapsuleHalfHeight();
+		}
+	}
+}
+
+ULagCompensationSubsystem::FRewindFrames ULagCompensationSubsystem::FindRewindFrames(const double Time) const
+{
+	// Walk back from the newest frame to the first one recorded at or before Time
+	FRewindFrames Frames;
+	for (int32 Age = 0; Age < NumRecordedFrames; ++Age)
+	{
+		const int32 Frame = (NewestFrame - Age + NumFrames) % NumFrames;
+		if (FrameTimes[Frame] <= Time)
+		{
+			Frames.Older = Frame;
+			break;
+		}
+		Frames.Newer = Frame;
+	}
+
+	if (Frames.Older != INDEX_NONE && Frames.Newer != INDEX_NONE)
+	{
+		const double Span = FrameTimes[Frames.Newer] - FrameTimes[Frames.Older];
+		Frames.Alpha = Span > UE_DOUBLE_SMALL_NUMBER ? static_cast<float>((Time - FrameTimes[Frames.Older]) / Span) : 1.f;
+	}
+	return Frames;
+}
+
+bool ULagCompensationSubsystem::SampleSlot(const int32 Slot, const FRewindFrames& Frames, FVector& OutLocation, float& OutHalfHeight) const
+{
+	const int32 Older = Frames.Older;
+	const int32 Newer = Frames.Newer;
+	const bool bOlderValid = Older != INDEX_NONE && Valid[HistoryIndex(Older, Slot)];
+	const bool bNewerValid = Newer != INDEX_NONE && Valid[HistoryIndex(Newer, Slot)];
+
+	if (bOlderValid && bNewerValid)
+	{
+		OutLocation = FMath::Lerp(Locations[HistoryIndex(Older, Slot)], Locations[HistoryIndex(Newer, Slot)], Frames.Alpha);
+		OutHalfHeight = FMath::Lerp(HalfHeights[HistoryIndex(Older, Slot)], HalfHeights[HistoryIndex(Newer, Slot)], Frames.Alpha);
+		return true;
+	}
+
+	// Before the oldest frame, or the pawn spawned in between: use the closest frame it has
+	const int32 Frame = bOlderValid ? Older : (bNewerValid ? Newer : INDEX_NONE);
+	if (Frame == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutLocation = Locations[HistoryIndex(Frame, Slot)];
+	OutHalfHeight = HalfHeights[HistoryIndex(Frame, Slot)];
+	return true;
+}
+
+bool ULagCompensationSubsystem::IsRecorded(const AActor* Actor) const
+{
+	const APawn* Pawn = Cast<APawn>(Actor);
+	return Pawn && SlotsByPawn.Contains(Pawn);
+}
+
+bool ULagCompensationSubsystem::SweepRewound(const FVector& Start, const FVector& End, const float Radius, const float ViewDelay,
+	const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationSweep);
+
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	const float RewindSeconds = FMath::Clamp(ViewDelay, 0.f, GetMaxRewindSeconds());
+	const double Time = World->GetTimeSeconds() - RewindSeconds;
+	const bool bRewind = RewindSeconds > 0.f && NewestFrame != INDEX_NONE && Time < FrameTimes[NewestFrame];
+	const FRewindFrames Frames = bRewind ? FindRewindFrames(Time) : FRewindFrames();
+
+	const FVector SweepCenter = (Start + End) * 0.5;
+	const double SweepBound = (End - Start).Size() * 0.5 + Radius;
+	const double SweepLength = (End - Start).Size();
+	const int32 FirstHit = OutHits.Num();
+
+	for (int32 Slot = 0; Slot < SlotCapacity; ++Slot)
+	{
+		UCapsuleComponent* Capsule = Capsules[Slot].Get();
+		AActor* Owner = Capsule ? Capsule->GetOwner() : nullptr;
+		if (!Owner || Owner == IgnoreActor)
+		{
+			continue;
+		}
+
+		FVector Location;
+		float HalfHeight;
+		if (!bRewind || !SampleSlot(Slot, Frames, Location, HalfHeight))
+		{
+			Location = Capsule->GetComponentLocation();
+			HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		}
+
+		const float CapsuleRadius = Radii[Slot];
+		if (FVector::DistSquared(SweepCenter, Location) > FMath::Square(SweepBound + HalfHeight + CapsuleRadius))
+		{
+			continue;
+		}
+
+		// Capsules stay upright: test the sweep segment against the capsule's vertical core segment
+		const FVector Core(0.f, 0.f, FMath::Max(HalfHeight - CapsuleRadius, 0.f));
+		FVector OnCore;
+		FVector OnSweep;
+		FMath::SegmentDistToSegmentSafe(Location - Core, Location + Core, Start, End, OnCore, OnSweep);
+
+		if (FVector::DistSquared(OnCore, OnSweep) > FMath::Square(CapsuleRadius + Radius))
+		{
+			continue;
+		}
+
+		const FVector Normal = (OnSweep - OnCore).GetSafeNormal(UE_SMALL_NUMBER, (Start - End).GetSafeNormal());
+		FHitResult& Hit = OutHits.Emplace_GetRef(Owner, Capsule, OnSweep, Normal);
+		Hit.ImpactPoint = OnCore + Normal * CapsuleRadius;
+		Hit.ImpactNormal = Normal;
+		Hit.TraceStart = Start;
+		Hit.TraceEnd = End;
+		Hit.Distance = (OnSweep - Start).Size();
+		Hit.Time = SweepLength > UE_SMALL_NUMBER ? Hit.Distance / SweepLength : 0.f;
+		Hit.bBlockingHit = false;
+	}
+
+	if (OutHits.Num() - FirstHit > 1)
+	{
+		Algo::Sort(MakeArrayView(OutHits.GetData() + FirstHit, OutHits.Num() - FirstHit), [](const FHitResult& A, const FHitResult& B)
+		{
+			return A.Time < B.Time;
+		});
+	}
+
+	return OutHits.Num() > FirstHit;
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/MKHCombatNetRelay.h"
+
+#include "Combat/CombatHitNotifySubsystem.h"
+#include "Data/ProjectileInfo.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "Projectiles/ProjectileSimulationSubsystem.h"
+
+bool FMKHHitBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 NumTargets = Targets.Num();
+	Ar.SerializeIntPacked(NumTargets);
+	if (NumTargets > MaxTargets)
+	{
+		bOutSuccess = false;
+		return true;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Targets.SetNum(NumTargets);
+	}
+	for (TObjectPtr<AActor>& Target : Targets)
+	{
+		UObject* TargetObject = Target;
+		Ar << TargetObject;
+		Target = Cast<AActor>(TargetObject);
+	}
+
+	uint32 NumHits = Hits.Num();
+	Ar.SerializeIntPacked(NumHits);
+	if (NumHits > MaxHits)
+	{
+		bOutSuccess = false;
+		return true;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Hits.SetNum(NumHits);
+	}
+	for (FHit& Hit : Hits)
+	{
+		uint32 TargetIndex = Hit.TargetIndex;
+		Ar.SerializeInt(TargetIndex, FMath::Max<uint32>(NumTargets, 1));
+
+		uint32 Damage = Hit.Damage;
+		Ar.SerializeIntPacked(Damage);
+
+		uint8 Flags = (Hit.bCriticalHit ? 1 : 0) | (Hit.bShieldBroken ? 2 : 0);
+		Ar.SerializeBits(&Flags, 2);
+
+		if (Ar.IsLoading())
+		{
+			Hit.TargetIndex = static_cast<uint16>(TargetIndex);
+			Hit.Damage = static_cast<uint16>(FMath::Min<uint32>(Damage, MAX_uint16));
+			Hit.bCriticalHit = (Flags & 1) != 0;
+			Hit.bShieldBroken = (Flags & 2) != 0;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+AMKHCombatNetRelay::AMKHCombatNetRelay()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+
+	// Only the projectile table replicates, once; senders call ForceNetUpdate so queued multicasts go out on the next net tick.
+	SetNetUpdateFrequency(1.f);
+}
+
+void AMKHCombatNetRelay::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AMKHCombatNetRelay, ProjectileInfo, COND_InitialOnly);
+}
+
+void AMKHCombatNetRelay::MulticastHitBatch_Implementation(const FMKHHitBatch& Batch)
+{
+	if (UCombatHitNotifySubsystem* HitNotifies = UWorld::GetSubsystem<UCombatHitNotifySubsystem>(GetWorld()))
+	{
+		HitNotifies->DispatchHitBatch(Batch);
+	}
+}
+
+void AMKHCombatNetRelay::MulticastProjectileVolleys_Implementation(const TArray<FMKHProjectileVolley>& Volleys)
+{
+	if (UProjectileSimulationSubsystem* Simulation = UWorld::GetSubsystem<UProjectileSimulationSubsystem>(GetWorld()))
+	{
+		Simulation->ReceiveVolleys(Volleys, ProjectileInfo);
+	}
+}
+
+void AMKHCombatNetRelay::MulticastProjectileImpacts_Implementation(const TArray<FMKHProjectileImpact>& Impacts)
+{
+	if (UProjectileSimulationSubsystem* Simulation = UWorld::GetSubsystem<UProjectileSimulationSubsystem>(GetWorld()))
+	{
+		Simulation->ReceiveImpacts(Impacts);
+	}
+}
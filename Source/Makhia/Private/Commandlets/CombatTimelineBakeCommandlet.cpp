@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/CombatTimelineBakeCommandlet.h"
+
+#include "AbilitySystem/Abilities/MKHDamageAbility.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UCombatTimelineBakeCommandlet::UCombatTimelineBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCombatTimelineBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> BlueprintAssets;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetClassPathName(), BlueprintAssets, true);
+
+	int32 NumAbilities = 0;
+	int32 NumSaved = 0;
+	int32 NumFailed = 0;
+
+	for (const FAssetData& AssetData : BlueprintAssets)
+	{
+		// Skip unrelated blueprints without loading them
+		const FString NativeParentPath = AssetData.GetTagValueRef<FString>(FBlueprintTags::NativeParentClassPath);
+		const UClass* NativeParent = NativeParentPath.IsEmpty() ? nullptr : FindObject<UClass>(nullptr, *FPackageName::ExportTextPathToObjectPath(NativeParentPath));
+		if (!NativeParent || !NativeParent->IsChildOf(UMKHDamageAbility::StaticClass()))
+		{
+			continue;
+		}
+
+		UBlueprint* Blueprint = Cast<UBlueprint>(AssetData.GetAsset());
+		UMKHDamageAbility* Ability = Blueprint && Blueprint->GeneratedClass ? Blueprint->GeneratedClass->GetDefaultObject<UMKHDamageAbility>() : nullptr;
+		if (!Ability)
+		{
+			UE_LOG(LogTemp, Error, TEXT("CombatTimelineBake - Failed to load %s"), *AssetData.GetObjectPathString());
+			++NumFailed;
+			continue;
+		}
+
+		++NumAbilities;
+
+		const FMKHCombatTimeline PreviousTimeline = Ability->GetCombatTimeline();
+
+		TArray<FString> Errors;
+		if (!Ability->BakeCombatTimeline(Errors))
+		{
+			for (const FString& Error : Errors)
+			{
+				UE_LOG(LogTemp, Error, TEXT("CombatTimelineBake - %s"), *Error);
+			}
+			++NumFailed;
+		}
+
+		if (Ability->GetCombatTimeline() == PreviousTimeline)
+		{
+			continue;
+		}
+
+		UPackage* Package = Blueprint->GetPackage();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		if (!UPackage::SavePackage(Package, Blueprint, *Filename, SaveArgs))
+		{
+			UE_LOG(LogTemp, Error, TEXT("CombatTimelineBake - Failed to save %s"), *Filename);
+			++NumFailed;
+			continue;
+		}
+
+		++NumSaved;
+		UE_LOG(LogTemp, Display, TEXT("CombatTimelineBake - Baked %s (%d events)"), *AssetData.GetObjectPathString(), Ability->GetCombatTimeline().Events.Num());
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("CombatTimelineBake - %d damage abilities, %d saved, %d failed"), NumAbilities, NumSaved, NumFailed);
+	return NumFailed == 0 ? 0 : 1;
+#else
+	return 1;
+#endif
+}
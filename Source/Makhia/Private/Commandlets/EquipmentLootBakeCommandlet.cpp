@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/EquipmentLootBakeCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Data/EquipmentLootTable.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UEquipmentLootBakeCommandlet::UEquipmentLootBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UEquipmentLootBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> LootTableAssets;
+	AssetRegistry.GetAssetsByClass(UEquipmentLootTable::StaticClass()->GetClassPathName(), LootTableAssets, true);
+
+	int32 NumFailed = 0;
+
+	for (const FAssetData& AssetData : LootTableAssets)
+	{
+		UEquipmentLootTable* LootTable = Cast<UEquipmentLootTable>(AssetData.GetAsset());
+		if (!LootTable)
+		{
+			UE_LOG(LogTemp, Error, TEXT("EquipmentLootBake - Failed to load %s"), *AssetData.GetObjectPathString());
+			++NumFailed;
+			continue;
+		}
+
+		TArray<FString> Errors;
+		if (!LootTable->Bake(Errors))
+		{
+			for (const FString& Error : Errors)
+			{
+				UE_LOG(LogTemp, Error, TEXT("EquipmentLootBake - %s"), *Error);
+			}
+			++NumFailed;
+			continue;
+		}
+
+		UPackage* Package = LootTable->GetPackage();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		if (!UPackage::SavePackage(Package, LootTable, *Filename, SaveArgs))
+		{
+			UE_LOG(LogTemp, Error, TEXT("EquipmentLootBake - Failed to save %s"), *Filename);
+			++NumFailed;
+			continue;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("EquipmentLootBake - Baked %s"), *AssetData.GetObjectPathString());
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("EquipmentLootBake - %d loot tables, %d failed"), LootTableAssets.Num(), NumFailed);
+	return NumFailed == 0 ? 0 : 1;
+#else
+	return 1;
+#endif
+}
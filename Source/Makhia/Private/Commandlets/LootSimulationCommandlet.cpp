@@ -0,0 +1,325 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/LootSimulationCommandlet.h"
+
+#include "AbilitySystem/MKHGameplayTags.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Data/EquipmentLootTable.h"
+#include "Data/EquipmentStatEffects.h"
+#include "Engine/DataTable.h"
+#include "Equipment/EquipmentDefinition.h"
+#include "Equipment/Rarity/RarityDefinition.h"
+#include "HAL/PlatformTime.h"
+#include "Inventory/ItemTypes.h"
+#include "Inventory/ItemTypesToTables.h"
+#include "Libraries/EquipmentRollLibrary.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace LootSimulation
+{
+	constexpr int32 NumValueBins = 20;
+
+	/** Rolls are split into this many chunks whatever the core count, so a seed gives the same results on every machine. */
+	constexpr int32 MaxChunks = 1024;
+
+	/** Selection count and value distribution of one stat. */
+	struct FStatHistogram
+	{
+		float MinStatLevel = 0.f;
+		float MaxStatLevel = 0.f;
+		int64 Count = 0;
+		double Sum = 0.0;
+		int64 Bins[NumValueBins] = {};
+	};
+
+	/** Everything one ParallelFor chunk accumulates; merged on the game thread afterwards. */
+	struct FChunkResult
+	{
+		int64 NumItems = 0;
+		int64 NumStats = 0;
+		int64 NumAbilities = 0;
+		TMap<FGameplayTag, int64> RarityCounts;
+		TMap<FGameplayTag, int64> AbilityCounts;
+		TMap<FGameplayTag, FStatHistogram> Stats;
+	};
+
+	void AddStat(FChunkResult& Result, const FEquipmentStatEffectDefinition& Stat)
+	{
+		FStatHistogram& Histogram = Result.Stats.FindOrAdd(Stat.StatEffectTag);
+		Histogram.MinStatLevel = Stat.MinStatLevel;
+		Histogram.MaxStatLevel = Stat.MaxStatLevel;
+		++Histogram.Count;
+		Histogram.Sum += Stat.CurrentValue;
+
+		const float Range = Stat.MaxStatLevel - Stat.MinStatLevel;
+		const int32 Bin = Range > 0.f
+			? FMath::Clamp(FMath::FloorToInt((Stat.CurrentValue - Stat.MinStatLevel) / Range * NumValueBins), 0, NumValueBins - 1)
+			: 0;
+		++Histogram.Bins[Bin];
+	}
+
+	void Merge(FChunkResult& Into, const FChunkResult& From)
+	{
+		Into.NumItems += From.NumItems;
+		Into.NumStats += From.NumStats;
+		Into.NumAbilities += From.NumAbilities;
+
+		for (const TPair<FGameplayTag, int64>& Pair : From.RarityCounts)
+		{
+			Into.RarityCounts.FindOrAdd(Pair.Key) += Pair.Value;
+		}
+		for (const TPair<FGameplayTag, int64>& Pair : From.AbilityCounts)
+		{
+			Into.AbilityCounts.FindOrAdd(Pair.Key) += Pair.Value;
+		}
+		for (const TPair<FGameplayTag, FStatHistogram>& Pair : From.Stats)
+		{
+			FStatHistogram& Histogram = Into.Stats.FindOrAdd(Pair.Key);
+			Histogram.MinStatLevel = Pair.Value.MinStatLevel;
+			Histogram.MaxStatLevel = Pair.Value.MaxStatLevel;
+			Histogram.Count += Pair.Value.Count;
+			Histogram.Sum += Pair.Value.Sum;
+			for (int32 Bin = 0; Bin < NumValueBins; ++Bin)
+			{
+				Histogram.Bins[Bin] += Pair.Value.Bins[Bin];
+			}
+		}
+	}
+
+	/** Writes Tag,Count,Fraction rows sorted by tag. */
+	FString CountsToCsv(TMap<FGameplayTag, int64> Counts, int64 Total)
+	{
+		Counts.KeySort([](const FGameplayTag& A, const FGameplayTag& B) { return A.GetTagName().LexicalLess(B.GetTagName()); });
+
+		FString Csv = TEXT("Tag,Count,Fraction\n");
+		for (const TPair<FGameplayTag, int64>& Pair : Counts)
+		{
+			Csv.Appendf(TEXT("%s,%lld,%.6f\n"), *Pair.Key.ToString(), Pair.Value, Total > 0 ? static_cast<double>(Pair.Value) / Total : 0.0);
+		}
+		return Csv;
+	}
+
+	bool SaveCsv(const FString& Directory, const TCHAR* FileName, const FString& Contents)
+	{
+		const FString Path = FPaths::Combine(Directory, FileName);
+		if (!FFileHelper::SaveStringToFile(Contents, *Path))
+		{
+			UE_LOG(LogTemp, Error, TEXT("LootSimulation - Failed to write %s"), *Path);
+			return false;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("LootSimulation - Wrote %s"), *Path);
+		return true;
+	}
+}
+
+ULootSimulationCommandlet::ULootSimulationCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Rolls equipment items in parallel and writes drop distribution CSVs and throughput.");
+	HelpUsage = TEXT("-run=LootSimulation -ItemDefinitions=<Path> -StatEffects=<Path> -RarityTable=<Path> [-LootTable=<Path>] [-Rolls=N] [-Seed=N] [-Output=Dir]");
+}
+
+int32 ULootSimulationCommandlet::Main(const FString& Params)
+{
+	using namespace LootSimulation;
+
+	int32 NumRolls = 1000000;
+	int32 Seed = static_cast<int32>(FPlatformTime::Cycles());
+	FString OutputDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LootSimulation"));
+	FString LootTablePath;
+	FString ItemDefinitionsPath;
+	FString StatEffectsPath;
+	FString RarityTablePath;
+
+	FParse::Value(*Params, TEXT("Rolls="), NumRolls);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Output="), OutputDirectory);
+	FParse::Value(*Params, TEXT("LootTable="), LootTablePath);
+	FParse::Value(*Params, TEXT("ItemDefinitions="), ItemDefinitionsPath);
+	FParse::Value(*Params, TEXT("StatEffects="), StatEffectsPath);
+	FParse::Value(*Params, TEXT("RarityTable="), RarityTablePath);
+
+	const UEquipmentLootTable* LootTable = nullptr;
+	const UEquipmentStatEffects* StatEffects = nullptr;
+	UDataTable* RarityTable = nullptr;
+	TArray<TSubclassOf<UEquipmentDefinition>> EquipmentClasses;
+
+	if (!LootTablePath.IsEmpty())
+	{
+		LootTable = LoadObject<UEquipmentLootTable>(nullptr, *LootTablePath);
+		if (!LootTable)
+		{
+			UE_LOG(LogTemp, Error, TEXT("LootSimulation - Could not load loot table %s"), *LootTablePath);
+			return 1;
+		}
+
+		LootTable->GetEquipmentClasses(EquipmentClasses);
+	}
+	else
+	{
+		const UItemTypesToTables* ItemDefinitions = LoadObject<UItemTypesToTables>(nullptr, *ItemDefinitionsPath);
+		StatEffects = LoadObject<UEquipmentStatEffects>(nullptr, *StatEffectsPath);
+		RarityTable = LoadObject<UDataTable>(nullptr, *RarityTablePath);
+		if (!ItemDefinitions || !StatEffects || !RarityTable)
+		{
+			UE_LOG(LogTemp, Error, TEXT("LootSimulation - Could not load sources. Usage: %s"), *HelpUsage);
+			return 1;
+		}
+
+		for (const auto& Pair : ItemDefinitions->TagsToTables)
+		{
+			if (!Pair.Value || !Pair.Value->GetRowStruct() || !Pair.Value->GetRowStruct()->IsChildOf(FMasterItemDefinition::StaticStruct()))
+			{
+				continue;
+			}
+
+			TArray<FMasterItemDefinition*> Items;
+			Pair.Value->GetAllRows<FMasterItemDefinition>(TEXT("LootSimulation"), Items);
+			for (const FMasterItemDefinition* Item : Items)
+			{
+				if (Item->EquipmentItemProps.EquipmentClass)
+				{
+					EquipmentClasses.AddUnique(Item->EquipmentItemProps.EquipmentClass);
+				}
+			}
+		}
+	}
+
+	if (EquipmentClasses.IsEmpty() || NumRolls <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("LootSimulation - Nothing to roll (%d equipment definitions, %d rolls)"), EquipmentClasses.Num(), NumRolls);
+		return 1;
+	}
+
+	TArray<const UEquipmentDefinition*> EquipmentCDOs;
+	for (const TSubclassOf<UEquipmentDefinition>& EquipmentClass : EquipmentClasses)
+	{
+		EquipmentCDOs.Add(GetDefault<UEquipmentDefinition>(EquipmentClass));
+	}
+
+	// Build the roll library caches up front so workers only ever take the read path.
+	if (!LootTable)
+	{
+		for (const UEquipmentDefinition* EquipmentCDO : EquipmentCDOs)
+		{
+			UEquipmentRollLibrary::PrewarmRollCaches(EquipmentCDO, StatEffects, RarityTable);
+		}
+	}
+
+	const int32 NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumChunks = FMath::Min(NumRolls, MaxChunks);
+	const int32 RollsPerChunk = FMath::DivideAndRoundUp(NumRolls, NumChunks);
+
+	TArray<FChunkResult> ChunkResults;
+	ChunkResults.SetNum(NumChunks);
+
+	UE_LOG(LogTemp, Display, TEXT("LootSimulation - Rolling %d items from %d definitions on %d threads (%s, seed %d)"),
+		NumRolls, EquipmentCDOs.Num(), NumWorkers, LootTable ? TEXT("baked loot table") : TEXT("DataTables"), Seed);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		// Each chunk owns a stream seeded from its index, independent of which worker runs it.
+		FChunkResult& Result = ChunkResults[ChunkIndex];
+		FRandomStream Stream(static_cast<int32>(HashCombine(static_cast<uint32>(Seed), static_cast<uint32>(ChunkIndex))));
+
+		const int32 FirstRoll = ChunkIndex * RollsPerChunk;
+		const int32 LastRoll = FMath::Min(FirstRoll + RollsPerChunk, NumRolls);
+
+		FEquipmentEffectPackage Package;
+		for (int32 RollIndex = FirstRoll; RollIndex < LastRoll; ++RollIndex)
+		{
+			const UEquipmentDefinition* EquipmentCDO = EquipmentCDOs[Stream.RandRange(0, EquipmentCDOs.Num() - 1)];
+
+			const FRarityDefinition* Rarity = LootTable ? LootTable->RollRarity(Stream) : UEquipmentRollLibrary::RollRarity(RarityTable, Stream);
+			if (!Rarity)
+			{
+				continue;
+			}
+
+			if (LootTable)
+			{
+				LootTable->RollEffectPackage(EquipmentCDO->GetClass(), *Rarity, Stream, Package);
+			}
+			else
+			{
+				Package.StatEffects = UEquipmentRollLibrary::RollPassiveStats(EquipmentCDO, StatEffects, Rarity->NumPassiveStats, Stream);
+				Package.Abilities.Reset();
+				if (EquipmentCDO->SlotTag.MatchesTag(MKHGameplayTags::Equip::WeaponSlot))
+				{
+					Package.Abilities = UEquipmentRollLibrary::ResolveAbilitiesByTags(EquipmentCDO->BasicAbilitiesGranted, StatEffects);
+					Package.Abilities.Append(UEquipmentRollLibrary::RollActiveAbilities(EquipmentCDO, StatEffects, Rarity->NumActiveAbilities, Stream));
+				}
+			}
+
+			++Result.NumItems;
+			++Result.RarityCounts.FindOrAdd(Rarity->RarityTag);
+
+			Result.NumStats += Package.StatEffects.Num();
+			for (const FEquipmentStatEffectDefinition& Stat : Package.StatEffects)
+			{
+				AddStat(Result, Stat);
+			}
+
+			Result.NumAbilities += Package.Abilities.Num();
+			for (const FEquipmentAbilityDefinition& Ability : Package.Abilities)
+			{
+				++Result.AbilityCounts.FindOrAdd(Ability.AbilityTag);
+			}
+		}
+	});
+
+	const double ElapsedSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_DOUBLE_SMALL_NUMBER);
+
+	FChunkResult Total;
+	for (const FChunkResult& Result : ChunkResults)
+	{
+		Merge(Total, Result);
+	}
+
+	const double ItemsPerSecond = Total.NumItems / ElapsedSeconds;
+	const double DrawsPerSecond = (Total.NumItems + Total.NumStats + Total.NumAbilities) / ElapsedSeconds;
+
+	UE_LOG(LogTemp, Display, TEXT("LootSimulation - %lld items, %lld stats, %lld abilities in %.3f s: %.0f items/s, %.0f draws/s"),
+		Total.NumItems, Total.NumStats, Total.NumAbilities, ElapsedSeconds, ItemsPerSecond, DrawsPerSecond);
+
+	FString StatsCsv = TEXT("Tag,Count,Fraction,Mean,MinStatLevel,MaxStatLevel\n");
+	FString ValuesCsv = TEXT("Tag,Bin,BinLow,BinHigh,Count\n");
+
+	Total.Stats.KeySort([](const FGameplayTag& A, const FGameplayTag& B) { return A.GetTagName().LexicalLess(B.GetTagName()); });
+	for (const TPair<FGameplayTag, FStatHistogram>& Pair : Total.Stats)
+	{
+		const FStatHistogram& Histogram = Pair.Value;
+		StatsCsv.Appendf(TEXT("%s,%lld,%.6f,%.4f,%.4f,%.4f\n"), *Pair.Key.ToString(), Histogram.Count,
+			Total.NumStats > 0 ? static_cast<double>(Histogram.Count) / Total.NumStats : 0.0,
+			Histogram.Count > 0 ? Histogram.Sum / Histogram.Count : 0.0, Histogram.MinStatLevel, Histogram.MaxStatLevel);
+
+		const float BinWidth = (Histogram.MaxStatLevel - Histogram.MinStatLevel) / NumValueBins;
+		for (int32 Bin = 0; Bin < NumValueBins; ++Bin)
+		{
+			ValuesCsv.Appendf(TEXT("%s,%d,%.4f,%.4f,%lld\n"), *Pair.Key.ToString(), Bin,
+				Histogram.MinStatLevel + Bin * BinWidth, Histogram.MinStatLevel + (Bin + 1) * BinWidth, Histogram.Bins[Bin]);
+		}
+	}
+
+	FString SummaryCsv = TEXT("Items,Stats,Abilities,Seconds,Threads,ItemsPerSecond,DrawsPerSecond,Seed\n");
+	SummaryCsv.Appendf(TEXT("%lld,%lld,%lld,%.4f,%d,%.1f,%.1f,%d\n"), Total.NumItems, Total.NumStats, Total.NumAbilities,
+		ElapsedSeconds, NumWorkers, ItemsPerSecond, DrawsPerSecond, Seed);
+
+	bool bWritten = SaveCsv(OutputDirectory, TEXT("Summary.csv"), SummaryCsv);
+	bWritten &= SaveCsv(OutputDirectory, TEXT("Rarities.csv"), CountsToCsv(Total.RarityCounts, Total.NumItems));
+	bWritten &= SaveCsv(OutputDirectory, TEXT("Abilities.csv"), CountsToCsv(Total.AbilityCounts, Total.NumAbilities));
+	bWritten &= SaveCsv(OutputDirectory, TEXT("Stats.csv"), StatsCsv);
+	bWritten &= SaveCsv(OutputDirectory, TEXT("StatValues.csv"), ValuesCsv);
+
+	return bWritten ? 0 : 1;
+}
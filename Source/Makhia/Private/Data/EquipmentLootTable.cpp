@@ -0,0 +1,369 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/EquipmentLootTable.h"
+
+#include "AbilitySystem/MKHGameplayTags.h"
+#include "Data/EquipmentStatEffects.h"
+#include "Engine/DataTable.h"
+#include "Equipment/EquipmentDefinition.h"
+#include "Inventory/ItemTypes.h"
+#include "Inventory/ItemTypesToTables.h"
+#include "Libraries/MKHAbilitySystemLibrary.h"
+
+#if WITH_EDITOR
+#include "Misc/DataValidation.h"
+#include "UObject/ObjectSaveContext.h"
+
+namespace EquipmentLootBake
+{
+	/** Resolves Tag against the first matching MasterStatMap table, exactly like the runtime roll library does. */
+	template<typename RowType>
+	const RowType* ResolveRow(const UEquipmentStatEffects* StatEffects, const FGameplayTag& Tag, const UClass* EquipmentClass,
+		TArray<FString>& OutErrors)
+	{
+		for (const auto& Pair : StatEffects->MasterStatMap)
+		{
+			if (!Tag.MatchesTag(Pair.Key))
+			{
+				continue;
+			}
+
+			if (const RowType* Row = UMKHAbilitySystemLibrary::GetDataTableRowByTag<RowType>(Pair.Value, Tag))
+			{
+				return Row;
+			}
+
+			OutErrors.Add(FString::Printf(TEXT("%s: tag %s has no row in %s"),
+				*GetNameSafe(EquipmentClass), *Tag.ToString(), *GetNameSafe(Pair.Value)));
+			return nullptr;
+		}
+
+		OutErrors.Add(FString::Printf(TEXT("%s: tag %s matches no MasterStatMap category"),
+			*GetNameSafe(EquipmentClass), *Tag.ToString()));
+		return nullptr;
+	}
+
+	/** Returns the index of Row in Rows, copying it in on first use. */
+	template<typename RowType>
+	int32 FindOrAddRow(const RowType* Row, TMap<const RowType*, int32>& RowIndices, TArray<RowType>& Rows)
+	{
+		if (const int32* Existing = RowIndices.Find(Row))
+		{
+			return *Existing;
+		}
+
+		const int32 NewIndex = Rows.Add(*Row);
+		RowIndices.Add(Row, NewIndex);
+		return NewIndex;
+	}
+}
+#endif
+
+void UEquipmentLootTable::PostLoad()
+{
+	Super::PostLoad();
+
+	BuildRuntimeData();
+}
+
+#if WITH_EDITOR
+void UEquipmentLootTable::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// Keep the baked data in sync with the sources on every save, cooks included.
+	TArray<FString> Errors;
+	if (!Bake(Errors))
+	{
+		// Logged errors fail the cook once every package has been saved; IsDataValid reports them before that
+		for (const FString& Error : Errors)
+		{
+			UE_LOG(LogTemp, Error, TEXT("UEquipmentLootTable::PreSave - %s"), *Error);
+		}
+	}
+}
+
+EDataValidationResult UEquipmentLootTable::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	// Dry-run the bake on a scratch table so validating never touches the saved arrays.
+	UEquipmentLootTable* Scratch = NewObject<UEquipmentLootTable>(GetTransientPackage());
+	Scratch->ItemDefinitions = ItemDefinitions;
+	Scratch->StatEffects = StatEffects;
+	Scratch->RarityTable = RarityTable;
+
+	TArray<FString> Errors;
+	if (!Scratch->Bake(Errors))
+	{
+		for (const FString& Error : Errors)
+		{
+			Context.AddError(FText::FromString(Error));
+		}
+		Result = EDataValidationResult::Invalid;
+	}
+
+	Scratch->MarkAsGarbage();
+	return Result;
+}
+
+bool UEquipmentLootTable::Bake(TArray<FString>& OutErrors)
+{
+	using namespace EquipmentLootBake;
+
+	if (!ItemDefinitions || !StatEffects || !RarityTable)
+	{
+		OutErrors.Add(FString::Printf(TEXT("%s: ItemDefinitions, StatEffects and RarityTable must all be set"), *GetName()));
+		return false;
+	}
+
+	const int32 NumErrorsBefore = OutErrors.Num();
+
+	Pools.Reset();
+	StatCandidates.Reset();
+	AbilityCandidates.Reset();
+	BasicAbilityRows.Reset();
+	StatRanges.Reset();
+	RarityWeights.Reset();
+	StatRows.Reset();
+	AbilityRows.Reset();
+	RarityRows.Reset();
+
+	TArray<FRarityDefinition*> Rarities;
+	RarityTable->GetAllRows<FRarityDefinition>(TEXT("EquipmentLootBake"), Rarities);
+	for (const FRarityDefinition* Rarity : Rarities)
+	{
+		if (Rarity->RollProbability > 0.f)
+		{
+			RarityRows.Add(*Rarity);
+			RarityWeights.Add(Rarity->RollProbability);
+		}
+	}
+
+	if (RarityRows.IsEmpty())
+	{
+		OutErrors.Add(FString::Printf(TEXT("%s: %s has no rarity with a positive RollProbability"), *GetName(), *RarityTable->GetName()));
+	}
+
+	TMap<const FEquipmentStatEffectDefinition*, int32> StatRowIndices;
+	TMap<const FEquipmentAbilityDefinition*, int32> AbilityRowIndices;
+	TSet<const UClass*> BakedClasses;
+
+	for (const auto& TablePair : ItemDefinitions->TagsToTables)
+	{
+		const UDataTable* ItemTable = TablePair.Value;
+		if (!ItemTable || !ItemTable->GetRowStruct() || !ItemTable->GetRowStruct()->IsChildOf(FMasterItemDefinition::StaticStruct()))
+		{
+			continue;
+		}
+
+		TArray<FMasterItemDefinition*> Items;
+		ItemTable->GetAllRows<FMasterItemDefinition>(TEXT("EquipmentLootBake"), Items);
+
+		for (const FMasterItemDefinition* Item : Items)
+		{
+			const TSubclassOf<UEquipmentDefinition> EquipmentClass = Item->EquipmentItemProps.EquipmentClass;
+			if (!EquipmentClass)
+			{
+				continue;
+			}
+
+			bool bAlreadyBaked = false;
+			BakedClasses.Add(EquipmentClass.Get(), &bAlreadyBaked);
+			if (bAlreadyBaked)
+			{
+				continue;
+			}
+
+			const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(EquipmentClass);
+
+			FBakedLootPool& Pool = Pools.AddDefaulted_GetRef();
+			Pool.EquipmentClass = EquipmentClass;
+			Pool.bIsWeapon = EquipmentCDO->SlotTag.MatchesTag(MKHGameplayTags::Equip::WeaponSlot);
+
+			Pool.StatCandidates.First = StatCandidates.Num();
+			for (int32 i = 0; i < EquipmentCDO->PossibleStatRolls.Num(); ++i)
+			{
+				const FEquipmentStatEffectDefinition* Row = ResolveRow<FEquipmentStatEffectDefinition>(
+					StatEffects, EquipmentCDO->PossibleStatRolls.GetByIndex(i), EquipmentClass, OutErrors);
+				if (!Row || Row->ProbabilityToSelect <= 0.f)
+				{
+					continue;
+				}
+
+				const int32 RowIndex = FindOrAddRow(Row, StatRowIndices, StatRows);
+				if (RowIndex == StatRanges.Num())
+				{
+					FBakedStatRange& Range = StatRanges.AddDefaulted_GetRef();
+					Range.MinStatLevel = Row->MinStatLevel;
+					Range.MaxStatLevel = Row->MaxStatLevel;
+					Range.bFractionalStat = Row->bFractionalStat;
+				}
+
+				FBakedLootCandidate& Candidate = StatCandidates.AddDefaulted_GetRef();
+				Candidate.RowIndex = RowIndex;
+				Candidate.Weight = Row->ProbabilityToSelect;
+			}
+			Pool.StatCandidates.Num = StatCandidates.Num() - Pool.StatCandidates.First;
+
+			// Abilities are only ever rolled for weapons, the other pools stay empty.
+			Pool.AbilityCandidates.First = AbilityCandidates.Num();
+			Pool.BasicAbilities.First = BasicAbilityRows.Num();
+			if (!Pool.bIsWeapon)
+			{
+				continue;
+			}
+
+			for (int32 i = 0; i < EquipmentCDO->BasicAbilitiesGranted.Num(); ++i)
+			{
+				if (const FEquipmentAbilityDefinition* Row = ResolveRow<FEquipmentAbilityDefinition>(
+					StatEffects, EquipmentCDO->BasicAbilitiesGranted.GetByIndex(i), EquipmentClass, OutErrors))
+				{
+					BasicAbilityRows.Add(FindOrAddRow(Row, AbilityRowIndices, AbilityRows));
+				}
+			}
+			Pool.BasicAbilities.Num = BasicAbilityRows.Num() - Pool.BasicAbilities.First;
+
+			for (int32 i = 0; i < EquipmentCDO->PossibleAbilityRolls.Num(); ++i)
+			{
+				const FEquipmentAbilityDefinition* Row = ResolveRow<FEquipmentAbilityDefinition>(
+					StatEffects, EquipmentCDO->PossibleAbilityRolls.GetByIndex(i), EquipmentClass, OutErrors);
+				if (!Row || Row->ProbabilityToSelect <= 0.f)
+				{
+					continue;
+				}
+
+				FBakedLootCandidate& Candidate = AbilityCandidates.AddDefaulted_GetRef();
+				Candidate.RowIndex = FindOrAddRow(Row, AbilityRowIndices, AbilityRows);
+				Candidate.Weight = Row->ProbabilityToSelect;
+			}
+			Pool.AbilityCandidates.Num = AbilityCandidates.Num() - Pool.AbilityCandidates.First;
+		}
+	}
+
+	BuildRuntimeData();
+
+	return OutErrors.Num() == NumErrorsBefore;
+}
+
+void UEquipmentLootTable::BakeLootTable()
+{
+	Modify();
+
+	TArray<FString> Errors;
+	if (Bake(Errors))
+	{
+		UE_LOG(LogTemp, Log, TEXT("UEquipmentLootTable::BakeLootTable - %s: %d pools, %d stat rows, %d ability rows, %d rarities"),
+			*GetName(), Pools.Num(), StatRows.Num(), AbilityRows.Num(), RarityRows.Num());
+	}
+
+	for (const FString& Error : Errors)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UEquipmentLootTable::BakeLootTable - %s"), *Error);
+	}
+}
+#endif
+
+void UEquipmentLootTable::BuildRuntimeData()
+{
+	PoolIndexByClass.Reset();
+	StatAliasTables.SetNum(Pools.Num());
+	AbilityAliasTables.SetNum(Pools.Num());
+
+	TArray<float, TInlineAllocator<32>> Weights;
+
+	for (int32 PoolIndex = 0; PoolIndex < Pools.Num(); ++PoolIndex)
+	{
+		const FBakedLootPool& Pool = Pools[PoolIndex];
+		if (Pool.EquipmentClass)
+		{
+			PoolIndexByClass.Add(TObjectKey<UClass>(Pool.EquipmentClass.Get()), PoolIndex);
+		}
+
+		Weights.Reset();
+		for (int32 i = 0; i < Pool.StatCandidates.Num; ++i)
+		{
+			Weights.Add(StatCandidates[Pool.StatCandidates.First + i].Weight);
+		}
+		StatAliasTables[PoolIndex].Build(Weights);
+
+		Weights.Reset();
+		for (int32 i = 0; i < Pool.AbilityCandidates.Num; ++i)
+		{
+			Weights.Add(AbilityCandidates[Pool.AbilityCandidates.First + i].Weight);
+		}
+		AbilityAliasTables[PoolIndex].Build(Weights);
+	}
+
+	RarityAliasTable.Build(RarityWeights);
+}
+
+void UEquipmentLootTable::GetEquipmentClasses(TArray<TSubclassOf<UEquipmentDefinition>>& OutClasses) const
+{
+	OutClasses.Reserve(OutClasses.Num() + Pools.Num());
+	for (const FBakedLootPool& Pool : Pools)
+	{
+		if (Pool.EquipmentClass)
+		{
+			OutClasses.Add(Pool.EquipmentClass);
+		}
+	}
+}
+
+const FRarityDefinition* UEquipmentLootTable::RollRarity(FRandomStream& Stream) const
+{
+	const int32 SelectedIndex = RarityAliasTable.Sample(Stream);
+	return SelectedIndex != INDEX_NONE ? &RarityRows[SelectedIndex] : nullptr;
+}
+
+bool UEquipmentLootTable::RollEffectPackage(const UClass* EquipmentClass, const FRarityDefinition& Rarity, FRandomStream& Stream,
+	FEquipmentEffectPackage& OutPackage) const
+{
+	const int32* PoolIndex = PoolIndexByClass.Find(TObjectKey<UClass>(EquipmentClass));
+	if (!PoolIndex)
+	{
+		return false;
+	}
+
+	const FBakedLootPool& Pool = Pools[*PoolIndex];
+	OutPackage.StatEffects.Reset();
+	OutPackage.Abilities.Reset();
+
+	const FEquipmentAliasTable& StatAliasTable = StatAliasTables[*PoolIndex];
+	if (!StatAliasTable.IsEmpty() && Rarity.NumPassiveStats > 0)
+	{
+		OutPackage.StatEffects.Reserve(Rarity.NumPassiveStats);
+		for (int32 i = 0; i < Rarity.NumPassiveStats; ++i)
+		{
+			const FBakedLootCandidate& Candidate = StatCandidates[Pool.StatCandidates.First + StatAliasTable.Sample(Stream)];
+			const FBakedStatRange& Range = StatRanges[Candidate.RowIndex];
+
+			FEquipmentStatEffectDefinition& NewStat = OutPackage.StatEffects.Add_GetRef(StatRows[Candidate.RowIndex]);
+			NewStat.CurrentValue = UEquipmentRollLibrary::RollStatLevel(Range.MinStatLevel, Range.MaxStatLevel, Range.bFractionalStat, Stream);
+		}
+	}
+
+	if (!Pool.bIsWeapon)
+	{
+		return true;
+	}
+
+	const FEquipmentAliasTable& AbilityAliasTable = AbilityAliasTables[*PoolIndex];
+	const int32 NumRolledAbilities = AbilityAliasTable.IsEmpty() ? 0 : FMath::Max(Rarity.NumActiveAbilities, 0);
+	OutPackage.Abilities.Reserve(Pool.BasicAbilities.Num + NumRolledAbilities);
+
+	for (int32 i = 0; i < Pool.BasicAbilities.Num; ++i)
+	{
+		OutPackage.Abilities.Add(AbilityRows[BasicAbilityRows[Pool.BasicAbilities.First + i]]);
+	}
+
+	// Optional abilities from rarity are independent of guaranteed basic abilities.
+	for (int32 i = 0; i < NumRolledAbilities; ++i)
+	{
+		const FBakedLootCandidate& Candidate = AbilityCandidates[Pool.AbilityCandidates.First + AbilityAliasTable.Sample(Stream)];
+		OutPackage.Abilities.Add(AbilityRows[Candidate.RowIndex]);
+	}
+
+	return true;
+}
@@ -3,3 +3,14 @@
 
 #include "Data/EquipmentStatEffects.h"
 
+#include "Libraries/EquipmentRollLibrary.h"
+
+#if WITH_EDITOR
+void UEquipmentStatEffects::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Cached roll pools point at rows of the previously mapped tables
+	UEquipmentRollLibrary::InvalidateRollCaches();
+}
+#endif
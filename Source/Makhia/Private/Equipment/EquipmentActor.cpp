@@ -5,7 +5,8 @@
 
 AEquipmentActor::AEquipmentActor()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Pure visuals: attachment moves them with the character, nothing here needs a per-frame update.
+	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
 
 	RootScene = CreateDefaultSubobject<USceneComponent>(TEXT("RootScene"));
@@ -14,5 +15,6 @@ AEquipmentActor::AEquipmentActor()
 	EquipmentMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("EquipmentMesh"));
 	EquipmentMesh->SetupAttachment(GetRootComponent());
 	EquipmentMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	EquipmentMesh->SetGenerateOverlapEvents(false);
 
 }
@@ -8,9 +8,67 @@
 #include "Equipment/EquipmentActor.h"
 #include "Equipment/EquipmentDefinition.h"
 #include "Equipment/Weapon/MKHWeaponBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/Pawn.h"
+#include "EngineUtils.h"
+
+namespace EquipmentVisualStats
+{
+	/** Counts the scene components and per-frame ticks that equipment visuals add on top of the bare characters. */
+	void Dump(UWorld* World)
+	{
+		if (!IsValid(World))
+		{
+			return;
+		}
+
+		int32 NumCharacters = 0;
+		int32 NumAttachedActors = 0;
+		int32 NumAttachedComponents = 0;
+		int32 NumFollowers = 0;
+		int32 NumTickingActors = 0;
+		int32 NumTickingComponents = 0;
+
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			++NumCharacters;
+
+			TArray<AActor*> AttachedActors;
+			It->GetAttachedActors(AttachedActors, true, true);
+			for (const AActor* Attached : AttachedActors)
+			{
+				++NumAttachedActors;
+				NumTickingActors += Attached->IsActorTickEnabled() ? 1 : 0;
+
+				TInlineComponentArray<USceneComponent*> Components(Attached);
+				NumAttachedComponents += Components.Num();
+				for (const USceneComponent* Component : Components)
+				{
+					NumTickingComponents += Component->IsComponentTickEnabled() ? 1 : 0;
+				}
+			}
+
+			TInlineComponentArray<USkeletalMeshComponent*> SkeletalComponents(*It);
+			for (const USkeletalMeshComponent* SkeletalComponent : SkeletalComponents)
+			{
+				NumFollowers += SkeletalComponent->LeaderPoseComponent.IsValid() ? 1 : 0;
+			}
+		}
+
+		const float PerCharacter = NumCharacters > 0 ? 1.f / NumCharacters : 0.f;
+		UE_LOG(LogTemp, Display, TEXT("Equipment visuals: %d characters | %d attached actors (%.1f/char), %d scene components (%.1f/char), %d leader-pose followers (%.1f/char) | ticking: %d actors, %d components"),
+			NumCharacters, NumAttachedActors, NumAttachedActors * PerCharacter, NumAttachedComponents, NumAttachedComponents * PerCharacter,
+			NumFollowers, NumFollowers * PerCharacter, NumTickingActors, NumTickingComponents);
+	}
+
+	static FAutoConsoleCommandWithWorld DumpCommand(
+		TEXT("Makhia.Equipment.VisualStats"),
+		TEXT("Logs the number of equipment actors, components, leader-pose followers and ticking objects attached to characters."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&Dump));
+}
 
 void UEquipmentInstance::OnEquipped()
 {
@@ -20,7 +78,7 @@ void UEquipmentInstance::OnUnEquipped()
 {
 }
 
-void UEquipmentInstance::SpawnEquipmentActors(const TArray<FEquipmentActorToSpawn>& ActorsToSpawn, float WeaponDamage)
+void UEquipmentInstance::SpawnEquipmentActors(const TArray<FEquipmentActorToSpawn>& ActorsToSpawn, float WeaponDamage, bool bReplicateActors)
 {
 	ACharacter* OwningCharacter = GetCharacter();
 	if (!IsValid(OwningCharacter))
@@ -28,6 +86,8 @@ void UEquipmentInstance::SpawnEquipmentActors(const TArray<FEquipmentActorToSpaw
 		return;
 	}
 
+	VisualCharacter = OwningCharacter;
+
 	for (const FEquipmentActorToSpawn& ActorToSpawn : ActorsToSpawn)
 	{
 		if (!ActorToSpawn.EquipmentClass.ToSoftObjectPath().IsValid())
@@ -37,15 +97,16 @@ void UEquipmentInstance::SpawnEquipmentActors(const TArray<FEquipmentActorToSpaw
 
 		if (IsValid(ActorToSpawn.EquipmentClass.Get()))
 		{
-			SpawnActorFromSpecification(ActorToSpawn, OwningCharacter, WeaponDamage);
+			SpawnActorFromSpecification(ActorToSpawn, OwningCharacter, WeaponDamage, bReplicateActors);
 			continue;
 		}
 
-		RequestAsyncSpawn(ActorToSpawn, OwningCharacter, WeaponDamage);
+		RequestAsyncSpawn(ActorToSpawn, OwningCharacter, WeaponDamage, bReplicateActors);
 	}
 }
 
-void UEquipmentInstance::SpawnActorFromSpecification(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage)
+void UEquipmentInstance::SpawnActorFromSpecification(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage,
+	bool bReplicateActors)
 {
 	if (!IsValid(OwningCharacter) || !IsValid(OwningCharacter->GetMesh()))
 	{
@@ -58,6 +119,12 @@ void UEquipmentInstance::SpawnActorFromSpecification(const FEquipmentActorToSpaw
 		return;
 	}
 
+	// A dedicated server never renders local copies: it only keeps weapons around for hit detection.
+	if (!bReplicateActors && IsRunningDedicatedServer() && !EquipmentClass->IsChildOf(AMKHWeaponBase::StaticClass()))
+	{
+		return;
+	}
+
 	UWorld* World = GetWorld();
 	if (!IsValid(World))
 	{
@@ -75,11 +142,13 @@ void UEquipmentInstance::SpawnActorFromSpecification(const FEquipmentActorToSpaw
 		return;
 	}
 
+	NewActor->SetReplicates(bReplicateActors);
 	FinalizeSpawnedActor(NewActor, OwningCharacter, ActorToSpawn.AttachName, WeaponDamage);
 	SpawnedActors.Emplace(NewActor);
 }
 
-void UEquipmentInstance::RequestAsyncSpawn(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage)
+void UEquipmentInstance::RequestAsyncSpawn(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage,
+	bool bReplicateActors)
 {
 	if (!IsValid(OwningCharacter))
 	{
@@ -92,14 +161,15 @@ void UEquipmentInstance::RequestAsyncSpawn(const FEquipmentActorToSpawn& ActorTo
 
 	Manager.RequestAsyncLoad(
 		ActorToSpawn.EquipmentClass.ToSoftObjectPath(),
-		[WeakThis, WeakCharacter, ActorToSpawn, WeaponDamage]
+		[WeakThis, WeakCharacter, ActorToSpawn, WeaponDamage, bReplicateActors]
 		{
-			if (!WeakThis.IsValid() || !WeakCharacter.IsValid())
+			// Dropped if the visuals were destroyed or moved to another pawn while loading
+			if (!WeakThis.IsValid() || !WeakCharacter.IsValid() || WeakThis->VisualCharacter != WeakCharacter)
 			{
 				return;
 			}
 
-			WeakThis->SpawnActorFromSpecification(ActorToSpawn, WeakCharacter.Get(), WeaponDamage);
+			WeakThis->SpawnActorFromSpecification(ActorToSpawn, WeakCharacter.Get(), WeaponDamage, bReplicateActors);
 		});
 }
 
@@ -115,6 +185,74 @@ void UEquipmentInstance::FinalizeSpawnedActor(AEquipmentActor* SpawnedActor, ACh
 	ApplyWeaponDamageIfWeapon(SpawnedActor, WeaponDamage);
 }
 
+void UEquipmentInstance::AttachSkinnedMeshes(const TArray<TSoftObjectPtr<USkeletalMesh>>& SkinnedMeshes)
+{
+	if (SkinnedMeshes.IsEmpty() || IsRunningDedicatedServer())
+	{
+		return;
+	}
+
+	ACharacter* OwningCharacter = GetCharacter();
+	if (!IsValid(OwningCharacter))
+	{
+		return;
+	}
+
+	VisualCharacter = OwningCharacter;
+
+	FStreamableManager& Manager = UAssetManager::GetStreamableManager();
+	const TWeakObjectPtr<UEquipmentInstance> WeakThis(this);
+	const TWeakObjectPtr<ACharacter> WeakCharacter(OwningCharacter);
+
+	for (const TSoftObjectPtr<USkeletalMesh>& SkinnedMesh : SkinnedMeshes)
+	{
+		if (SkinnedMesh.IsNull())
+		{
+			continue;
+		}
+
+		if (USkeletalMesh* LoadedMesh = SkinnedMesh.Get())
+		{
+			AddLeaderPoseFollower(LoadedMesh, OwningCharacter);
+			continue;
+		}
+
+		Manager.RequestAsyncLoad(SkinnedMesh.ToSoftObjectPath(),
+			[WeakThis, WeakCharacter, SkinnedMesh]
+			{
+				if (!WeakThis.IsValid() || !WeakCharacter.IsValid() || WeakThis->VisualCharacter != WeakCharacter)
+				{
+					return;
+				}
+
+				WeakThis->AddLeaderPoseFollower(SkinnedMesh.Get(), WeakCharacter.Get());
+			});
+	}
+}
+
+void UEquipmentInstance::AddLeaderPoseFollower(USkeletalMesh* SkeletalMesh, ACharacter* OwningCharacter)
+{
+	if (!IsValid(SkeletalMesh) || !IsValid(OwningCharacter) || !IsValid(OwningCharacter->GetMesh()))
+	{
+		return;
+	}
+
+	USkeletalMeshComponent* LeaderMesh = OwningCharacter->GetMesh();
+	USkeletalMeshComponent* Follower = NewObject<USkeletalMeshComponent>(OwningCharacter, NAME_None, RF_Transient);
+	Follower->SetSkeletalMeshAsset(SkeletalMesh);
+	Follower->SetupAttachment(LeaderMesh);
+	Follower->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Follower->SetGenerateOverlapEvents(false);
+	Follower->bUseBoundsFromLeaderPoseComponent = true;
+
+	// The leader refreshes follower transforms when it finalizes its pose, the follower never needs its own tick.
+	Follower->PrimaryComponentTick.bStartWithTickEnabled = false;
+	Follower->RegisterComponent();
+	Follower->SetLeaderPoseComponent(LeaderMesh);
+
+	FollowerComponents.Emplace(Follower);
+}
+
 void UEquipmentInstance::ApplyWeaponDamageIfWeapon(AEquipmentActor* SpawnedActor, float WeaponDamage)
 {
 	if (AMKHWeaponBase* Weapon = Cast<AMKHWeaponBase>(SpawnedActor))
@@ -134,6 +272,22 @@ void UEquipmentInstance::DestroySpawnedActors()
 	}
 
 	SpawnedActors.Reset();
+
+	for (USkeletalMeshComponent* Follower : FollowerComponents)
+	{
+		if (IsValid(Follower))
+		{
+			Follower->DestroyComponent();
+		}
+	}
+
+	FollowerComponents.Reset();
+	VisualCharacter.Reset();
+}
+
+bool UEquipmentInstance::HasVisualsOn(const ACharacter* Character) const
+{
+	return IsValid(Character) && VisualCharacter.Get() == Character;
 }
 
 const TArray<TObjectPtr<AActor>>& UEquipmentInstance::GetSpawnedActors() const
@@ -5,10 +5,13 @@
 
 #include "Equipment/EquipmentDefinition.h"
 #include "Equipment/EquipmentInstance.h"
-#include "Inventory/InventoryItem/InventoryItem.h"
+#include "Inventory/InventoryComponent.h"
+#include "Interfaces/InventoryInterface.h"
 #include "Net/UnrealNetwork.h"
 #include "AbilitySystem/MKHAbilitySystemComponent.h"
 #include "AbilitySystemGlobals.h"
+#include "Character/CharacterBase.h"
+#include "GameFramework/Controller.h"
 
 UMKHAbilitySystemComponent* FRPGEquipmentList::GetAbilitySystemComponent()
 {
@@ -37,6 +40,105 @@ void FRPGEquipmentList::RemoveEntryEffects(FRPGEquipmentEntry& Entry)
 	RemoveEquipmentAbility(&Entry);
 }
 
+bool FRPGEquipmentList::UsesLocalCosmeticActors() const
+{
+	const UEquipmentManagerComponent* EquipmentManager = Cast<UEquipmentManagerComponent>(OwnerComponent);
+	return IsValid(EquipmentManager) && EquipmentManager->ShouldSpawnCosmeticActorsLocally();
+}
+
+ACharacterBase* FRPGEquipmentList::GetOwningCharacter() const
+{
+	check(OwnerComponent);
+
+	if (const AController* Controller = Cast<AController>(OwnerComponent->GetOwner()))
+	{
+		return Cast<ACharacterBase>(Controller->GetPawn());
+	}
+
+	return Cast<ACharacterBase>(OwnerComponent->GetOwner());
+}
+
+void FRPGEquipmentList::SpawnLocalEquipmentVisuals(FRPGEquipmentEntry& Entry)
+{
+	if (!Entry.EquipmentDefinition)
+	{
+		return;
+	}
+
+	const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(Entry.EquipmentDefinition);
+
+	if (!IsValid(Entry.Instance))
+	{
+		TSubclassOf<UEquipmentInstance> InstanceType = EquipmentCDO->InstanceType;
+		if (!IsValid(InstanceType))
+		{
+			InstanceType = UEquipmentInstance::StaticClass();
+		}
+
+		Entry.Instance = NewObject<UEquipmentInstance>(OwnerComponent->GetOwner(), InstanceType);
+	}
+
+	if (UsesLocalCosmeticActors())
+	{
+		Entry.Instance->SpawnEquipmentActors(EquipmentCDO->ActorsToSpawn, EquipmentCDO->BaseDamage, false);
+	}
+	Entry.Instance->AttachSkinnedMeshes(EquipmentCDO->SkinnedMeshes);
+}
+
+void FRPGEquipmentList::SpawnAuthorityEquipmentVisuals(FRPGEquipmentEntry& Entry)
+{
+	if (!IsValid(Entry.Instance) || !Entry.EquipmentDefinition)
+	{
+		return;
+	}
+
+	const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(Entry.EquipmentDefinition);
+	const bool bLocalActors = UsesLocalCosmeticActors();
+	Entry.Instance->SpawnEquipmentActors(EquipmentCDO->ActorsToSpawn, EquipmentCDO->BaseDamage, !bLocalActors);
+	Entry.Instance->AttachSkinnedMeshes(EquipmentCDO->SkinnedMeshes);
+
+	// Components are never replicated, so remote clients always need the mirror to build the skinned followers.
+	if (ACharacterBase* Character = GetOwningCharacter())
+	{
+		Character->SetEquippedVisual(Entry.SlotTag, Entry.EquipmentDefinition, bLocalActors);
+	}
+}
+
+void FRPGEquipmentList::RefreshEquipmentVisuals()
+{
+	check(OwnerComponent);
+
+	// Entries can replicate (or be equipped) before the controller has a pawn, and a respawn leaves the
+	// visuals on the old one. Nothing else retries, so possession rebuilds whatever is missing.
+	const ACharacterBase* Character = GetOwningCharacter();
+	if (!IsValid(Character))
+	{
+		return;
+	}
+
+	const bool bAuthority = OwnerComponent->GetOwner()->HasAuthority();
+	for (FRPGEquipmentEntry& Entry : Entries)
+	{
+		if (IsValid(Entry.Instance))
+		{
+			if (Entry.Instance->HasVisualsOn(Character))
+			{
+				continue;
+			}
+			Entry.Instance->DestroySpawnedActors();
+		}
+
+		if (bAuthority)
+		{
+			SpawnAuthorityEquipmentVisuals(Entry);
+		}
+		else
+		{
+			SpawnLocalEquipmentVisuals(Entry);
+		}
+	}
+}
+
 void FRPGEquipmentList::AddEquipmentStats(FRPGEquipmentEntry* Entry)
 {
 	if (UMKHAbilitySystemComponent* ASC = GetAbilitySystemComponent())
@@ -100,10 +202,7 @@ UEquipmentInstance* FRPGEquipmentList::AddEntry(const FRPGEquipmentEntry& InEntr
 
 	ApplyEntryEffects(NewEntry);
 
-	if (IsValid(NewEntry.Instance))
-	{
-		NewEntry.Instance->SpawnEquipmentActors(EquipmentCDO->ActorsToSpawn, EquipmentCDO->BaseDamage);
-	}
+	SpawnAuthorityEquipmentVisuals(NewEntry);
 
 	MarkItemDirty(NewEntry);
 	EquipmentEntryDelegate.Broadcast(NewEntry);
@@ -127,6 +226,11 @@ void FRPGEquipmentList::RemoveEntryBySlot(const FGameplayTag& SlotTag)
 				Entry.Instance->DestroySpawnedActors();
 			}
 
+			if (ACharacterBase* Character = GetOwningCharacter())
+			{
+				Character->ClearEquippedVisual(SlotTag);
+			}
+
 			// Broadcast the unequip event before removal so listeners can return the item to inventory.
 			UnEquippedEntryDelegate.Broadcast(Entry);
 			EntryIt.RemoveCurrent();
@@ -180,6 +284,11 @@ void FRPGEquipmentList::PreReplicatedRemove(const TArrayView<int32>& RemovedIndi
 {
 	for (const int32 Index : RemovedIndices)
 	{
+		if (IsValid(Entries[Index].Instance))
+		{
+			Entries[Index].Instance->DestroySpawnedActors();
+		}
+
 		UnEquippedEntryDelegate.Broadcast(Entries[Index]);
 
 		// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red,
@@ -191,6 +300,8 @@ void FRPGEquipmentList::PostReplicatedAdd(const TArrayView<int32>& AddedIndices,
 {
 	for (const int32 Index : AddedIndices)
 	{
+		SpawnLocalEquipmentVisuals(Entries[Index]);
+
 		EquipmentEntryDelegate.Broadcast(Entries[Index]);
 	}
 }
@@ -228,39 +339,87 @@ void UEquipmentManagerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProp
 	DOREPLIFETIME(UEquipmentManagerComponent, EquipmentList);
 }
 
-FRPGEquipmentEntry UEquipmentManagerComponent::BuildEquipmentEntry(const UInventoryItem* InventoryItem)
+FRPGEquipmentEntry UEquipmentManagerComponent::BuildEquipmentEntry(const FRPGInventoryEntry& InventoryEntry,
+	TSubclassOf<UEquipmentDefinition> EquipmentClass)
 {
-	check(IsValid(InventoryItem));
-
-	const TSubclassOf<UEquipmentDefinition> EquipDefClass = InventoryItem->ItemDefinition.EquipmentItemProps.EquipmentClass;
-	check(EquipDefClass);
-
-	// const UEquipmentDefinition* EquipCDO = GetDefault<UEquipmentDefinition>(EquipDefClass);
+	check(EquipmentClass);
 
 	FRPGEquipmentEntry Entry;
-	Entry.EquipmentDefinition  = EquipDefClass;
-	Entry.EntryTag             = InventoryItem->ItemTag;
-	Entry.SlotTag              = InventoryItem->SlotTag;
-	Entry.RarityTag            = InventoryItem->GetRarityTag();
-	Entry.EffectPackage        = InventoryItem->GetEffectPackage();
-	Entry.OriginalItemID       = InventoryItem->GetItemID();
+	Entry.EquipmentDefinition  = EquipmentClass;
+	Entry.EntryTag             = InventoryEntry.ItemTag;
+	Entry.SlotTag              = GetDefault<UEquipmentDefinition>(EquipmentClass)->SlotTag;
+	Entry.RarityTag            = InventoryEntry.RarityTag;
+	Entry.EffectPackage        = InventoryEntry.EffectPackage;
+	Entry.OriginalItemID       = InventoryEntry.ItemID;
 	return Entry;
 }
 
-void UEquipmentManagerComponent::EquipItem(const FRPGEquipmentEntry& InEntry)
+void UEquipmentManagerComponent::EquipItem(int64 ItemID)
 {
 	if (!GetOwner()->HasAuthority())
 	{
-		ServerEquipItem(InEntry);
+		ServerEquipItem(ItemID);
 		return;
 	}
 
-	if (UEquipmentInstance* Result = EquipmentList.AddEntry(InEntry))
+	UInventoryComponent* InventoryComponent = GetOwnerInventoryComponent();
+	if (ItemID == 0 || !IsValid(InventoryComponent))
+	{
+		return;
+	}
+
+	// UseItem would also consume potions and other items; only equipment may go through this request.
+	const FRPGInventoryEntry* InventoryEntry = InventoryComponent->InventoryList.FindEntryByID(ItemID);
+	if (!InventoryEntry || !InventoryComponent->GetItemDefinitionByTag(InventoryEntry->ItemTag).EquipmentItemProps.EquipmentClass)
+	{
+		return;
+	}
+
+	// The inventory validates ownership, consumes or marks the entry, then calls back into EquipFromInventory.
+	InventoryComponent->UseItem(ItemID, 1);
+}
+
+void UEquipmentManagerComponent::EquipFromInventory(int64 ItemID)
+{
+	check(GetOwner()->HasAuthority());
+
+	UInventoryComponent* InventoryComponent = GetOwnerInventoryComponent();
+	if (!IsValid(InventoryComponent))
+	{
+		return;
+	}
+
+	const FRPGInventoryEntry* InventoryEntry = InventoryComponent->InventoryList.FindEntryByID(ItemID);
+	if (!InventoryEntry)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UEquipmentManagerComponent::EquipFromInventory - ItemID %lld not found in inventory"), ItemID);
+		return;
+	}
+
+	const TSubclassOf<UEquipmentDefinition> EquipmentClass =
+		InventoryComponent->GetItemDefinitionByTag(InventoryEntry->ItemTag).EquipmentItemProps.EquipmentClass;
+	if (!EquipmentClass)
+	{
+		return;
+	}
+
+	if (UEquipmentInstance* Result = EquipmentList.AddEntry(BuildEquipmentEntry(*InventoryEntry, EquipmentClass)))
 	{
 		Result->OnEquipped();
 	}
 }
 
+UInventoryComponent* UEquipmentManagerComponent::GetOwnerInventoryComponent() const
+{
+	AActor* Owner = GetOwner();
+	if (!IsValid(Owner) || !Owner->GetClass()->ImplementsInterface(UInventoryInterface::StaticClass()))
+	{
+		return nullptr;
+	}
+
+	return IInventoryInterface::Execute_GetInventoryComponent(Owner);
+}
+
 void UEquipmentManagerComponent::UnEquipItemByItemID(int64 ItemID)
 {
 	if (const FGameplayTag& Tag = GetSlotTagByItemID(ItemID); Tag.IsValid())
@@ -314,9 +473,9 @@ FRPGEquipmentEntry* UEquipmentManagerComponent::GetEquipmentEntryBySlot(const FG
 	return const_cast<FRPGEquipmentEntry*>(EquipmentList.FindEntryBySlot(SlotTag));
 }
 
-void UEquipmentManagerComponent::ServerEquipItem_Implementation(FRPGEquipmentEntry InEntry)
+void UEquipmentManagerComponent::ServerEquipItem_Implementation(int64 ItemID)
 {
-	EquipItem(InEntry);
+	EquipItem(ItemID);
 }
 
 void UEquipmentManagerComponent::ServerUnEquipItem_Implementation(FGameplayTag SlotTag)
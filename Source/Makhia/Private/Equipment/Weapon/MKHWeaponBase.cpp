@@ -3,8 +3,37 @@
 
 #include "Equipment/Weapon/MKHWeaponBase.h"
 
+#include "AbilitySystemGlobals.h"
+#include "AbilitySystem/MKHAbilitySystemComponent.h"
+#include "Combat/LagCompensationSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Libraries/MKHAbilitySystemLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Swing Sweep"), STAT_WeaponSwingSweep, STATGROUP_Game);
+
+namespace WeaponHitScan
+{
+	float MaxStepDistance = 0.f;
+	FAutoConsoleVariableRef CVarMaxStepDistance(
+		TEXT("Makhia.Combat.SwingMaxStepDistance"),
+		MaxStepDistance,
+		TEXT("Longest blade travel covered by one swept capsule; 0 uses the weapon's HitScanRadius."));
+
+	int32 MaxSubSteps = 8;
+	FAutoConsoleVariableRef CVarMaxSubSteps(
+		TEXT("Makhia.Combat.SwingMaxSubSteps"),
+		MaxSubSteps,
+		TEXT("Upper bound of swept capsules per weapon per frame."));
+}
+
 AMKHWeaponBase::AMKHWeaponBase()
 {
+	// Ticks only during a swing, after the wielder's pose has moved the blade
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
 	TraceStart = CreateDefaultSubobject<USceneComponent>(TEXT("TraceStart"));
 	TraceStart->SetupAttachment(GetRootComponent());
 	
@@ -29,3 +58,200 @@ FVector AMKHWeaponBase::GetProjectileSpawnLocation() const
 {
 	return ProjectileSpawnPoint ? ProjectileSpawnPoint->GetComponentLocation() : GetActorLocation();
 }
+
+bool AMKHWeaponBase::LagCompensatedSweep(TArray<FHitResult>& OutHits) const
+{
+	const ULagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULagCompensationSubsystem>(GetWorld());
+	if (!LagCompensation || !TraceStart || !TraceEnd)
+	{
+		return false;
+	}
+
+	AActor* Attacker = GetOwner();
+	const UMKHAbilitySystemComponent* ASC = Cast<UMKHAbilitySystemComponent>(UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Attacker));
+	const float ViewDelay = ASC ? ASC->GetClientViewDelay() : 0.f;
+
+	return LagCompensation->SweepRewound(TraceStart->GetComponentLocation(), TraceEnd->GetComponentLocation(), HitScanRadius, ViewDelay, Attacker, OutHits);
+}
+
+void AMKHWeaponBase::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	CollectSwingSweeps();
+
+	if (bSwingActive)
+	{
+		HitScan();
+	}
+
+	ApplySwingHits();
+
+	if (!bSwingActive && PendingSweeps.IsEmpty())
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void AMKHWeaponBase::HitScanStart_Implementation(FDamageEffectInfo DamageEffectInfo)
+{
+	if (!HasAuthority() || !TraceStart || !TraceEnd)
+	{
+		return;
+	}
+
+	// A previous swing still gets the sweeps it submitted on earlier frames; any from this frame count for the new swing
+	CollectSwingSweeps();
+	ApplySwingHits();
+
+	CachedDamageEffectInfo = DamageEffectInfo;
+	SwingHitTargets.Reset();
+	HitActors.Reset();
+
+	const UMKHAbilitySystemComponent* ASC = Cast<UMKHAbilitySystemComponent>(UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(GetOwner()));
+	bRewindPawns = ASC && ASC->GetClientViewDelay() > 0.f && ULagCompensationSubsystem::GetMaxRewindSeconds() > 0.f
+		&& UWorld::GetSubsystem<ULagCompensationSubsystem>(GetWorld());
+
+	LastTraceStart = TraceStart->GetComponentLocation();
+	LastTraceEnd = TraceEnd->GetComponentLocation();
+	bSwingActive = true;
+
+	HitScan();
+	SetActorTickEnabled(true);
+}
+
+void AMKHWeaponBase::HitScanEnd_Implementation()
+{
+	if (!bSwingActive)
+	{
+		return;
+	}
+
+	// Cover the blade's travel since the last tick; the tick runs on until these sweeps are read next frame
+	HitScan();
+	bSwingActive = false;
+}
+
+void AMKHWeaponBase::HitScan_Implementation()
+{
+	SCOPE_CYCLE_COUNTER(STAT_WeaponSwingSweep);
+
+	UWorld* World = GetWorld();
+	if (!World || !HasAuthority() || !TraceStart || !TraceEnd)
+	{
+		return;
+	}
+
+	AActor* Attacker = GetOwner();
+	const FVector Start = TraceStart->GetComponentLocation();
+	const FVector End = TraceEnd->GetComponentLocation();
+	const float Radius = FMath::Max(HitScanRadius, 1.f);
+
+	// Enough steps that no point of the blade moves more than one step distance between two capsules
+	const float Travel = FMath::Max(FVector::Dist(Start, LastTraceStart), FVector::Dist(End, LastTraceEnd));
+	const float StepDistance = WeaponHitScan::MaxStepDistance > 0.f ? WeaponHitScan::MaxStepDistance : Radius;
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt(Travel / StepDistance), 1, FMath::Max(WeaponHitScan::MaxSubSteps, 1));
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WeaponSwingSweep), false, Attacker);
+	QueryParams.AddIgnoredActor(this);
+	const FCollisionObjectQueryParams ObjectParams(HitScanObjectType.GetValue());
+
+	const ULagCompensationSubsystem* LagCompensation = bRewindPawns ? UWorld::GetSubsystem<ULagCompensationSubsystem>(World) : nullptr;
+	const UMKHAbilitySystemComponent* ASC = LagCompensation ? Cast<UMKHAbilitySystemComponent>(UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Attacker)) : nullptr;
+	const float ViewDelay = ASC ? ASC->GetClientViewDelay() : 0.f;
+	TArray<FHitResult> RewoundHits;
+
+	FVector PreviousCenter = (LastTraceStart + LastTraceEnd) * 0.5;
+	for (int32 Step = 1; Step <= NumSteps; ++Step)
+	{
+		const float Alpha = static_cast<float>(Step) / NumSteps;
+		const FVector StepStart = FMath::Lerp(LastTraceStart, Start, Alpha);
+		const FVector StepEnd = FMath::Lerp(LastTraceEnd, End, Alpha);
+		const FVector StepCenter = (StepStart + StepEnd) * 0.5;
+		const FVector Blade = StepEnd - StepStart;
+
+		// Capsule along the blade at this step, translated from the previous step's center
+		const FQuat Rotation = Blade.IsNearlyZero() ? FQuat::Identity : FRotationMatrix::MakeFromZ(Blade).ToQuat();
+		const FCollisionShape Capsule = FCollisionShape::MakeCapsule(Radius, Blade.Size() * 0.5f + Radius);
+		FPendingSweep& Sweep = PendingSweeps.AddDefaulted_GetRef();
+		Sweep.Handle = World->AsyncSweepByObjectType(EAsyncTraceType::Multi, PreviousCenter, StepCenter, Rotation, ObjectParams, Capsule, QueryParams);
+		Sweep.Frame = GFrameCounter;
+
+		if (LagCompensation)
+		{
+			RewoundHits.Reset();
+			LagCompensation->SweepRewound(StepStart, StepEnd, Radius, ViewDelay, Attacker, RewoundHits);
+			for (const FHitResult& Hit : RewoundHits)
+			{
+				AddSwingHit(Hit);
+			}
+		}
+
+		PreviousCenter = StepCenter;
+	}
+
+	LastTraceStart = Start;
+	LastTraceEnd = End;
+}
+
+void AMKHWeaponBase::CollectSwingSweeps()
+{
+	UWorld* World = GetWorld();
+	if (!World || PendingSweeps.IsEmpty())
+	{
+		return;
+	}
+
+	const ULagCompensationSubsystem* LagCompensation = bRewindPawns ? UWorld::GetSubsystem<ULagCompensationSubsystem>(World) : nullptr;
+
+	FTraceDatum Datum;
+	PendingSweeps.RemoveAll([&](const FPendingSweep& Sweep)
+	{
+		if (!World->QueryTraceData(Sweep.Handle, Datum))
+		{
+			// Sweeps of this frame only run at its end; older ones without data are lost
+			return Sweep.Frame != GFrameCounter;
+		}
+
+		for (const FHitResult& Hit : Datum.OutHits)
+		{
+			// Recorded pawns were already tested where the attacker saw them
+			if (LagCompensation && LagCompensation->IsRecorded(Hit.GetActor()))
+			{
+				continue;
+			}
+			AddSwingHit(Hit);
+		}
+		return true;
+	});
+}
+
+void AMKHWeaponBase::AddSwingHit(const FHitResult& Hit)
+{
+	AActor* Target = Hit.GetActor();
+	if (!Target || Target == GetOwner() || Target == this)
+	{
+		return;
+	}
+
+	bool bAlreadyHit = false;
+	SwingHitTargets.Add(FObjectKey(Target), &bAlreadyHit);
+	if (bAlreadyHit || !UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Target))
+	{
+		return;
+	}
+
+	HitActors.Add(Target);
+	FrameHits.Add(Hit);
+}
+
+void AMKHWeaponBase::ApplySwingHits()
+{
+	if (FrameHits.IsEmpty())
+	{
+		return;
+	}
+
+	UMKHAbilitySystemLibrary::ApplyDamageEffectToHits(CachedDamageEffectInfo, FrameHits);
+	FrameHits.Reset();
+}
@@ -3,6 +3,8 @@
 
 #include "GameMode/MKHGameMode.h"
 
+#include "Kismet/GameplayStatics.h"
+
 UCharacterClassInfo* AMKHGameMode::GetCharacterClassDefaultInfo() const
 {
 	return ClassDefaults;
@@ -12,3 +14,22 @@ UProjectileInfo* AMKHGameMode::GetProjectileInfo() const
 {
 	return ProjectileInfo;
 }
+
+void AMKHGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	MatchLootSeed = FixedLootSeed != 0 ? FixedLootSeed : FMath::Rand();
+	if (UGameplayStatics::HasOption(Options, TEXT("LootSeed")))
+	{
+		MatchLootSeed = UGameplayStatics::GetIntOption(Options, TEXT("LootSeed"), MatchLootSeed);
+	}
+	LootDropCounter = 0;
+
+	UE_LOG(LogTemp, Log, TEXT("AMKHGameMode::InitGame - Match loot seed %d"), MatchLootSeed);
+}
+
+int32 AMKHGameMode::NextLootDropSeed()
+{
+	return static_cast<int32>(HashCombine(static_cast<uint32>(MatchLootSeed), ++LootDropCounter));
+}
@@ -4,6 +4,7 @@
 #include "Inventory/InventoryComponent.h"
 #include "Inventory/ItemTypesToTables.h"
 #include "Data/EquipmentStatEffects.h"
+#include "Data/EquipmentLootTable.h"
 #include "AbilitySystemComponent.h"
 #include "NativeGameplayTags.h"
 #include "AbilitySystemBlueprintLibrary.h"
@@ -14,11 +15,24 @@
 #include "Libraries/EquipmentRollLibrary.h"
 #include "Equipment/EquipmentDefinition.h"
 #include "Equipment/Rarity/RarityDefinition.h"
+#include "GameMode/MKHGameMode.h"
 #include "Interfaces/QuickSlotInterface.h"
 #include "Net/UnrealNetwork.h"
 #include "Inventory/InventoryItem/InventoryItem.h"
+#include "Inventory/LootPipelineSubsystem.h"
 #include "QuickSlot/QuickSlotManagerComponent.h"
 
+namespace InventoryRolls
+{
+	/** Logs the (seed, definition) pair needed to regenerate a rolled item. Safe to call from worker threads. */
+	void LogRolledEntry(const FRPGInventoryEntry& Entry, const UClass* EquipmentClass)
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("FRPGInventoryList::RollEquipmentEntry - Rolled %s (%s) with seed %d: %s, %d stats, %d abilities"),
+			*Entry.ItemTag.ToString(), *GetNameSafe(EquipmentClass), Entry.RollSeed,
+			*Entry.RarityTag.ToString(), Entry.EffectPackage.StatEffects.Num(), Entry.EffectPackage.Abilities.Num());
+	}
+}
+
 void FRPGInventoryList::AddItem(const FGameplayTag& ItemTag, int32 NumItems)
 {
 	// Non-equipment items can be stacked onto an existing entry
@@ -32,22 +46,55 @@ void FRPGInventoryList::AddItem(const FGameplayTag& ItemTag, int32 NumItems)
 
 	const FMasterItemDefinition ItemDef = OwnerComponent->GetItemDefinitionByTag(ItemTag);
 
-	FRPGInventoryEntry& NewEntry = Entries.AddDefaulted_GetRef();
+	FRPGInventoryEntry NewEntry;
 	NewEntry.ItemTag = ItemTag;
 	NewEntry.ItemName = ItemDef.ItemName;
 	NewEntry.Quantity = NumItems;
-	NewEntry.ItemID = GenerateID();
+	NewEntry.RollSeed = OwnerComponent->NextLootDropSeed();
+
+	const FEquipmentRollSources Sources = GetRollSources();
+	if (NewEntry.ItemTag.MatchesTag(MKHGameplayTags::Equip::Category_Equipment) && Sources.CanRoll())
+	{
+		const TSubclassOf<UEquipmentDefinition> EquipmentClass = ItemDef.EquipmentItemProps.EquipmentClass;
+		if (EquipmentClass && (!Sources.LootTable || !Sources.LootTable->HasPool(EquipmentClass)))
+		{
+			UEquipmentRollLibrary::PrewarmRollCaches(GetDefault<UEquipmentDefinition>(EquipmentClass), Sources.StatsData, Sources.RarityTable);
+		}
+		RollEquipmentEntry(NewEntry, ItemDef.EquipmentItemProps.EquipmentClass, NewEntry.RollSeed, Sources);
+	}
 
-	if (NewEntry.ItemTag.MatchesTag(MKHGameplayTags::Equip::Category_Equipment)
-		&& IsValid(WeakStatsData.Get())
-		&& WeakRarityTable.IsValid())
+	AddRolledEntry(MoveTemp(NewEntry));
+}
+
+void FRPGInventoryList::AddRolledEntry(FRPGInventoryEntry&& RolledEntry)
+{
+	// A stack may have appeared while a deferred roll was in flight
+	if (!RolledEntry.ItemTag.MatchesTag(MKHGameplayTags::Equip::Category_Equipment))
 	{
-		RollEquipmentEntry(NewEntry, ItemDef);
+		if (TryStackItem(RolledEntry.ItemTag, RolledEntry.Quantity))
+		{
+			return;
+		}
 	}
 
+	FRPGInventoryEntry& NewEntry = Entries.Add_GetRef(MoveTemp(RolledEntry));
+
+	// The ID has its own stream so the roll only depends on the seed, not on how many bits the ID consumed.
+	FRandomStream IDStream(~NewEntry.RollSeed);
+	NewEntry.ItemID = GenerateID(IDStream);
+
 	BroadcastNewEntry(NewEntry);
 }
 
+FEquipmentRollSources FRPGInventoryList::GetRollSources() const
+{
+	FEquipmentRollSources Sources;
+	Sources.LootTable = WeakLootTable.Get();
+	Sources.StatsData = WeakStatsData.Get();
+	Sources.RarityTable = WeakRarityTable.Get();
+	return Sources;
+}
+
 bool FRPGInventoryList::TryStackItem(const FGameplayTag& ItemTag, int32 NumItems)
 {
 	for (auto EntryIt = Entries.CreateIterator(); EntryIt; ++EntryIt)
@@ -99,20 +146,55 @@ void FRPGInventoryList::RelocateQuickSlotOccupant(FRPGInventoryEntry& EntryToAss
 	QuickSlotItemRelocatedDelegate.Broadcast(*ExistingOccupant);
 }
 
-void FRPGInventoryList::RollEquipmentEntry(FRPGInventoryEntry& NewEntry, const FMasterItemDefinition& ItemDef)
+void FRPGInventoryList::RollEquipmentEntry(FRPGInventoryEntry& NewEntry, TSubclassOf<UEquipmentDefinition> EquipmentClass, int32 RollSeed,
+	const FEquipmentRollSources& Sources)
 {
-	if (!ItemDef.EquipmentItemProps.EquipmentClass)
+	NewEntry.RollSeed = RollSeed;
+	FRandomStream Stream(RollSeed);
+
+	if (!EquipmentClass)
 	{
 		return;
 	}
 
-	const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(ItemDef.EquipmentItemProps.EquipmentClass);
+	const UEquipmentDefinition* EquipmentCDO = GetDefault<UEquipmentDefinition>(EquipmentClass);
 	if (!EquipmentCDO)
 	{
 		return;
 	}
 
-	const FRarityDefinition* Rarity = UEquipmentRollLibrary::RollRarity(WeakRarityTable.Get());
+	if (const UEquipmentLootTable* LootTable = Sources.LootTable)
+	{
+		if (LootTable->HasPool(EquipmentCDO->GetClass()))
+		{
+			const FRarityDefinition* Rarity = LootTable->RollRarity(Stream);
+			if (!Rarity)
+			{
+				return;
+			}
+
+			NewEntry.RarityTag = Rarity->RarityTag;
+			LootTable->RollEffectPackage(EquipmentCDO->GetClass(), *Rarity, Stream, NewEntry.EffectPackage);
+
+			if (EquipmentCDO->SlotTag.MatchesTag(MKHGameplayTags::Equip::WeaponSlot))
+			{
+				UMKHAbilitySystemLibrary::AssignDynamicSkillInputTag(NewEntry);
+			}
+
+			InventoryRolls::LogRolledEntry(NewEntry, EquipmentClass);
+			return;
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("FRPGInventoryList::RollEquipmentEntry - %s is missing from %s, re-bake the loot table"),
+			*GetNameSafe(EquipmentCDO->GetClass()), *LootTable->GetName());
+
+		if (!Sources.StatsData || !Sources.RarityTable)
+		{
+			return;
+		}
+	}
+
+	const FRarityDefinition* Rarity = UEquipmentRollLibrary::RollRarity(Sources.RarityTable, Stream);
 	if (!Rarity)
 	{
 		return;
@@ -121,20 +203,22 @@ void FRPGInventoryList::RollEquipmentEntry(FRPGInventoryEntry& NewEntry, const F
 	NewEntry.RarityTag = Rarity->RarityTag;
 
 	NewEntry.EffectPackage.StatEffects = UEquipmentRollLibrary::RollPassiveStats(
-		EquipmentCDO, WeakStatsData.Get(), Rarity->NumPassiveStats);
+		EquipmentCDO, Sources.StatsData, Rarity->NumPassiveStats, Stream);
 
 	if (EquipmentCDO->SlotTag.MatchesTag(MKHGameplayTags::Equip::WeaponSlot))
 	{
 		NewEntry.EffectPackage.Abilities = UEquipmentRollLibrary::ResolveAbilitiesByTags(
-			EquipmentCDO->BasicAbilitiesGranted, WeakStatsData.Get());
+			EquipmentCDO->BasicAbilitiesGranted, Sources.StatsData);
 
 		const TArray<FEquipmentAbilityDefinition> RolledAbilities = UEquipmentRollLibrary::RollActiveAbilities(
-			EquipmentCDO, WeakStatsData.Get(), Rarity->NumActiveAbilities);
+			EquipmentCDO, Sources.StatsData, Rarity->NumActiveAbilities, Stream);
 
 		// Optional abilities from rarity are independent of guaranteed basic abilities.
 		NewEntry.EffectPackage.Abilities.Append(RolledAbilities);
 		UMKHAbilitySystemLibrary::AssignDynamicSkillInputTag(NewEntry);
 	}
+
+	InventoryRolls::LogRolledEntry(NewEntry, EquipmentClass);
 }
 
 void FRPGInventoryList::BroadcastNewEntry(FRPGInventoryEntry& NewEntry)
@@ -226,16 +310,16 @@ bool FRPGInventoryList::HasEnough(int64 ItemID, int32 NumItems) const
 	return false;
 }
 
-int64 FRPGInventoryList::GenerateID()
+int64 FRPGInventoryList::GenerateID(FRandomStream& Stream)
 {
 	int64 NewID = ++LastAssignedID;
 
 	int32 SignatureIndex = 0;
 	while (SignatureIndex < 12)
 	{
-		if (FMath::RandRange(0, 100) < 85)
+		if (Stream.RandRange(0, 100) < 85)
 		{
-			NewID |= (int64)1 << FMath::RandRange(0, 62);
+			NewID |= (int64)1 << Stream.RandRange(0, 62);
 		}
 		++SignatureIndex;
 	}
@@ -253,6 +337,11 @@ void FRPGInventoryList::SetRarityTable(UDataTable* InRarityTable)
 	WeakRarityTable = InRarityTable;
 }
 
+void FRPGInventoryList::SetLootTable(UEquipmentLootTable* InLootTable)
+{
+	WeakLootTable = InLootTable;
+}
+
 void FRPGInventoryList::AddUnEquippedItem(UInventoryItem* Item)
 {
 	if (!IsValid(Item))
@@ -401,6 +490,7 @@ void UInventoryComponent::BeginPlay()
 	{
 		InventoryList.SetStats(StatEffectsData);
 		InventoryList.SetRarityTable(RarityTable);
+		InventoryList.SetLootTable(LootTable);
 	}
 
 }
@@ -561,6 +651,68 @@ TArray<FRPGInventoryEntry> UInventoryComponent::GetInventoryEntries() const
 	return InventoryList.Entries;
 }
 
+void UInventoryComponent::AddItemDeferred(const FGameplayTag& ItemTag, int32 NumItems)
+{
+	AActor* Owner = GetOwner();
+	if (!IsValid(Owner))
+	{
+		return;
+	}
+
+	if (!Owner->HasAuthority())
+	{
+		ServerAddItem(ItemTag, NumItems);
+		return;
+	}
+
+	ULootPipelineSubsystem* LootPipeline = UWorld::GetSubsystem<ULootPipelineSubsystem>(GetWorld());
+	if (!LootPipeline)
+	{
+		InventoryList.AddItem(ItemTag, NumItems);
+		return;
+	}
+
+	LootPipeline->QueueDrop(this, ItemTag, NumItems);
+}
+
+void UInventoryComponent::AddRolledItem(FRPGInventoryEntry&& RolledEntry)
+{
+	if (!GetOwner() || !GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	InventoryList.AddRolledEntry(MoveTemp(RolledEntry));
+}
+
+int32 UInventoryComponent::NextLootDropSeed() const
+{
+	if (AMKHGameMode* GameMode = GetWorld() ? GetWorld()->GetAuthGameMode<AMKHGameMode>() : nullptr)
+	{
+		return GameMode->NextLootDropSeed();
+	}
+
+	return FMath::Rand();
+}
+
+FRPGInventoryEntry UInventoryComponent::RegenerateRolledItem(const FGameplayTag& ItemTag, int32 RollSeed)
+{
+	FRPGInventoryEntry Entry;
+
+	if (!GetOwner() || !GetOwner()->HasAuthority() || !ItemTag.MatchesTag(MKHGameplayTags::Equip::Category_Equipment))
+	{
+		return Entry;
+	}
+
+	const FMasterItemDefinition ItemDef = GetItemDefinitionByTag(ItemTag);
+	Entry.ItemTag = ItemTag;
+	Entry.ItemName = ItemDef.ItemName;
+	Entry.Quantity = 1;
+
+	FRPGInventoryList::RollEquipmentEntry(Entry, ItemDef.EquipmentItemProps.EquipmentClass, RollSeed, InventoryList.GetRollSources());
+	return Entry;
+}
+
 void UInventoryComponent::AddUnEquippedItemEntry(UInventoryItem* Item)
 {
 	// Only the server adds the item back to the inventory.
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Inventory/LootPipelineSubsystem.h"
+
+#include "AbilitySystem/MKHGameplayTags.h"
+#include "Data/EquipmentLootTable.h"
+#include "Equipment/EquipmentDefinition.h"
+#include "HAL/IConsoleManager.h"
+#include "Inventory/ItemTypes.h"
+#include "Libraries/EquipmentRollLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Loot Pipeline Commit"), STAT_LootPipelineCommit, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Loot Pipeline Roll Batch"), STAT_LootPipelineRollBatch, STATGROUP_Game);
+
+namespace LootPipeline
+{
+	float CommitBudgetMs = 0.5f;
+	FAutoConsoleVariableRef CVarCommitBudgetMs(
+		TEXT("Makhia.Loot.CommitBudgetMs"),
+		CommitBudgetMs,
+		TEXT("Game thread time per frame spent inserting rolled loot into inventories. At least one drop is committed per frame."));
+
+	int32 MaxCommitsPerFrame = 64;
+	FAutoConsoleVariableRef CVarMaxCommitsPerFrame(
+		TEXT("Makhia.Loot.MaxCommitsPerFrame"),
+		MaxCommitsPerFrame,
+		TEXT("Upper bound of rolled drops inserted into inventories per frame (each one is a replicated array change)."));
+
+	int32 RollBatchSize = 16;
+	FAutoConsoleVariableRef CVarRollBatchSize(
+		TEXT("Makhia.Loot.RollBatchSize"),
+		RollBatchSize,
+		TEXT("Number of drops rolled by a single worker task."));
+}
+
+void ULootPipelineSubsystem::Deinitialize()
+{
+	// Workers capture this subsystem, none may outlive it
+	UE::Tasks::Wait(RollTasks);
+	RollTasks.Reset();
+
+	RolledLoot.Empty();
+	PendingRequests.Reset();
+	NumPendingDrops = 0;
+
+	Super::Deinitialize();
+}
+
+bool ULootPipelineSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId ULootPipelineSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULootPipelineSubsystem, STATGROUP_Tickables);
+}
+
+void ULootPipelineSubsystem::QueueDrop(UInventoryComponent* Inventory, const FGameplayTag& ItemTag, int32 NumItems)
+{
+	if (!IsValid(Inventory) || !Inventory->GetOwner() || !Inventory->GetOwner()->HasAuthority() || NumItems <= 0)
+	{
+		return;
+	}
+
+	const FMasterItemDefinition ItemDef = Inventory->GetItemDefinitionByTag(ItemTag);
+
+	FLootRollRequest& Request = PendingRequests.AddDefaulted_GetRef();
+	Request.Inventory = Inventory;
+	Request.Entry.ItemTag = ItemTag;
+	Request.Entry.ItemName = ItemDef.ItemName;
+	Request.Entry.Quantity = NumItems;
+
+	// Seeds are drawn here, in queue order, so the result does not depend on worker scheduling.
+	Request.Entry.RollSeed = Inventory->NextLootDropSeed();
+
+	if (ItemTag.MatchesTag(MKHGameplayTags::Equip::Category_Equipment))
+	{
+		Request.EquipmentClass = ItemDef.EquipmentItemProps.EquipmentClass;
+		Request.Sources = Inventory->InventoryList.GetRollSources();
+
+		// Pools are built here so the workers never build one or touch a DataTable's delegates
+		if (Request.EquipmentClass && (!Request.Sources.LootTable || !Request.Sources.LootTable->HasPool(Request.EquipmentClass)))
+		{
+			UEquipmentRollLibrary::PrewarmRollCaches(GetDefault<UEquipmentDefinition>(Request.EquipmentClass), Request.Sources.StatsData, Request.Sources.RarityTable);
+		}
+	}
+
+	++NumPendingDrops;
+}
+
+void ULootPipelineSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (NumPendingDrops == 0)
+	{
+		return;
+	}
+
+	LaunchRollTasks();
+	CommitRolledLoot();
+
+	RollTasks.RemoveAllSwap([](const UE::Tasks::FTask& Task)
+	{
+		return Task.IsCompleted();
+	});
+}
+
+void ULootPipelineSubsystem::LaunchRollTasks()
+{
+	const int32 BatchSize = FMath::Max(LootPipeline::RollBatchSize, 1);
+
+	for (int32 First = 0; First < PendingRequests.Num(); First += BatchSize)
+	{
+		const int32 Count = FMath::Min(BatchSize, PendingRequests.Num() - First);
+
+		TArray<FLootRollRequest> Batch;
+		Batch.Reserve(Count);
+		for (int32 i = First; i < First + Count; ++i)
+		{
+			Batch.Add(MoveTemp(PendingRequests[i]));
+		}
+
+		RollTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Batch = MoveTemp(Batch)]() mutable
+		{
+			SCOPE_CYCLE_COUNTER(STAT_LootPipelineRollBatch);
+
+			for (FLootRollRequest& Request : Batch)
+			{
+				if (Request.EquipmentClass && Request.Sources.CanRoll())
+				{
+					FRPGInventoryList::RollEquipmentEntry(Request.Entry, Request.EquipmentClass, Request.Entry.RollSeed, Request.Sources);
+				}
+
+				RolledLoot.Enqueue(FRolledLoot{ Request.Inventory, MoveTemp(Request.Entry) });
+			}
+		}));
+	}
+
+	PendingRequests.Reset();
+}
+
+void ULootPipelineSubsystem::CommitRolledLoot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_LootPipelineCommit);
+
+	const double Deadline = FPlatformTime::Seconds() + LootPipeline::CommitBudgetMs * 0.001;
+	int32 NumCommitted = 0;
+
+	FRolledLoot Loot;
+	while (NumCommitted < FMath::Max(LootPipeline::MaxCommitsPerFrame, 1) && RolledLoot.Dequeue(Loot))
+	{
+		if (UInventoryComponent* Inventory = Loot.Inventory.Get())
+		{
+			Inventory->AddRolledItem(MoveTemp(Loot.Entry));
+		}
+
+		++NumCommitted;
+		--NumPendingDrops;
+
+		if (FPlatformTime::Seconds() >= Deadline)
+		{
+			break;
+		}
+	}
+}
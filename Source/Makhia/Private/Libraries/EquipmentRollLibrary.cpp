@@ -8,94 +8,186 @@
 #include "Data/EquipmentStatEffects.h"
 #include "Libraries/MKHAbilitySystemLibrary.h"
 #include "Engine/DataTable.h"
+#include "Misc/ScopeRWLock.h"
+#include "UObject/ObjectKey.h"
 
-int32 UEquipmentRollLibrary::WeightedRandomSelect(const TArray<float>& Weights)
+namespace EquipmentRollCache
 {
-	if (Weights.Num() == 0)
+	using FStatPool = TEquipmentRollPool<FEquipmentStatEffectDefinition>;
+	using FAbilityPool = TEquipmentRollPool<FEquipmentAbilityDefinition>;
+	using FRarityPool = TEquipmentRollPool<FRarityDefinition>;
+	using FDefinitionKey = TPair<TObjectKey<UEquipmentDefinition>, TObjectKey<UEquipmentStatEffects>>;
+
+	/** Guards every container below. Pools themselves are immutable once published. */
+	FRWLock Lock;
+
+	TMap<FDefinitionKey, TSharedPtr<const FStatPool, ESPMode::ThreadSafe>> StatPools;
+	TMap<FDefinitionKey, TSharedPtr<const FAbilityPool, ESPMode::ThreadSafe>> AbilityPools;
+	TMap<TObjectKey<UDataTable>, TSharedPtr<const FRarityPool, ESPMode::ThreadSafe>> RarityPools;
+
+	/** Tables whose change delegate already invalidates the caches. */
+	TSet<TObjectKey<UDataTable>> WatchedTables;
+
+	/** Finds a published pool under a read lock, or builds and publishes it under the write lock. */
+	template<typename KeyType, typename PoolType, typename BuildFunc>
+	TSharedPtr<const PoolType, ESPMode::ThreadSafe> FindOrBuild(TMap<KeyType, TSharedPtr<const PoolType, ESPMode::ThreadSafe>>& Pools,
+		const KeyType& Key, BuildFunc&& Build)
 	{
-		return -1;
+		{
+			FReadScopeLock ReadLock(Lock);
+			if (const TSharedPtr<const PoolType, ESPMode::ThreadSafe>* Found = Pools.Find(Key))
+			{
+				return *Found;
+			}
+		}
+
+		TSharedRef<PoolType, ESPMode::ThreadSafe> NewPool = MakeShared<PoolType, ESPMode::ThreadSafe>();
+		Build(NewPool.Get());
+
+		FWriteScopeLock WriteLock(Lock);
+		if (const TSharedPtr<const PoolType, ESPMode::ThreadSafe>* Found = Pools.Find(Key))
+		{
+			// Another thread published first, keep its pool so every caller samples the same one.
+			return *Found;
+		}
+
+		return Pools.Add(Key, NewPool);
 	}
+}
+
+void FEquipmentAliasTable::Build(TConstArrayView<float> Weights)
+{
+	Probability.Reset();
+	Alias.Reset();
 
-	float TotalWeight = 0.f;
-	for (const float W : Weights)
+	const int32 Count = Weights.Num();
+	double TotalWeight = 0.0;
+	for (const float Weight : Weights)
 	{
-		TotalWeight += W;
+		TotalWeight += FMath::Max(Weight, 0.f);
 	}
 
-	if (TotalWeight <= 0.f)
+	if (Count == 0 || TotalWeight <= 0.0)
 	{
-		return -1;
+		return;
 	}
 
-	float Roll = FMath::FRandRange(0.f, TotalWeight);
-	float Accumulator = 0.f;
+	Probability.SetNumUninitialized(Count);
+	Alias.SetNumUninitialized(Count);
 
-	for (int32 i = 0; i < Weights.Num(); ++i)
+	TArray<double, TInlineAllocator<32>> Scaled;
+	TArray<int32, TInlineAllocator<32>> Small;
+	TArray<int32, TInlineAllocator<32>> Large;
+	Scaled.SetNumUninitialized(Count);
+
+	for (int32 i = 0; i < Count; ++i)
 	{
-		Accumulator += Weights[i];
-		if (Roll <= Accumulator)
-		{
-			return i;
-		}
+		Scaled[i] = FMath::Max(Weights[i], 0.f) * Count / TotalWeight;
+		(Scaled[i] < 1.0 ? Small : Large).Add(i);
+	}
+
+	while (!Small.IsEmpty() && !Large.IsEmpty())
+	{
+		const int32 Less = Small.Pop(EAllowShrinking::No);
+		const int32 More = Large.Pop(EAllowShrinking::No);
+
+		Probability[Less] = static_cast<float>(Scaled[Less]);
+		Alias[Less] = More;
+
+		Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0;
+		(Scaled[More] < 1.0 ? Small : Large).Add(More);
 	}
 
-	return Weights.Num() - 1;
+	// Leftovers are 1.0 up to floating point error: they always keep their own column.
+	for (const int32 Index : Large)
+	{
+		Probability[Index] = 1.f;
+		Alias[Index] = Index;
+	}
+	for (const int32 Index : Small)
+	{
+		Probability[Index] = 1.f;
+		Alias[Index] = Index;
+	}
 }
 
-const FRarityDefinition* UEquipmentRollLibrary::RollRarity(const UDataTable* RarityTable)
+int32 FEquipmentAliasTable::Sample(float ColumnRoll, float CoinRoll) const
 {
-	if (!RarityTable)
+	const int32 Count = Probability.Num();
+	if (Count == 0)
 	{
-		return nullptr;
+		return INDEX_NONE;
 	}
 
-	TArray<FRarityDefinition*> Rows;
-	RarityTable->GetAllRows<FRarityDefinition>(TEXT("RollRarity"), Rows);
+	const int32 Column = FMath::Min(FMath::TruncToInt(ColumnRoll * Count), Count - 1);
+	return CoinRoll < Probability[Column] ? Column : Alias[Column];
+}
+
+float UEquipmentRollLibrary::RollStatLevel(float MinStatLevel, float MaxStatLevel, bool bFractionalStat, FRandomStream& Stream)
+{
+	const float Level = Stream.FRandRange(MinStatLevel, MaxStatLevel);
+	return bFractionalStat ? Level : static_cast<float>(FMath::TruncToInt(Level));
+}
+
+void UEquipmentRollLibrary::InvalidateRollCaches()
+{
+	FWriteScopeLock WriteLock(EquipmentRollCache::Lock);
+
+	EquipmentRollCache::StatPools.Reset();
+	EquipmentRollCache::AbilityPools.Reset();
+	EquipmentRollCache::RarityPools.Reset();
+}
+
+void UEquipmentRollLibrary::WatchDataTable(UDataTable* DataTable)
+{
+	check(IsInGameThread());
 
-	float TotalWeight = 0.f;
-	for (const FRarityDefinition* Row : Rows)
+	if (!DataTable)
 	{
-		TotalWeight += Row->RollProbability;
+		return;
 	}
 
-	if (TotalWeight <= 0.f)
+	FWriteScopeLock WriteLock(EquipmentRollCache::Lock);
+	bool bAlreadyWatched = false;
+	EquipmentRollCache::WatchedTables.Add(DataTable, &bAlreadyWatched);
+	if (!bAlreadyWatched)
 	{
-		return nullptr;
+		DataTable->OnDataTableChanged().AddStatic(&UEquipmentRollLibrary::InvalidateRollCaches);
 	}
+}
 
-	float Roll = FMath::FRandRange(0.f, TotalWeight);
-	float Accumulator = 0.f;
+void UEquipmentRollLibrary::PrewarmRollCaches(const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData, UDataTable* RarityTable)
+{
+	check(IsInGameThread());
 
-	for (const FRarityDefinition* Row : Rows)
+	if (RarityTable)
 	{
-		Accumulator += Row->RollProbability;
-		if (Roll <= Accumulator)
-		{
-			return Row;
-		}
+		WatchDataTable(RarityTable);
+		GetRarityPool(RarityTable);
 	}
 
-	// Fallback: return the last row
-	return Rows.Last();
-}
-
-TArray<FEquipmentStatEffectDefinition> UEquipmentRollLibrary::RollPassiveStats(
-	const UEquipmentDefinition* EquipmentCDO,
-	const UEquipmentStatEffects* StatData,
-	int32 NumStats)
-{
-	TArray<FEquipmentStatEffectDefinition> Result;
+	if (!StatData)
+	{
+		return;
+	}
 
-	if (!EquipmentCDO || !StatData || NumStats <= 0)
+	for (const auto& Pair : StatData->MasterStatMap)
 	{
-		return Result;
+		WatchDataTable(Pair.Value);
 	}
 
-	// Build the weighted candidate pool from PossibleStatRolls
-	TArray<const FEquipmentStatEffectDefinition*> CandidatePool;
-	TArray<float> CandidateWeights;
+	if (EquipmentCDO)
+	{
+		GetStatPool(EquipmentCDO, StatData);
+		GetAbilityPool(EquipmentCDO, StatData);
+	}
+}
 
-	const FGameplayTagContainer& PossibleTags = EquipmentCDO->PossibleStatRolls;
+template<typename RowType>
+void UEquipmentRollLibrary::BuildTagPool(const FGameplayTagContainer& PossibleTags, const UEquipmentStatEffects* StatData,
+	TEquipmentRollPool<RowType>& OutPool)
+{
+	TArray<float> Weights;
 
 	for (int32 i = 0; i < PossibleTags.Num(); ++i)
 	{
@@ -108,101 +200,136 @@ TArray<FEquipmentStatEffectDefinition> UEquipmentRollLibrary::RollPassiveStats(
 				continue;
 			}
 
-			const FEquipmentStatEffectDefinition* PossibleStat =
-				UMKHAbilitySystemLibrary::GetDataTableRowByTag<FEquipmentStatEffectDefinition>(Pair.Value, Tag);
+			const RowType* PossibleRow = UMKHAbilitySystemLibrary::GetDataTableRowByTag<RowType>(Pair.Value, Tag);
 
-			if (PossibleStat && PossibleStat->ProbabilityToSelect > 0.f)
+			if (PossibleRow && PossibleRow->ProbabilityToSelect > 0.f)
 			{
-				CandidatePool.Add(PossibleStat);
-				CandidateWeights.Add(PossibleStat->ProbabilityToSelect);
+				OutPool.Rows.Add(PossibleRow);
+				Weights.Add(PossibleRow->ProbabilityToSelect);
 			}
 			break;
 		}
 	}
 
-	if (CandidatePool.Num() == 0)
-	{
-		return Result;
-	}
+	OutPool.AliasTable.Build(Weights);
+}
 
-	// Roll exactly NumStats stats using weighted selection
-	for (int32 i = 0; i < NumStats; ++i)
-	{
-		const int32 SelectedIndex = WeightedRandomSelect(CandidateWeights);
-		if (SelectedIndex < 0)
+TSharedPtr<const TEquipmentRollPool<FEquipmentStatEffectDefinition>, ESPMode::ThreadSafe> UEquipmentRollLibrary::GetStatPool(
+	const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData)
+{
+	return EquipmentRollCache::FindOrBuild(EquipmentRollCache::StatPools,
+		EquipmentRollCache::FDefinitionKey(EquipmentCDO, StatData),
+		[EquipmentCDO, StatData](FStatPool& Pool)
 		{
-			break;
-		}
+			BuildTagPool(EquipmentCDO->PossibleStatRolls, StatData, Pool);
+		});
+}
+
+TSharedPtr<const TEquipmentRollPool<FEquipmentAbilityDefinition>, ESPMode::ThreadSafe> UEquipmentRollLibrary::GetAbilityPool(
+	const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData)
+{
+	return EquipmentRollCache::FindOrBuild(EquipmentRollCache::AbilityPools,
+		EquipmentRollCache::FDefinitionKey(EquipmentCDO, StatData),
+		[EquipmentCDO, StatData](FAbilityPool& Pool)
+		{
+			BuildTagPool(EquipmentCDO->PossibleAbilityRolls, StatData, Pool);
+		});
+}
+
+TSharedPtr<const TEquipmentRollPool<FRarityDefinition>, ESPMode::ThreadSafe> UEquipmentRollLibrary::GetRarityPool(const UDataTable* RarityTable)
+{
+	return EquipmentRollCache::FindOrBuild(EquipmentRollCache::RarityPools,
+		TObjectKey<UDataTable>(RarityTable),
+		[RarityTable](FRarityPool& Pool)
+		{
+			TArray<FRarityDefinition*> Rows;
+			RarityTable->GetAllRows<FRarityDefinition>(TEXT("RollRarity"), Rows);
 
-		const FEquipmentStatEffectDefinition* Selected = CandidatePool[SelectedIndex];
+			TArray<float> Weights;
+			for (const FRarityDefinition* Row : Rows)
+			{
+				if (Row->RollProbability > 0.f)
+				{
+					Pool.Rows.Add(Row);
+					Weights.Add(Row->RollProbability);
+				}
+			}
 
-		FEquipmentStatEffectDefinition NewStat = *Selected;
-		NewStat.CurrentValue = Selected->bFractionalStat
-			? FMath::FRandRange(Selected->MinStatLevel, Selected->MaxStatLevel)
-			: static_cast<float>(FMath::TruncToInt(FMath::RandRange(Selected->MinStatLevel, Selected->MaxStatLevel)));
+			Pool.AliasTable.Build(Weights);
+		});
+}
 
-		Result.Add(NewStat);
+const FRarityDefinition* UEquipmentRollLibrary::RollRarity(const UDataTable* RarityTable, FRandomStream& Stream)
+{
+	if (!RarityTable)
+	{
+		return nullptr;
 	}
 
-	return Result;
+	const TSharedPtr<const FRarityPool, ESPMode::ThreadSafe> Pool = GetRarityPool(RarityTable);
+	const int32 SelectedIndex = Pool->AliasTable.Sample(Stream);
+
+	return SelectedIndex != INDEX_NONE ? Pool->Rows[SelectedIndex] : nullptr;
 }
 
-TArray<FEquipmentAbilityDefinition> UEquipmentRollLibrary::RollActiveAbilities(
+TArray<FEquipmentStatEffectDefinition> UEquipmentRollLibrary::RollPassiveStats(
 	const UEquipmentDefinition* EquipmentCDO,
 	const UEquipmentStatEffects* StatData,
-	int32 NumAbilities)
+	int32 NumStats,
+	FRandomStream& Stream)
 {
-	TArray<FEquipmentAbilityDefinition> Result;
+	TArray<FEquipmentStatEffectDefinition> Result;
 
-	if (!EquipmentCDO || !StatData || NumAbilities <= 0)
+	if (!EquipmentCDO || !StatData || NumStats <= 0)
 	{
 		return Result;
 	}
 
-	// Build the weighted candidate pool from PossibleAbilityRolls
-	TArray<const FEquipmentAbilityDefinition*> CandidatePool;
-	TArray<float> CandidateWeights;
+	const TSharedPtr<const FStatPool, ESPMode::ThreadSafe> Pool = GetStatPool(EquipmentCDO, StatData);
+	if (Pool->AliasTable.IsEmpty())
+	{
+		return Result;
+	}
 
-	const FGameplayTagContainer& PossibleTags = EquipmentCDO->PossibleAbilityRolls;
+	Result.Reserve(NumStats);
 
-	for (int32 i = 0; i < PossibleTags.Num(); ++i)
+	// Roll exactly NumStats stats using weighted selection
+	for (int32 i = 0; i < NumStats; ++i)
 	{
-		const FGameplayTag& Tag = PossibleTags.GetByIndex(i);
+		const FEquipmentStatEffectDefinition* Selected = Pool->Rows[Pool->AliasTable.Sample(Stream)];
 
-		for (const auto& Pair : StatData->MasterStatMap)
-		{
-			if (!Tag.MatchesTag(Pair.Key))
-			{
-				continue;
-			}
+		FEquipmentStatEffectDefinition& NewStat = Result.Add_GetRef(*Selected);
+		NewStat.CurrentValue = RollStatLevel(Selected->MinStatLevel, Selected->MaxStatLevel, Selected->bFractionalStat, Stream);
+	}
 
-			const FEquipmentAbilityDefinition* PossibleAbility =
-				UMKHAbilitySystemLibrary::GetDataTableRowByTag<FEquipmentAbilityDefinition>(Pair.Value, Tag);
+	return Result;
+}
 
-			if (PossibleAbility && PossibleAbility->ProbabilityToSelect > 0.f)
-			{
-				CandidatePool.Add(PossibleAbility);
-				CandidateWeights.Add(PossibleAbility->ProbabilityToSelect);
-			}
-			break;
-		}
+TArray<FEquipmentAbilityDefinition> UEquipmentRollLibrary::RollActiveAbilities(
+	const UEquipmentDefinition* EquipmentCDO,
+	const UEquipmentStatEffects* StatData,
+	int32 NumAbilities,
+	FRandomStream& Stream)
+{
+	TArray<FEquipmentAbilityDefinition> Result;
+
+	if (!EquipmentCDO || !StatData || NumAbilities <= 0)
+	{
+		return Result;
 	}
 
-	if (CandidatePool.Num() == 0)
+	const TSharedPtr<const FAbilityPool, ESPMode::ThreadSafe> Pool = GetAbilityPool(EquipmentCDO, StatData);
+	if (Pool->AliasTable.IsEmpty())
 	{
 		return Result;
 	}
 
+	Result.Reserve(NumAbilities);
+
 	// Roll exactly NumAbilities abilities using weighted selection
 	for (int32 i = 0; i < NumAbilities; ++i)
 	{
-		const int32 SelectedIndex = WeightedRandomSelect(CandidateWeights);
-		if (SelectedIndex < 0)
-		{
-			break;
-		}
-
-		Result.Add(*CandidatePool[SelectedIndex]);
+		Result.Add(*Pool->Rows[Pool->AliasTable.Sample(Stream)]);
 	}
 
 	return Result;
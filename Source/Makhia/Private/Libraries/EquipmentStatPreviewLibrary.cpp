@@ -0,0 +1,285 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Libraries/EquipmentStatPreviewLibrary.h"
+
+#include "AbilitySystemComponent.h"
+#include "GameplayEffect.h"
+#include "Equipment/EquipmentDefinition.h"
+#include "Equipment/EquipmentManagerComponent.h"
+#include "Equipment/EquipmentTypes.h"
+#include "Inventory/InventoryItem/InventoryItem.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_CYCLE_STAT(TEXT("Equipment Stat Preview"), STAT_EquipmentStatPreview, STATGROUP_Game);
+
+namespace EquipmentStatPreview
+{
+	/** Flattened copy of one modifier of a gameplay effect CDO. */
+	struct FModifierDef
+	{
+		FGameplayAttribute Attribute;
+		EGameplayModOp::Type Op = EGameplayModOp::AddBase;
+		FGameplayEffectModifierMagnitude Magnitude;
+	};
+
+	/** Per-attribute running sums, mirroring the channels of FAggregatorModChannel::EvaluateWithBase. */
+	struct FAttributeAccumulator
+	{
+		FGameplayAttribute Attribute;
+		float AddBase = 0.f;
+		float MultiplyAdditive = 1.f;
+		float DivideAdditive = 1.f;
+		float MultiplyCompound = 1.f;
+		float AddFinal = 0.f;
+		float OverrideValue = 0.f;
+		bool bHasOverride = false;
+
+		float Evaluate(const float BaseValue) const
+		{
+			if (bHasOverride)
+			{
+				return OverrideValue;
+			}
+
+			const float Division = FMath::IsNearlyZero(DivideAdditive) ? 1.f : DivideAdditive;
+			return ((BaseValue + AddBase) * MultiplyAdditive / Division * MultiplyCompound) + AddFinal;
+		}
+	};
+
+	using FAccumulatorArray = TArray<FAttributeAccumulator, TInlineAllocator<16>>;
+
+	/** Modifier definitions keyed by gameplay effect class. Game thread only. */
+	TMap<TObjectKey<UClass>, TArray<FModifierDef>> ModifierCache;
+
+	/** Drops the cache whenever effect classes can have changed: blueprint recompiles, hot reload, editor edits. */
+	void BindCacheInvalidation()
+	{
+		static bool bBound = false;
+		if (bBound)
+		{
+			return;
+		}
+		bBound = true;
+
+		FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&)
+		{
+			ModifierCache.Reset();
+		});
+		FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason)
+		{
+			ModifierCache.Reset();
+		});
+#if WITH_EDITOR
+		FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject* Object, FPropertyChangedEvent&)
+		{
+			if (Object && Object->IsA<UGameplayEffect>())
+			{
+				ModifierCache.Reset();
+			}
+		});
+#endif
+	}
+
+	const TArray<FModifierDef>* FindOrCacheModifiers(const UClass* EffectClass)
+	{
+		BindCacheInvalidation();
+
+		const TObjectKey<UClass> Key(EffectClass);
+		if (const TArray<FModifierDef>* Cached = ModifierCache.Find(Key))
+		{
+			return Cached;
+		}
+
+		const UGameplayEffect* EffectCDO = EffectClass->GetDefaultObject<UGameplayEffect>();
+		TArray<FModifierDef>& Modifiers = ModifierCache.Add(Key);
+		Modifiers.Reserve(EffectCDO->Modifiers.Num());
+
+		for (const FGameplayModifierInfo& ModInfo : EffectCDO->Modifiers)
+		{
+			FModifierDef& Def = Modifiers.AddDefaulted_GetRef();
+			Def.Attribute = ModInfo.Attribute;
+			Def.Op = ModInfo.ModifierOp;
+			Def.Magnitude = ModInfo.ModifierMagnitude;
+		}
+
+		return &Modifiers;
+	}
+
+	FAttributeAccumulator& FindOrAddAccumulator(FAccumulatorArray& Accumulators, const FGameplayAttribute& Attribute)
+	{
+		for (FAttributeAccumulator& Accumulator : Accumulators)
+		{
+			if (Accumulator.Attribute == Attribute)
+			{
+				return Accumulator;
+			}
+		}
+
+		FAttributeAccumulator& NewAccumulator = Accumulators.AddDefaulted_GetRef();
+		NewAccumulator.Attribute = Attribute;
+		return NewAccumulator;
+	}
+
+	/** Folds every stat effect of the package into the accumulators. Returns false if something had to be skipped. */
+	bool AccumulatePackage(const FEquipmentEffectPackage& Package, FAccumulatorArray& Accumulators)
+	{
+		bool bComplete = true;
+
+		for (const FEquipmentStatEffectDefinition& StatEffect : Package.StatEffects)
+		{
+			// Soft classes are never loaded here: a tooltip must not hitch the game thread.
+			const UClass* EffectClass = StatEffect.EffectClass.Get();
+			if (!EffectClass)
+			{
+				bComplete = false;
+				continue;
+			}
+
+			// Equipment effects are applied with the rolled value as spec level (see ApplyAndTrackStatEffect).
+			const float Level = StatEffect.CurrentValue;
+
+			for (const FModifierDef& Def : *FindOrCacheModifiers(EffectClass))
+			{
+				float Magnitude = 0.f;
+				if (!Def.Magnitude.GetStaticMagnitudeIfPossible(Level, Magnitude))
+				{
+					bComplete = false;
+					continue;
+				}
+
+				FAttributeAccumulator& Accumulator = FindOrAddAccumulator(Accumulators, Def.Attribute);
+				switch (Def.Op)
+				{
+				case EGameplayModOp::AddBase:
+					Accumulator.AddBase += Magnitude;
+					break;
+				case EGameplayModOp::MultiplyAdditive:
+					Accumulator.MultiplyAdditive += Magnitude - 1.f;
+					break;
+				case EGameplayModOp::DivideAdditive:
+					Accumulator.DivideAdditive += Magnitude - 1.f;
+					break;
+				case EGameplayModOp::MultiplyCompound:
+					Accumulator.MultiplyCompound *= Magnitude;
+					break;
+				case EGameplayModOp::AddFinal:
+					Accumulator.AddFinal += Magnitude;
+					break;
+				case EGameplayModOp::Override:
+					if (!Accumulator.bHasOverride)
+					{
+						Accumulator.bHasOverride = true;
+						Accumulator.OverrideValue = Magnitude;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		return bComplete;
+	}
+}
+
+bool UEquipmentStatPreviewLibrary::PreviewEquipmentSwap(const UAbilitySystemComponent* OwnerASC,
+	const UEquipmentManagerComponent* EquipmentManager, const UInventoryItem* CandidateItem, FEquipmentStatPreview& OutPreview)
+{
+	OutPreview = FEquipmentStatPreview();
+
+	if (!IsValid(OwnerASC) || !IsValid(EquipmentManager) || !IsValid(CandidateItem))
+	{
+		return false;
+	}
+
+	const TSubclassOf<UEquipmentDefinition> EquipmentClass = CandidateItem->ItemDefinition.EquipmentItemProps.EquipmentClass;
+	if (!EquipmentClass)
+	{
+		return false;
+	}
+
+	const FGameplayTag& CandidateSlot = GetDefault<UEquipmentDefinition>(EquipmentClass)->SlotTag;
+
+	const TArray<FRPGEquipmentEntry>& EquippedEntries = EquipmentManager->EquipmentList.GetEntries();
+	TArray<const FEquipmentEffectPackage*, TInlineAllocator<8>> ActivePackages;
+	const FEquipmentEffectPackage* ReplacedPackage = nullptr;
+
+	for (const FRPGEquipmentEntry& Entry : EquippedEntries)
+	{
+		ActivePackages.Add(&Entry.EffectPackage);
+		if (Entry.SlotTag.MatchesTagExact(CandidateSlot))
+		{
+			ReplacedPackage = &Entry.EffectPackage;
+		}
+	}
+
+	EvaluatePackages(OwnerASC, ActivePackages, ReplacedPackage, CandidateItem->EffectPackage, OutPreview);
+	return true;
+}
+
+void UEquipmentStatPreviewLibrary::EvaluatePackages(const UAbilitySystemComponent* OwnerASC,
+	TConstArrayView<const FEquipmentEffectPackage*> ActivePackages, const FEquipmentEffectPackage* ReplacedPackage,
+	const FEquipmentEffectPackage& CandidatePackage, FEquipmentStatPreview& OutPreview)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EquipmentStatPreview);
+	using namespace EquipmentStatPreview;
+
+	OutPreview.Entries.Reset();
+	OutPreview.bIsComplete = true;
+
+	if (!IsValid(OwnerASC))
+	{
+		return;
+	}
+
+	FAccumulatorArray CurrentAccumulators;
+	FAccumulatorArray PreviewAccumulators;
+
+	for (const FEquipmentEffectPackage* Package : ActivePackages)
+	{
+		if (!Package)
+		{
+			continue;
+		}
+
+		OutPreview.bIsComplete &= AccumulatePackage(*Package, CurrentAccumulators);
+		if (Package != ReplacedPackage)
+		{
+			AccumulatePackage(*Package, PreviewAccumulators);
+		}
+	}
+
+	OutPreview.bIsComplete &= AccumulatePackage(CandidatePackage, PreviewAccumulators);
+
+	// Make sure attributes only touched by the outgoing package show up too (their preview is the plain base value).
+	for (const FAttributeAccumulator& Accumulator : CurrentAccumulators)
+	{
+		FindOrAddAccumulator(PreviewAccumulators, Accumulator.Attribute);
+	}
+
+	OutPreview.Entries.Reserve(PreviewAccumulators.Num());
+	for (const FAttributeAccumulator& Preview : PreviewAccumulators)
+	{
+		if (!OwnerASC->HasAttributeSetForAttribute(Preview.Attribute))
+		{
+			continue;
+		}
+
+		const float BaseValue = OwnerASC->GetNumericAttributeBase(Preview.Attribute);
+		const FAttributeAccumulator* Current = CurrentAccumulators.FindByPredicate([&Preview](const FAttributeAccumulator& Accumulator)
+		{
+			return Accumulator.Attribute == Preview.Attribute;
+		});
+
+		FEquipmentStatPreviewEntry& Entry = OutPreview.Entries.AddDefaulted_GetRef();
+		Entry.Attribute = Preview.Attribute;
+		Entry.CurrentValue = Current ? Current->Evaluate(BaseValue) : BaseValue;
+		Entry.PreviewValue = Preview.Evaluate(BaseValue);
+	}
+}
+
+void UEquipmentStatPreviewLibrary::ResetModifierCache()
+{
+	EquipmentStatPreview::ModifierCache.Reset();
+}
@@ -4,9 +4,11 @@
 #include "Libraries/MKHAbilitySystemLibrary.h"
 #include "AbilitySystem/MKHAbilityTypes.h"
 #include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
 #include "GameMode/MKHGameMode.h"
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "Combat/AbilityLatencySubsystem.h"
 #include "Equipment/EquipmentTypes.h"
 #include "Inventory/InventoryComponent.h"
 #include "Kismet/GameplayStatics.h"
@@ -36,15 +38,101 @@ void UMKHAbilitySystemLibrary::ApplyDamageEffect(const FDamageEffectInfo& Damage
 	if (!IsValid(DamageEffectInfo.SourceASC) or !IsValid(DamageEffectInfo.TargetASC))
 		return;
 	
+	const FGameplayEffectSpecHandle SpecHandle = MakeDamageSpec(DamageEffectInfo);
+	if (!SpecHandle.IsValid())
+		return;
+
+	DamageEffectInfo.TargetASC->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
+	UAbilityLatencySubsystem::MarkStage(DamageEffectInfo.SourceAbility, EAbilityLatencyStage::DamageApplied);
+}
+
+void UMKHAbilitySystemLibrary::ApplyDamageEffectToHits(const FDamageEffectInfo& DamageEffectInfo, const TArray<FHitResult>& Hits)
+{
+	if (!IsValid(DamageEffectInfo.SourceASC) || Hits.IsEmpty())
+		return;
+
+	const FGameplayEffectSpecHandle SpecHandle = MakeDamageSpec(DamageEffectInfo);
+	if (!SpecHandle.IsValid())
+		return;
+
+	const FGameplayEffectContextHandle SourceContext = SpecHandle.Data->GetContext();
+	TArray<UAbilitySystemComponent*, TInlineAllocator<32>> DamagedASCs;
+
+	for (const FHitResult& Hit : Hits)
+	{
+		UAbilitySystemComponent* TargetASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Hit.GetActor());
+		if (!IsValid(TargetASC) || DamagedASCs.Contains(TargetASC))
+			continue;
+
+		DamagedASCs.Add(TargetASC);
+		ApplyDamageSpecToTarget(*SpecHandle.Data.Get(), SourceContext, TargetASC, &Hit);
+	}
+
+	if (!DamagedASCs.IsEmpty())
+	{
+		UAbilityLatencySubsystem::MarkStage(DamageEffectInfo.SourceAbility, EAbilityLatencyStage::DamageApplied);
+	}
+}
+
+void UMKHAbilitySystemLibrary::ApplyDamageEffectToTargets(const FDamageEffectInfo& DamageEffectInfo, const TArray<AActor*>& TargetActors)
+{
+	if (!IsValid(DamageEffectInfo.SourceASC) || TargetActors.IsEmpty())
+		return;
+
+	const FGameplayEffectSpecHandle SpecHandle = MakeDamageSpec(DamageEffectInfo);
+	if (!SpecHandle.IsValid())
+		return;
+
+	const FGameplayEffectContextHandle SourceContext = SpecHandle.Data->GetContext();
+	TArray<UAbilitySystemComponent*, TInlineAllocator<32>> DamagedASCs;
+
+	for (AActor* TargetActor : TargetActors)
+	{
+		UAbilitySystemComponent* TargetASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(TargetActor);
+		if (!IsValid(TargetASC) || DamagedASCs.Contains(TargetASC))
+			continue;
+
+		DamagedASCs.Add(TargetASC);
+		ApplyDamageSpecToTarget(*SpecHandle.Data.Get(), SourceContext, TargetASC, nullptr);
+	}
+
+	if (!DamagedASCs.IsEmpty())
+	{
+		UAbilityLatencySubsystem::MarkStage(DamageEffectInfo.SourceAbility, EAbilityLatencyStage::DamageApplied);
+	}
+}
+
+FGameplayEffectSpecHandle UMKHAbilitySystemLibrary::MakeDamageSpec(const FDamageEffectInfo& DamageEffectInfo)
+{
 	FGameplayEffectContextHandle ContextHandle = DamageEffectInfo.SourceASC->MakeEffectContext();
 	ContextHandle.AddSourceObject(DamageEffectInfo.AvatarActor);
+	if (IsValid(DamageEffectInfo.SourceAbility))
+	{
+		ContextHandle.SetAbility(DamageEffectInfo.SourceAbility);
+	}
 	
 	const FGameplayEffectSpecHandle SpecHandle = DamageEffectInfo.SourceASC->MakeOutgoingSpec(DamageEffectInfo.DamageEffect,
 		1.f, ContextHandle);
 
 	UAbilitySystemBlueprintLibrary::AssignTagSetByCallerMagnitude(SpecHandle, MKHGameplayTags::Combat::Data_Damage, DamageEffectInfo.BaseDamage);
 
-	DamageEffectInfo.TargetASC->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
+	return SpecHandle;
+}
+
+void UMKHAbilitySystemLibrary::ApplyDamageSpecToTarget(FGameplayEffectSpec& DamageSpec, const FGameplayEffectContextHandle& SourceContext,
+	UAbilitySystemComponent* TargetASC, const FHitResult* Hit)
+{
+	// The exec calc writes the crit flag into the context, which the applied copy of the spec still shares
+	FGameplayEffectContextHandle TargetContext = SourceContext.Duplicate();
+	if (Hit)
+	{
+		TargetContext.AddHitResult(*Hit, true);
+	}
+
+	// Source tags were captured with the spec, no need to capture them again for every target
+	DamageSpec.SetContext(TargetContext, true);
+
+	TargetASC->ApplyGameplayEffectSpecToSelf(DamageSpec);
 }
 
 void UMKHAbilitySystemLibrary::K2_SetLooseTagCountStatic(UAbilitySystemComponent* ASC, FGameplayTag Tag, int32 NewCount)
@@ -49,13 +49,13 @@ AMKHPlayerCharacter::AMKHPlayerCharacter()
 
 void AMKHPlayerCharacter::BeginPlay()
 {
-	Super::BeginPlay();
-	
-	// Ensure mesh replicates smoothly on clients
+	// Ensure mesh replicates smoothly on clients; set first so dedicated servers can still switch to montages only
 	if (GetMesh())
 	{
 		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
 	}
+	
+	Super::BeginPlay();
 }
 
 void AMKHPlayerCharacter::Tick(float DeltaTime)
@@ -11,6 +11,7 @@
 #include "Net/UnrealNetwork.h"
 #include "AbilitySystem/MKHAbilitySystemComponent.h"
 #include "AbilitySystem/MKHGameplayTags.h"
+#include "Combat/AbilityLatencySubsystem.h"
 #include "Player/PlayerState/MKHPlayerState.h"
 #include "Equipment/EquipmentManagerComponent.h"
 #include "Inventory/InventoryItem/InventoryItem.h"
@@ -77,6 +78,26 @@ void AMKHPlayerController::BeginPlay()
 	
 }
 
+void AMKHPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	if (IsValid(EquipmentComponent))
+	{
+		EquipmentComponent->RefreshEquipmentVisuals();
+	}
+}
+
+void AMKHPlayerController::OnRep_Pawn()
+{
+	Super::OnRep_Pawn();
+
+	if (IsValid(EquipmentComponent))
+	{
+		EquipmentComponent->RefreshEquipmentVisuals();
+	}
+}
+
 void AMKHPlayerController::ChangeMappingContext(const UInputMappingContext* NewMappingContext) const
 {
 	if (UEnhancedInputLocalPlayerSubsystem *Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
@@ -132,6 +153,7 @@ void AMKHPlayerController::AbilityInputPressed(const FGameplayTag& InputTag)
 		
 	if (IsValid(GetRPGAbilitySystemComponent()))
 	{
+		UAbilityLatencySubsystem::MarkInputPressed(this);
 		MKHAbilitySystemComponent->AbilityInputPressed(InputTag);
 	}
 }
@@ -159,8 +181,8 @@ void AMKHPlayerController::BindCallbacksToDependencies() const
 		InventoryComponent->EquipmentItemUsedDelegate.AddLambda(
 			[this](UInventoryItem* InventoryItem)
 			{
-				// Equipping Item from Inventory on Use
-				EquipmentComponent->EquipItem(UEquipmentManagerComponent::BuildEquipmentEntry(InventoryItem));
+				// Equipping Item from Inventory on Use (server only, the entry is rebuilt from the authoritative inventory)
+				EquipmentComponent->EquipFromInventory(InventoryItem->GetItemID());
 			});
 		EquipmentComponent->EquipmentList.UnEquippedEntryDelegate.AddLambda(
 			[this](const FRPGEquipmentEntry& UnEquippedEntry)
@@ -3,10 +3,29 @@
  
 #include "Projectiles/MKHProjectileBase.h"
 #include "Components/SphereComponent.h"
+#include "GameFramework/Pawn.h"
 #include "AbilitySystem/MKHAbilityTypes.h"
 #include "AbilitySystemGlobals.h"
 #include "Libraries/MKHAbilitySystemLibrary.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Projectiles/ProjectilePredictionSubsystem.h"
+
+namespace ProjectilePrediction
+{
+	float MergeDistance = 300.f;
+	FAutoConsoleVariableRef CVarMergeDistance(
+		TEXT("Makhia.Combat.ProjectileMergeDistance"),
+		MergeDistance,
+		TEXT("The server's projectile takes over its predicted copy's position when they are closer than this; farther apart, the copy is culled."));
+
+	float Timeout = 1.f;
+	FAutoConsoleVariableRef CVarTimeout(
+		TEXT("Makhia.Combat.ProjectilePredictionTimeout"),
+		Timeout,
+		TEXT("Seconds a predicted projectile waits for the server's one before it is destroyed."));
+}
 
 AMKHProjectileBase::AMKHProjectileBase()
 {
@@ -42,11 +61,101 @@ void AMKHProjectileBase::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// Predicted stand-ins are spawned by the client and so hold authority too; they only hide on collision
 	if (HasAuthority())
 	{
 		OverlapSphere->OnComponentBeginOverlap.AddDynamic(this, &AMKHProjectileBase::OnSphereBeginOverlap);
 		OverlapSphere->OnComponentHit.AddDynamic(this, &AMKHProjectileBase::OnSphereHit);
 	}
+	else if (ShotId.IsValid() && GetInstigator() && GetInstigator()->IsLocallyControlled())
+	{
+		// Shot ids are only unique per client, so only the shooter may match them against its stand-ins
+		ReconcileWithPrediction();
+	}
+}
+
+void AMKHProjectileBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AMKHProjectileBase, ShotId, COND_OwnerOnly);
+}
+
+void AMKHProjectileBase::InitPredicted(const FMKHProjectileShotId& InShotId)
+{
+	ShotId = InShotId;
+	bPredicted = true;
+	SetReplicates(false);
+	SetLifeSpan(ProjectilePrediction::Timeout);
+}
+
+void AMKHProjectileBase::CatchUp(float DeltaSeconds)
+{
+	if (DeltaSeconds > 0.f && IsValid(ProjectileMovementComponent))
+	{
+		ProjectileMovementComponent->TickComponent(DeltaSeconds, LEVELTICK_All, nullptr);
+	}
+}
+
+void AMKHProjectileBase::ReconcileWithPrediction()
+{
+	UProjectilePredictionSubsystem* Prediction = UWorld::GetSubsystem<UProjectilePredictionSubsystem>(GetWorld());
+	AMKHProjectileBase* Predicted = Prediction ? Prediction->TakePrediction(ShotId) : nullptr;
+	if (!Predicted)
+	{
+		// Not this client's shot, or its copy timed out
+		return;
+	}
+
+	if (Predicted->bPredictedImpact)
+	{
+		// The shooter already saw this shot land; the server's impact only has to remove it
+		SetActorHiddenInGame(true);
+	}
+	else if (FVector::DistSquared(Predicted->GetActorLocation(), GetActorLocation()) <= FMath::Square(ProjectilePrediction::MergeDistance))
+	{
+		SetActorLocationAndRotation(Predicted->GetActorLocation(), Predicted->GetActorRotation());
+		if (IsValid(ProjectileMovementComponent) && IsValid(Predicted->ProjectileMovementComponent))
+		{
+			ProjectileMovementComponent->Velocity = Predicted->ProjectileMovementComponent->Velocity;
+		}
+		bMergedPrediction = true;
+	}
+
+	Predicted->Destroy();
+}
+
+void AMKHProjectileBase::EndPrediction()
+{
+	if (bPredictedImpact)
+	{
+		return;
+	}
+
+	bPredictedImpact = true;
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	if (IsValid(ProjectileMovementComponent))
+	{
+		ProjectileMovementComponent->StopMovementImmediately();
+	}
+}
+
+void AMKHProjectileBase::PostNetReceiveLocationAndRotation()
+{
+	// Merged projectiles keep simulating from the predicted state, ahead of the server's updates
+	if (!bMergedPrediction)
+	{
+		Super::PostNetReceiveLocationAndRotation();
+	}
+}
+
+void AMKHProjectileBase::PostNetReceiveVelocity(const FVector& NewVelocity)
+{
+	if (!bMergedPrediction)
+	{
+		Super::PostNetReceiveVelocity(NewVelocity);
+	}
 }
 
 void AMKHProjectileBase::OnSphereBeginOverlap_Implementation(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, 
@@ -56,6 +165,11 @@ void AMKHProjectileBase::OnSphereBeginOverlap_Implementation(UPrimitiveComponent
 
 	if (UAbilitySystemComponent* TargetASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OtherActor))
 	{
+		if (bPredicted)
+		{
+			return EndPrediction();
+		}
+
 		DamageEffectInfo.TargetASC = TargetASC;
 		UMKHAbilitySystemLibrary::ApplyDamageEffect(DamageEffectInfo);
 
@@ -65,6 +179,11 @@ void AMKHProjectileBase::OnSphereBeginOverlap_Implementation(UPrimitiveComponent
 
 void AMKHProjectileBase::OnSphereHit_Implementation(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
+	if (bPredicted)
+	{
+		return EndPrediction();
+	}
+
 	Destroy();
 }
 
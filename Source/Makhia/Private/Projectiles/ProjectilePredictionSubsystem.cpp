@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Projectiles/ProjectilePredictionSubsystem.h"
+
+#include "Projectiles/MKHProjectileBase.h"
+
+bool UProjectilePredictionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectilePredictionSubsystem::AddPrediction(const FMKHProjectileShotId& ShotId, AMKHProjectileBase* Projectile)
+{
+	if (!ShotId.IsValid() || !IsValid(Projectile))
+	{
+		return;
+	}
+
+	// Entries of projectiles that timed out are dropped here rather than on a timer
+	for (auto It = Predictions.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	Predictions.Add(ShotId, Projectile);
+}
+
+AMKHProjectileBase* UProjectilePredictionSubsystem::TakePrediction(const FMKHProjectileShotId& ShotId)
+{
+	TWeakObjectPtr<AMKHProjectileBase> Projectile;
+	Predictions.RemoveAndCopyValue(ShotId, Projectile);
+	return Projectile.Get();
+}
+
+void UProjectilePredictionSubsystem::CullPredictions(int16 PredictionKey)
+{
+	for (auto It = Predictions.CreateIterator(); It; ++It)
+	{
+		if (It.Key().PredictionKey != PredictionKey)
+		{
+			continue;
+		}
+
+		if (AMKHProjectileBase* Projectile = It.Value().Get())
+		{
+			Projectile->Destroy();
+		}
+		It.RemoveCurrent();
+	}
+}
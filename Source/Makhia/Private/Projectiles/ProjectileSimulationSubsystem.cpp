@@ -0,0 +1,597 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Projectiles/ProjectileSimulationSubsystem.h"
+
+#include "AbilitySystemGlobals.h"
+#include "Async/ParallelFor.h"
+#include "Combat/CombatHitNotifySubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Data/ProjectileInfo.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "HAL/IConsoleManager.h"
+#include "Libraries/MKHAbilitySystemLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Simulation"), STAT_ProjectileSimulation, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Projectile Simulation Sweeps"), STAT_ProjectileSimulationSweeps, STATGROUP_Game);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Projectiles"), STAT_SimulatedProjectiles, STATGROUP_Game);
+
+namespace ProjectileSimulation
+{
+	float StepRate = 60.f;
+	FAutoConsoleVariableRef CVarStepRate(
+		TEXT("Makhia.Projectile.StepRate"),
+		StepRate,
+		TEXT("Simulation steps per second of simulated projectiles. Must match between server and clients for them to fly the same paths."));
+
+	int32 MaxStepsPerFrame = 16;
+	FAutoConsoleVariableRef CVarMaxStepsPerFrame(
+		TEXT("Makhia.Projectile.MaxStepsPerFrame"),
+		MaxStepsPerFrame,
+		TEXT("Most steps a projectile takes in one frame; projectiles further behind (long frames, client catch-up) finish catching up next frame."));
+
+	bool bParallelSweeps = true;
+	FAutoConsoleVariableRef CVarParallelSweeps(
+		TEXT("Makhia.Projectile.ParallelSweeps"),
+		bParallelSweeps,
+		TEXT("Runs the sweeps of a simulation step on worker threads."));
+
+	/** Bounces slower than this end the projectile. */
+	constexpr float MinBounceSpeed = 50.f;
+
+	/** Distance a bounced projectile is pushed off the surface so its next sweep does not start inside it. */
+	constexpr float BounceOffset = 0.1f;
+
+	/** Keeps each relay multicast well within the replicated array limits. */
+	constexpr int32 MaxVolleysPerMulticast = 64;
+	constexpr int32 MaxImpactsPerMulticast = 256;
+
+	/** Returns the parameters volleys of ProjectileTag fly with, or null when the table does not have them. */
+	const FProjectileParams* FindParams(const UProjectileInfo* ProjectileInfo, const FGameplayTag& ProjectileTag)
+	{
+		return ProjectileInfo ? ProjectileInfo->ProjectileInfoMap.Find(ProjectileTag) : nullptr;
+	}
+
+	/** Rounds Value like an FVector_NetQuantize with this scale replicates it, so the server flies what clients receive. */
+	FVector Quantize(const FVector& Value, double Scale)
+	{
+		return FVector(
+			FMath::RoundToDouble(Value.X * Scale) / Scale,
+			FMath::RoundToDouble(Value.Y * Scale) / Scale,
+			FMath::RoundToDouble(Value.Z * Scale) / Scale);
+	}
+}
+
+bool UProjectileSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	if (IsValid(InstanceActor))
+	{
+		InstanceActor->Destroy();
+	}
+	InstanceActor = nullptr;
+	MeshInstances.Reset();
+	MeshGroups.Reset();
+	DamageSlots.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_Tickables);
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileSimulation);
+
+	if (!Ids.IsEmpty())
+	{
+		Simulate(GetSimulationTime());
+	}
+
+	ApplyPendingDamage();
+	FlushNetEvents();
+
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		UpdateInstances();
+	}
+
+	SET_DWORD_STAT(STAT_SimulatedProjectiles, Ids.Num());
+}
+
+double UProjectileSimulationSubsystem::GetSimulationTime() const
+{
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+void UProjectileSimulationSubsystem::SpawnVolley(const FGameplayTag& ProjectileTag, const FVector& Origin,
+	const TArray<FVector>& Directions, AActor* Owner, const FDamageEffectInfo& DamageEffectInfo)
+{
+	if (GetWorld()->GetNetMode() == NM_Client || Directions.IsEmpty())
+	{
+		return;
+	}
+
+	const UCombatHitNotifySubsystem* HitNotifies = UWorld::GetSubsystem<UCombatHitNotifySubsystem>(GetWorld());
+	const AMKHCombatNetRelay* NetRelay = HitNotifies ? HitNotifies->GetNetRelay() : nullptr;
+	const FProjectileParams* Params = ProjectileSimulation::FindParams(NetRelay ? NetRelay->GetProjectileInfo() : nullptr, ProjectileTag);
+	if (!Params)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UProjectileSimulationSubsystem::SpawnVolley - No projectile info for %s"), *ProjectileTag.ToString());
+		return;
+	}
+
+	int32 DamageSlot;
+	if (FreeDamageSlots.IsEmpty())
+	{
+		DamageSlot = DamageSlots.Add(DamageEffectInfo);
+		DamageSlotRefs.Add(0);
+	}
+	else
+	{
+		DamageSlot = FreeDamageSlots.Pop(EAllowShrinking::No);
+		DamageSlots[DamageSlot] = DamageEffectInfo;
+	}
+
+	const double SpawnTime = GetSimulationTime();
+	const FVector QuantizedOrigin = ProjectileSimulation::Quantize(Origin, 10.0);
+
+	// Shots fired from the same point in the same frame, e.g. one per notify of an activation, go out as one volley;
+	// only the last volley can grow, so projectile ids stay consecutive
+	FMKHProjectileVolley* Volley = PendingVolleys.IsEmpty() ? nullptr : &PendingVolleys.Last();
+	if (!Volley || Volley->Owner != Owner || Volley->ProjectileTag != ProjectileTag || Volley->SpawnTime != SpawnTime
+		|| !Volley->Origin.Equals(QuantizedOrigin, 0.0) || Volley->FirstId + Volley->Directions.Num() != NextId)
+	{
+		Volley = &PendingVolleys.AddDefaulted_GetRef();
+		Volley->FirstId = NextId;
+		Volley->SpawnTime = SpawnTime;
+		Volley->Owner = Owner;
+		Volley->Origin = QuantizedOrigin;
+		Volley->ProjectileTag = ProjectileTag;
+	}
+
+	const int32 FirstShot = Volley->Directions.Num();
+	for (const FVector& Direction : Directions)
+	{
+		Volley->Directions.Add(ProjectileSimulation::Quantize(Direction.GetSafeNormal(), 100.0));
+	}
+
+	NextId += Directions.Num();
+
+	AddProjectiles(*Volley, FirstShot, *Params, DamageSlot);
+}
+
+void UProjectileSimulationSubsystem::ReceiveVolleys(const TArray<FMKHProjectileVolley>& Volleys, const UProjectileInfo* ProjectileInfo)
+{
+	// The multicast also runs on a listen server, which added its volleys when firing them
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		return;
+	}
+
+	const double Now = GetSimulationTime();
+	for (const FMKHProjectileVolley& Volley : Volleys)
+	{
+		const FProjectileParams* Params = ProjectileSimulation::FindParams(ProjectileInfo, Volley.ProjectileTag);
+		if (Params && Volley.SpawnTime + Params->MaxLifetime > Now)
+		{
+			AddProjectiles(Volley, 0, *Params, INDEX_NONE);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::ReceiveImpacts(const TArray<FMKHProjectileImpact>& Impacts)
+{
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		return;
+	}
+
+	for (const FMKHProjectileImpact& Impact : Impacts)
+	{
+		// Not found when this client already ended it on the same world hit
+		const int32 Index = Ids.Find(Impact.Id);
+		if (Index != INDEX_NONE)
+		{
+			OnProjectileImpact.Broadcast(Impact.Location);
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::AddProjectiles(const FMKHProjectileVolley& Volley, int32 FirstShot, const FProjectileParams& Params,
+	int32 DamageSlot)
+{
+	const UWorld* World = GetWorld();
+	const float Gravity = World->GetGravityZ() * Params.GravityScale;
+	const float VolleyBounciness = Params.bShouldBounce ? FMath::Max(Params.Bounciness, 0.f) : -1.f;
+	const int32 MeshIndex = World->GetNetMode() != NM_DedicatedServer && Params.ProjectileMesh ? FindOrAddMeshGroup(Params.ProjectileMesh) : INDEX_NONE;
+
+	const int32 NumAdded = Volley.Directions.Num() - FirstShot;
+	for (int32 ShotIndex = FirstShot; ShotIndex < Volley.Directions.Num(); ++ShotIndex)
+	{
+		Ids.Add(Volley.FirstId + ShotIndex);
+		Positions.Add(Volley.Origin);
+		Velocities.Add(Volley.Directions[ShotIndex] * Params.InitialSpeed);
+		GravityZ.Add(Gravity);
+		Bounciness.Add(VolleyBounciness);
+		Radii.Add(Params.CollisionRadius);
+		SimTimes.Add(Volley.SpawnTime);
+		ExpireTimes.Add(Volley.SpawnTime + Params.MaxLifetime);
+		Owners.Add(Volley.Owner.Get());
+		DamageIndices.Add(DamageSlot);
+		MeshIndices.Add(MeshIndex);
+	}
+
+	if (DamageSlot != INDEX_NONE)
+	{
+		DamageSlotRefs[DamageSlot] += NumAdded;
+	}
+}
+
+void UProjectileSimulationSubsystem::Simulate(double Now)
+{
+	// Steps are counted from each projectile's spawn time rather than the frame, so every machine splits a
+	// projectile's flight into the same steps whatever its frame rate.
+	const float StepTime = 1.f / FMath::Max(ProjectileSimulation::StepRate, 1.f);
+
+	for (int32 Round = 0; Round < ProjectileSimulation::MaxStepsPerFrame; ++Round)
+	{
+		StepIndices.Reset();
+		for (int32 Index = 0; Index < Ids.Num(); ++Index)
+		{
+			if (SimTimes[Index] + StepTime <= Now)
+			{
+				StepIndices.Add(Index);
+			}
+		}
+
+		if (StepIndices.IsEmpty())
+		{
+			break;
+		}
+
+		SweepStep(StepTime);
+		ResolveStep(StepTime);
+	}
+}
+
+void UProjectileSimulationSubsystem::SweepStep(float StepTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileSimulationSweeps);
+
+	const UWorld* World = GetWorld();
+	const int32 NumSteps = StepIndices.Num();
+
+	if (StepHits.Num() < NumSteps)
+	{
+		StepHits.SetNum(NumSteps);
+	}
+
+	// Weak pointers are resolved here; the sweeps run off the game thread
+	StepOwners.Reset(NumSteps);
+	for (const int32 Index : StepIndices)
+	{
+		StepOwners.Add(Owners[Index].Get());
+	}
+
+	// Only the server hits pawns; clients learn about those impacts from it
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	if (World->GetNetMode() != NM_Client)
+	{
+		ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	}
+
+	ParallelFor(NumSteps, [&](int32 StepIndex)
+	{
+		const int32 Index = StepIndices[StepIndex];
+		const FVector& Start = Positions[Index];
+		const FVector End = Start + Velocities[Index] * StepTime + FVector(0.f, 0.f, 0.5f * GravityZ[Index] * StepTime * StepTime);
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSimulationSweep), false, StepOwners[StepIndex]);
+
+		TArray<FHitResult>& Hits = StepHits[StepIndex];
+		Hits.Reset();
+		World->SweepMultiByObjectType(Hits, Start, End, FQuat::Identity, ObjectParams, FCollisionShape::MakeSphere(Radii[Index]), QueryParams);
+	}, ProjectileSimulation::bParallelSweeps ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+void UProjectileSimulationSubsystem::ResolveStep(float StepTime)
+{
+	const bool bAuthority = GetWorld()->GetNetMode() != NM_Client;
+	TArray<int32, TInlineAllocator<32>> Ended;
+
+	for (int32 StepIndex = 0; StepIndex < StepIndices.Num(); ++StepIndex)
+	{
+		const int32 Index = StepIndices[StepIndex];
+		const float Gravity = GravityZ[Index];
+
+		const FHitResult* Impact = nullptr;
+		bool bHitTarget = false;
+		for (const FHitResult& Hit : StepHits[StepIndex])
+		{
+			const UPrimitiveComponent* Component = Hit.GetComponent();
+			if (Component && Component->GetCollisionObjectType() == ECC_Pawn)
+			{
+				// Like AMKHProjectileBase, only pawns that take damage stop the projectile
+				if (!UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Hit.GetActor()))
+				{
+					continue;
+				}
+				bHitTarget = true;
+			}
+			Impact = &Hit;
+			break;
+		}
+
+		SimTimes[Index] += StepTime;
+		bool bEnded = false;
+
+		if (!Impact)
+		{
+			Positions[Index] += Velocities[Index] * StepTime + FVector(0.f, 0.f, 0.5f * Gravity * StepTime * StepTime);
+			Velocities[Index].Z += Gravity * StepTime;
+		}
+		else if (!bHitTarget && Bounciness[Index] >= 0.f && !Impact->bStartPenetrating)
+		{
+			// The rest of the step after the bounce is dropped; the next step starts from the surface
+			const FVector Normal = Impact->Normal;
+			FVector Velocity = Velocities[Index];
+			Velocity.Z += Gravity * StepTime * Impact->Time;
+			Velocity -= (1.f + Bounciness[Index]) * (Velocity | Normal) * Normal;
+
+			Positions[Index] = Impact->Location + Normal * ProjectileSimulation::BounceOffset;
+			Velocities[Index] = Velocity;
+
+			// Too slow to bounce again: it comes to rest without an impact
+			bEnded = Velocity.SizeSquared() < FMath::Square(ProjectileSimulation::MinBounceSpeed);
+		}
+		else
+		{
+			OnProjectileImpact.Broadcast(Impact->Location);
+
+			if (bAuthority)
+			{
+				FMKHProjectileImpact& NetImpact = PendingImpacts.AddDefaulted_GetRef();
+				NetImpact.Id = Ids[Index];
+				NetImpact.Location = Impact->Location;
+
+				if (bHitTarget && DamageIndices[Index] != INDEX_NONE)
+				{
+					FPendingDamage& Damage = PendingDamage.AddDefaulted_GetRef();
+					Damage.DamageSlot = DamageIndices[Index];
+					Damage.Hit = *Impact;
+				}
+			}
+			bEnded = true;
+		}
+
+		if (bEnded || SimTimes[Index] >= ExpireTimes[Index])
+		{
+			Ended.Add(Index);
+		}
+	}
+
+	// Highest index first, so each swap-remove moves in a projectile that is staying
+	for (int32 EndedIndex = Ended.Num() - 1; EndedIndex >= 0; --EndedIndex)
+	{
+		RemoveProjectile(Ended[EndedIndex]);
+	}
+}
+
+void UProjectileSimulationSubsystem::RemoveProjectile(int32 Index)
+{
+	const int32 DamageSlot = DamageIndices[Index];
+	if (DamageSlot != INDEX_NONE && --DamageSlotRefs[DamageSlot] == 0)
+	{
+		ReleasedDamageSlots.Add(DamageSlot);
+	}
+
+	Ids.RemoveAtSwap(Index, EAllowShrinking::No);
+	Positions.RemoveAtSwap(Index, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, EAllowShrinking::No);
+	GravityZ.RemoveAtSwap(Index, EAllowShrinking::No);
+	Bounciness.RemoveAtSwap(Index, EAllowShrinking::No);
+	Radii.RemoveAtSwap(Index, EAllowShrinking::No);
+	SimTimes.RemoveAtSwap(Index, EAllowShrinking::No);
+	ExpireTimes.RemoveAtSwap(Index, EAllowShrinking::No);
+	Owners.RemoveAtSwap(Index, EAllowShrinking::No);
+	DamageIndices.RemoveAtSwap(Index, EAllowShrinking::No);
+	MeshIndices.RemoveAtSwap(Index, EAllowShrinking::No);
+}
+
+void UProjectileSimulationSubsystem::ApplyPendingDamage()
+{
+	if (!PendingDamage.IsEmpty())
+	{
+		// One spec per damage slot and pass. ApplyDamageEffectToHits damages each target once, so a target struck by
+		// several projectiles of a slot in the same frame takes the extra hits in further passes.
+		PendingDamage.StableSort([](const FPendingDamage& A, const FPendingDamage& B)
+		{
+			return A.DamageSlot < B.DamageSlot;
+		});
+
+		TArray<FHitResult> Hits;
+		TArray<const AActor*, TInlineAllocator<32>> HitActors;
+
+		for (int32 GroupStart = 0; GroupStart < PendingDamage.Num();)
+		{
+			const int32 DamageSlot = PendingDamage[GroupStart].DamageSlot;
+			int32 GroupEnd = GroupStart;
+			while (GroupEnd < PendingDamage.Num() && PendingDamage[GroupEnd].DamageSlot == DamageSlot)
+			{
+				++GroupEnd;
+			}
+
+			for (;;)
+			{
+				Hits.Reset();
+				HitActors.Reset();
+				for (int32 PendingIndex = GroupStart; PendingIndex < GroupEnd; ++PendingIndex)
+				{
+					FPendingDamage& Damage = PendingDamage[PendingIndex];
+					if (!Damage.bApplied && !HitActors.Contains(Damage.Hit.GetActor()))
+					{
+						Damage.bApplied = true;
+						HitActors.Add(Damage.Hit.GetActor());
+						Hits.Add(Damage.Hit);
+					}
+				}
+
+				if (Hits.IsEmpty())
+				{
+					break;
+				}
+				UMKHAbilitySystemLibrary::ApplyDamageEffectToHits(DamageSlots[DamageSlot], Hits);
+			}
+
+			GroupStart = GroupEnd;
+		}
+
+		PendingDamage.Reset();
+	}
+
+	for (const int32 DamageSlot : ReleasedDamageSlots)
+	{
+		DamageSlots[DamageSlot] = FDamageEffectInfo();
+		FreeDamageSlots.Add(DamageSlot);
+	}
+	ReleasedDamageSlots.Reset();
+}
+
+void UProjectileSimulationSubsystem::FlushNetEvents()
+{
+	if (PendingVolleys.IsEmpty() && PendingImpacts.IsEmpty())
+	{
+		return;
+	}
+
+	const UCombatHitNotifySubsystem* HitNotifies = UWorld::GetSubsystem<UCombatHitNotifySubsystem>(GetWorld());
+	AMKHCombatNetRelay* NetRelay = HitNotifies ? HitNotifies->GetNetRelay() : nullptr;
+	if (IsValid(NetRelay) && GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		for (int32 Start = 0; Start < PendingVolleys.Num(); Start += ProjectileSimulation::MaxVolleysPerMulticast)
+		{
+			const int32 Num = FMath::Min(ProjectileSimulation::MaxVolleysPerMulticast, PendingVolleys.Num() - Start);
+			NetRelay->MulticastProjectileVolleys(TArray<FMKHProjectileVolley>(PendingVolleys.GetData() + Start, Num));
+		}
+
+		// One unreliable multicast per frame at most, next to the hit batch, so none is dropped by net.MaxRPCPerNetUpdate;
+		// the rest of the impacts wait for the next frame.
+		if (!PendingImpacts.IsEmpty())
+		{
+			const int32 Num = FMath::Min(ProjectileSimulation::MaxImpactsPerMulticast, PendingImpacts.Num());
+			NetRelay->MulticastProjectileImpacts(TArray<FMKHProjectileImpact>(PendingImpacts.GetData(), Num));
+			PendingImpacts.RemoveAt(0, Num, EAllowShrinking::No);
+		}
+
+		NetRelay->ForceNetUpdate();
+	}
+	else
+	{
+		PendingImpacts.Reset();
+	}
+
+	PendingVolleys.Reset();
+}
+
+int32 UProjectileSimulationSubsystem::FindOrAddMeshGroup(UStaticMesh* Mesh)
+{
+	const int32 ExistingGroup = MeshGroups.Find(Mesh);
+	if (ExistingGroup != INDEX_NONE)
+	{
+		return ExistingGroup;
+	}
+
+	UWorld* World = GetWorld();
+	if (!IsValid(InstanceActor))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		InstanceActor = World->SpawnActor<AActor>(SpawnParams);
+
+		USceneComponent* Root = NewObject<USceneComponent>(InstanceActor, TEXT("Root"));
+		InstanceActor->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(InstanceActor);
+	Instances->SetStaticMesh(Mesh);
+	Instances->SetMobility(EComponentMobility::Movable);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetupAttachment(InstanceActor->GetRootComponent());
+	Instances->RegisterComponent();
+	InstanceActor->AddInstanceComponent(Instances);
+
+	MeshInstances.Add(Instances);
+	InstanceTransforms.AddDefaulted();
+	return MeshGroups.Add(Mesh);
+}
+
+void UProjectileSimulationSubsystem::UpdateInstances()
+{
+	if (MeshGroups.IsEmpty())
+	{
+		return;
+	}
+
+	for (TArray<FTransform>& Transforms : InstanceTransforms)
+	{
+		Transforms.Reset();
+	}
+
+	for (int32 Index = 0; Index < Ids.Num(); ++Index)
+	{
+		if (MeshIndices[Index] != INDEX_NONE)
+		{
+			InstanceTransforms[MeshIndices[Index]].Emplace(Velocities[Index].ToOrientationQuat(), Positions[Index]);
+		}
+	}
+
+	for (int32 Group = 0; Group < MeshGroups.Num(); ++Group)
+	{
+		UInstancedStaticMeshComponent* Instances = MeshInstances[Group];
+		const TArray<FTransform>& Transforms = InstanceTransforms[Group];
+		if (!IsValid(Instances))
+		{
+			continue;
+		}
+
+		// Instances are only added or removed at the end; everything else is moved in one batch
+		const int32 NumInstances = Instances->GetInstanceCount();
+		if (NumInstances > Transforms.Num())
+		{
+			TArray<int32> Removed;
+			for (int32 InstanceIndex = NumInstances - 1; InstanceIndex >= Transforms.Num(); --InstanceIndex)
+			{
+				Removed.Add(InstanceIndex);
+			}
+			Instances->RemoveInstances(Removed);
+		}
+		else if (NumInstances < Transforms.Num())
+		{
+			Instances->AddInstances(TArray<FTransform>(Transforms.GetData() + NumInstances, Transforms.Num() - NumInstances), false, true, false);
+		}
+
+		if (!Transforms.IsEmpty())
+		{
+			Instances->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+		}
+	}
+}
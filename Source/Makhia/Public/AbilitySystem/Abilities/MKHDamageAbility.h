@@ -32,6 +32,11 @@ public:
 	 * Activates the ability, binding input events and commuting the ability.
 	 */
 	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
+
+	/**
+	 * Ends the ability, releasing any server pose it still holds.
+	 */
+	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;
 	
 	/**
 	 * Pre-activates the ability.
@@ -53,10 +58,26 @@ public:
 	
 	/**
 	 * Retrieves the gameplay tags representing this ability's cooldown.
+	 * Read from the grant configuration when there is one, since cooldown checks run before activation applies it.
 	 * 
 	 * @return A pointer to the cooldown tag container.
 	 */
 	virtual const FGameplayTagContainer* GetCooldownTags() const override;
+
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/**
+	 * Reads the combat events of AttackMontageToPlay into CombatTimeline. Events come from UAnimNotify_CombatEvent, or
+	 * from notifies and notify states whose name contains the event (e.g. "AN_HitScanStart", "ANS_HitScan").
+	 * @param OutErrors Receives one message per window that does not open and close, or one when there is no event at all.
+	 * @return True when the timeline was baked; on failure it is cleared and the server keeps evaluating animation.
+	 */
+	bool BakeCombatTimeline(TArray<FString>& OutErrors);
+#endif
+
+	/** Returns the baked combat events of AttackMontageToPlay. */
+	const FMKHCombatTimeline& GetCombatTimeline() const { return CombatTimeline; }
 	
 	// ==========================================
 	// Config Damage & Effects
@@ -70,25 +91,6 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "RPG Damage Ability | Effects")
 	void CaptureDamageEffectInfo(AActor* TargetActor, FDamageEffectInfo& OutInfo);
 
-	/**
-	 * Sets the damage percentage applied by this ability.
-	 * @param InDamagePercent The multiplier for damage.
-	 */
-	void SetDamagePercent(float InDamagePercent);
-
-	/**
-	 * Set the cooldown data relatives to the specific ability.
-	 * @param InCooldownTime Time to activate the skill again
-	 * @param InCooldownTagContainer Tags to grant when on CD
-	 */
-	void SetCooldownData(float InCooldownTime, const FGameplayTagContainer& InCooldownTagContainer);
-
-	/**
-	 * Set if this ability is a skill
-	 * @param InIsSkillAbility True if this ability has to be a skill attack
-	 */
-	void SetIsSkillAbility(bool InIsSkillAbility);
-	
 	/**
 	 * Triggered when the ability animation montage begins playing.
 	 */
@@ -114,8 +116,21 @@ protected:
 	 * @return The calculated base damage.
 	 */
 	virtual float GetBaseDamageValue(float WeaponDamage);
+
+	/**
+	 * False for events the server must ignore because its baked timeline sends them instead (the montage notifies,
+	 * should they still fire). Handlers of combat events check it first.
+	 */
+	bool AcceptsCombatEvent(const FGameplayEventData& Payload) const;
+
+	/** Holds full pose evaluation of the avatar on the server until the matching release or the end of the ability. */
+	void AcquireServerPose();
+	void ReleaseServerPose();
+
+	/** Takes damage percent, skill flag and cooldown from the grant configuration. */
+	virtual void ApplyGrantConfig(const FMKHAbilityGrantConfig& Config) override;
 	
-	/** Set by equipment ability definition when the ability is granted. */
+	/** Set from the grant configuration of the equipment ability definition. */
 	UPROPERTY(BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "RPG Damage Ability | Damage")
 	float DamagePercent = 1.f;
 	
@@ -160,6 +175,19 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "RPG Damage Ability | Animation")
 	TObjectPtr<UAnimMontage> AttackMontageToPlay;
 	
+	/** Combat events of AttackMontageToPlay, baked on save. Sent by the server in place of the montage notifies. */
+	UPROPERTY(VisibleDefaultsOnly, Category = "RPG Damage Ability | Animation")
+	FMKHCombatTimeline CombatTimeline;
+
+	/** True while this activation runs from CombatTimeline on the server. */
+	bool bUsingServerTimeline = false;
+
+	/** Pose holds taken on the avatar by this activation. */
+	int32 NumServerPoseHolds = 0;
+
+	/** Server activations of remote or dedicated-server avatars run from the timeline when it matches the montage. */
+	bool ShouldUseServerTimeline(const FGameplayAbilityActorInfo* ActorInfo) const;
+
 	/**
 	 * Executes the internal logic to play the specified AttackMontageToPlay.
 	 * @return True if successful.
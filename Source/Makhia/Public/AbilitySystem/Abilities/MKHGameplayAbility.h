@@ -7,6 +7,8 @@
 #include "GameplayTagContainer.h"
 #include "MKHGameplayAbility.generated.h"
 
+struct FMKHAbilityGrantConfig;
+
 /**
  * 
  */
@@ -31,6 +33,23 @@ public:
 	 * @param TriggerEventData Payload data from the event that triggered this ability.
 	 */
 	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
+
+	/**
+	 * Ends the ability, unbinding the server-side input listeners.
+	 */
+	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;
+
+	/**
+	 * Called by the ASC input router when the bound input is pressed while this ability is active.
+	 * Forwards to OnAbilityActivatedAgain.
+	 */
+	virtual void InputPressed(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) override;
+
+	/**
+	 * Called by the ASC input router when the bound input is released while this ability is active.
+	 * Forwards to OnAbilityReleased.
+	 */
+	virtual void InputReleased(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) override;
 	
 	/**
 	 * Called when the ability is granted, allowing cache configurations.
@@ -92,6 +111,20 @@ protected:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "RPG Gameplay Ability | Movement")
 	void SetCharacterOrientation(bool bFollowCamera);
+
+	// ==========================================
+	// Grant Configuration
+	// ==========================================
+
+	/** Returns the per-grant configuration of this ability's spec, or null when it was not granted as equipment. */
+	const FMKHAbilityGrantConfig* GetGrantConfig() const;
+
+	/**
+	 * Copies the per-grant configuration onto this instance. Runs on grant and again on activation, since the
+	 * owning client may receive the configuration after the spec. Never runs for non-instanced abilities, which
+	 * execute on the shared class default object and must read GetGrantConfig where they use it.
+	 */
+	virtual void ApplyGrantConfig(const FMKHAbilityGrantConfig& Config);
 	
 private:
 	
@@ -99,10 +132,34 @@ private:
 	// Internal Logic
 	// ==========================================
 
-	/** Binds the ability to listen for subsequent input press events. */
-	void BindInputPressEvent();
+	/** Calls ApplyGrantConfig with this spec's configuration when this is an ability instance. */
+	void ApplyGrantConfigToInstance();
+
+	/**
+	 * On the server of a remote client, listens once per activation for the input events the client replicates,
+	 * so repeat presses reach InputPressed/InputReleased there too.
+	 */
+	void BindRemoteInputEvents();
 	
-	/** Binds the ability to listen for input release events. */
-	void BindInputReleaseEvent();
+	/** Removes the listeners added by BindRemoteInputEvents. */
+	void UnbindRemoteInputEvents();
+
+	/** Replicated press from the owning client. */
+	void OnRemoteInputPressed();
+
+	/** Replicated release from the owning client. */
+	void OnRemoteInputReleased();
+
+	/** Returns the seconds since the last input event (or activation) and restarts the timer. */
+	float ConsumeInputTimeWaited();
+
+	/** World time of the activation or of the last press/release, whichever is latest. */
+	double LastInputTime = 0.0;
+
+	/** Listener for replicated presses of the current activation. */
+	FDelegateHandle RemoteInputPressedHandle;
+
+	/** Listener for replicated releases of the current activation. */
+	FDelegateHandle RemoteInputReleasedHandle;
 	
 };
@@ -96,6 +96,9 @@ private:
 	
 	/** The current sequential hit index of the active combo. */
 	int32 ComboHitCounter = 1;
+
+	/** True while an open hit scan window holds the avatar's server pose, the traces read weapon sockets every frame. */
+	bool bHitScanHoldsPose = false;
 	
 	// ==========================================
 	// Internal Logic & Events
@@ -40,7 +40,7 @@ public:
 	// Projectile Configuration
 	// ==========================================
 
-	/** Tag identifying the projectile data from the mapped information. */
+	/** Tag identifying the projectile data from the mapped information. Taken from the grant configuration's context tag. */
 	UPROPERTY(BlueprintReadOnly, Category = "Projectile Ability | Setup")
 	FGameplayTag ProjectileToSpawnTag;
 
@@ -62,6 +62,11 @@ public:
 	UFUNCTION(BlueprintNativeEvent, Category = "Projectile Ability | Events")
 	void OnProjectileDestroyed(AActor* DestroyedActor);
 	virtual void OnProjectileDestroyed_Implementation(AActor* DestroyedActor);
+
+protected:
+
+	/** Takes the projectile tag from the grant configuration and resolves its parameters. */
+	virtual void ApplyGrantConfig(const FMKHAbilityGrantConfig& Config) override;
 	
 private:
 	
@@ -81,20 +86,39 @@ private:
 	UPROPERTY(BlueprintReadOnly, Category = "Projectile Ability | Internal", meta = (AllowPrivateAccess = "true"))
 	TObjectPtr<AMKHProjectileBase> SpawnedProjectile = nullptr;
 
+	/** Projectiles spawned by this activation; the server and the predicting client count them the same way. */
+	uint8 NumShots = 0;
+
+	/** The predicting client cleans up its stand-ins if the server rejects this activation. */
+	bool bBoundPredictionRejected = false;
+
 	// ==========================================
 	// Spawning Logic
 	// ==========================================
 
 	/**
 	 * Executes the physical instantiation of the Projectile actor aligned towards TargetLocation.
+	 * The server spawns the replicated projectile, caught up by the shooter's latency; a predicting client spawns a
+	 * local stand-in at once, which the server's projectile takes over when it replicates. Simulated projectiles
+	 * (FProjectileParams::bSimulated) are fired by the server only.
 	 * @param TargetLocation Vector destination used to rotate the projectile orientation.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Projectile Ability | Logic")
 	void SpawnProjectile(const FVector& TargetLocation);
 	
+	/** Server: fires a projectile with bSimulated params through UProjectileSimulationSubsystem instead of spawning an actor. */
+	void SpawnSimulatedProjectile(const FVector& SpawnPoint, const FVector& Direction);
+	
 	/** Starts listening for event payloads commanding to execute logic. */
 	void BindSpawnProjectileEvent();
+
+	/** Forwards spawn events to OnSpawnProjectileEvent unless the server's baked timeline sends them instead. */
+	UFUNCTION()
+	void OnSpawnProjectileEventReceived(FGameplayEventData Payload);
 	
 	/** Resolves the absolute world coordinate for spawning the projectile. */
 	FVector GetSpawnLocation() const;
+
+	/** Server: half the remote shooter's round trip, capped by Makhia.Combat.ProjectileMaxCatchUpMs. Zero for local shooters. */
+	float GetCatchUpTime() const;
 };
@@ -13,6 +13,24 @@
 	GAMEPLAYATTRIBUTE_VALUE_SETTER(PropertyName) \
 	GAMEPLAYATTRIBUTE_VALUE_INITTER(PropertyName)
 
+/** Outcome of one damage event, resolved against the target's shield and health in a single step. */
+struct FMKHDamageResolution
+{
+	/** Damage that reached the attribute set (after the exec calc). */
+	float Damage = 0.f;
+
+	float OldShield = 0.f;
+	float NewShield = 0.f;
+	float OldHealth = 0.f;
+	float NewHealth = 0.f;
+
+	/** True when the hit was big enough to shatter the whole shield. */
+	bool bShieldBroken = false;
+};
+
+/** Fired once per damage event, after Shield and Health hold their final values. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnDamageResolved, const FMKHDamageResolution&);
+
 /**
  * Core attribute set containing character stats (Health, Stamina, Shield)
  * and combat related attributes.
@@ -36,6 +54,27 @@ public:
 	/** Handles execution of gameplay effects (used for damage processing) */
 	virtual void PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data) override;
 
+	/**
+	 * Splits damage between shield and health (shield break or partial absorption) without touching any attribute.
+	 * @param Damage         Incoming damage after the exec calc.
+	 * @param CurrentShield  Shield of the target before the hit.
+	 * @param CurrentHealth  Health of the target before the hit.
+	 */
+	static FMKHDamageResolution ResolveDamage(float Damage, float CurrentShield, float CurrentHealth);
+
+	/**
+	 * Resolves damage against the current Shield and Health and subtracts it from their base values once each, then
+	 * broadcasts OnDamageResolved.
+	 * Server only, like the damage effect that normally drives it.
+	 */
+	FMKHDamageResolution ApplyResolvedDamage(float Damage);
+
+	/** True while ApplyResolvedDamage writes Shield and Health; per-attribute listeners can wait for OnDamageResolved. */
+	bool IsResolvingDamage() const { return bResolvingDamage; }
+
+	/** One combined notification per damage event. */
+	FOnDamageResolved OnDamageResolved;
+
 	// -------------------------------------------------------------------
 	// Health Attributes
 	// -------------------------------------------------------------------
@@ -114,6 +153,9 @@ private:
 	 */
 	void HandleIncomingDamage(const FGameplayEffectModCallbackData& Data);
 
+	/** Writes the resolved hit to the combat telemetry ring. Only called while telemetry is enabled. */
+	void RecordDamageTelemetry(const FGameplayEffectModCallbackData& Data, const FMKHDamageResolution& Resolution) const;
+
 	/**
 	 * Calculates the fraction of incoming damage that is absorbed by the Shield (0.0 - ~1.0).
 	 *
@@ -139,14 +181,8 @@ private:
 		float OldMaxValue,
 		float NewMaxValue) const;
 
-	/** Helper to apply damage mitigating through the shield using CalculateShieldAbsorption()*/
-	void ApplyShieldDamageMitigation(UAbilitySystemComponent* ASC, float Damage, float CurrentShield) const;
-
-	/** Helper to handle full shield breaks.
-	 * 
-	 * All damage beyond the shield value flows through to Health unmitigated.
-	 */
-	void ApplyShieldBreak(UAbilitySystemComponent* ASC, float Damage, float CurrentShield) const;
+	/** Set while ApplyResolvedDamage writes Shield and Health. */
+	bool bResolvingDamage = false;
 
 	UFUNCTION()
 	void OnRep_Shield(const FGameplayAttributeData& OldShield);
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "AbilitySystemComponent.h"
+#include "AbilitySystem/MKHAbilityTypes.h"
 #include "MKHAbilitySystemComponent.generated.h"
 
 class UEquipmentManagerComponent;
@@ -104,21 +105,93 @@ public:
 	 */
 	void RemoveEquipmentAbility(FRPGEquipmentEntry* EquipmentEntry);
 
+	/**
+	 * Returns the per-grant configuration of an equipment ability spec, or null for other specs.
+	 * On the owning client it is available once the configuration list has replicated, at the latest by activation.
+	 */
+	const FMKHAbilityGrantConfig* FindAbilityGrantConfig(FGameplayAbilitySpecHandle Handle) const;
+
 	// =========================================================================================
 	// Utility
 	// =========================================================================================
 
 	/**
 	 * Gets the remaining cooldown time and total cooldown duration for the Gameplay
-	 * Effect that grants the given cooldown tag.
+	 * Effect that grants the given cooldown tag. Answered from the cooldown tracker, so it is
+	 * cheap enough to poll every frame; the tag must be granted exactly (no parent matching).
 	 * @param CooldownTag The gameplay tag representing the cooldown to query.
 	 * @param TimeRemaining Output parameter for the remaining cooldown time in seconds.
 	 * @param CooldownDuration Output parameter for the total cooldown duration in seconds.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "GAS|Abilities")
 	void GetCooldownRemainingForTag(FGameplayTag CooldownTag, float& TimeRemaining, float& CooldownDuration) const;
+
+
+	// =========================================================================================
+	// Lag Compensation
+	// =========================================================================================
+
+	/**
+	 * Owning client only: tells the server which server time the other pawns on this screen show right now.
+	 * Called when an attack starts so melee hit scans can be tested against what the player saw.
+	 */
+	void ReportClientViewTime();
+
+	/** Server: seconds the owning player's view trails the server, from the last report, clamped to the rewind window. */
+	float GetClientViewDelay() const { return ClientViewDelay; }
+
+protected:
+	// =========================================================================================
+	// Ability Spec Lifecycle
+	// =========================================================================================
+
+	/** Indexes the spec under its input tags. Runs on the server on grant and on clients when the spec replicates in. */
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+
+	/** Drops the spec from the input index before it is cleared. */
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+
+	/** Starts the cooldown tracker before any effect can be applied or replicated in. */
+	virtual void OnRegister() override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Receives the owning client's view time and turns it into ClientViewDelay. */
+	UFUNCTION(Server, Unreliable)
+	void ServerReportClientViewTime(double ClientViewTime);
 	
 private:
+	/** A spec bound to an input tag, with the last known position in the activatable abilities list. */
+	struct FInputBoundSpec
+	{
+		FGameplayAbilitySpecHandle Handle;
+		int32 SpecIndex = INDEX_NONE;
+	};
+
+	/** Input tag -> specs carrying it in their dynamic source tags. Quick-slot specs are indexed under Input::QuickSlot. */
+	TMap<FGameplayTag, TArray<FInputBoundSpec>> InputTagToSpecs;
+
+	/** World time span of the longest running duration effect granting a tag. */
+	struct FCooldownWindow
+	{
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+		FActiveGameplayEffectHandle EffectHandle;
+	};
+
+	/** Cooldown tag -> cooldown window, maintained from effect add, remove, time and stack events. */
+	TMap<FGameplayTag, FCooldownWindow> CooldownWindows;
+
+	/** Cooldown tags of every ability class granted so far; per-grant cooldown tags are read from AbilityGrantConfigs. */
+	FGameplayTagContainer AbilityCooldownTags;
+
+	/** Configuration of every equipment ability spec granted through GrantEquipmentAbility, sent to the owner only. */
+	UPROPERTY(Replicated)
+	TArray<FMKHAbilityGrantConfig> AbilityGrantConfigs;
+
+	/** Last accepted view delay of the owning client. Server only. */
+	float ClientViewDelay = 0.f;
+
 	// =========================================================================================
 	// Internal Input Logic
 	// =========================================================================================
@@ -126,17 +199,48 @@ private:
 	/** Returns true when the input belongs to the quick-slot input hierarchy. */
 	bool IsQuickSlotInput(const FGameplayTag& InputTag) const;
 
-	/** Returns true when an ability spec should react to the provided input tag. */
-	bool DoesSpecMatchInput(const FGameplayAbilitySpec& Spec, const FGameplayTag& InputTag, bool bIsQuickSlotInput) const;
+	/** Returns the specs bound to an input, or null when nothing is. Quick-slot inputs resolve to the shared quick-slot tag. */
+	TArray<FInputBoundSpec>* FindInputBoundSpecs(const FGameplayTag& InputTag, bool bIsQuickSlotInput);
+
+	/** Resolves a bound spec through its cached list index, refreshing the index when the list has shifted. */
+	FGameplayAbilitySpec* ResolveInputBoundSpec(FInputBoundSpec& BoundSpec);
 
 	/** Sends the quick-slot gameplay event to the avatar actor. */
 	void SendQuickSlotEvent(const FGameplayTag& InputTag) const;
 
-	/** Activates a spec or forwards replicated pressed input to active instances. */
-	void HandleAbilityInputPressedForSpec(const FGameplayAbilitySpec& Spec);
+	/** Activates a spec, or routes the press straight to its active instances and the server. */
+	void HandleAbilityInputPressedForSpec(FGameplayAbilitySpec& Spec);
+
+	/** Routes the release straight to the active instances of a spec and the server. */
+	void HandleAbilityInputReleasedForSpec(FGameplayAbilitySpec& Spec);
+
+	/**
+	 * Fires a generic input event locally and makes sure the server sees it once: if an ability task is listening it
+	 * replicates the event itself, otherwise it is sent from here.
+	 */
+	void ReplicateAbilityInputEvent(EAbilityGenericReplicatedEvent::Type EventType, const FGameplayAbilitySpec& Spec);
+
+
+	// =========================================================================================
+	// Internal Cooldown Tracking
+	// =========================================================================================
+
+	/** Records the window of a newly added duration effect under every cooldown tag it grants, static or dynamic. */
+	void OnCooldownEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveHandle);
+
+	/** Re-reads the window of a tracked effect whose duration was changed or refreshed. */
+	void OnCooldownEffectTimeChanged(FActiveGameplayEffectHandle ActiveHandle, float NewStartTime, float NewDuration);
+	void OnCooldownEffectStackChanged(FActiveGameplayEffectHandle ActiveHandle, int32 NewStackCount, int32 PreviousStackCount);
+	void RefreshCooldownWindows(FActiveGameplayEffectHandle ActiveHandle);
+
+	/** Drops the windows owned by a removed effect, falling back to another effect still granting the tag. */
+	void OnCooldownEffectRemoved(const FActiveGameplayEffect& RemovedEffect);
+
+	/** Writes the window of an active effect for one tag, keeping the one that ends last. */
+	void TrackCooldownWindow(const FGameplayTag& Tag, const FActiveGameplayEffect& ActiveEffect);
 
-	/** Forwards replicated released input to active ability instances. */
-	void HandleAbilityInputReleasedForSpec(const FGameplayAbilitySpec& Spec);
+	/** True for tags some granted ability uses as its cooldown, through its class or its grant configuration. */
+	bool IsAbilityCooldownTag(const FGameplayTag& Tag) const;
 
 
 	// =========================================================================================
@@ -15,7 +15,7 @@ class MAKHIA_API UMKHAbilitySystemGlobals : public UAbilitySystemGlobals
 {
 	GENERATED_BODY()
 
-	/** Allocates the custom FMKHGameplayEffectContext used by this project. */
+	/** Allocates the custom FMKHGameplayEffectContext used by this project, from its recycling pool. */
 	virtual FGameplayEffectContext* AllocGameplayEffectContext() const override;
 
 };
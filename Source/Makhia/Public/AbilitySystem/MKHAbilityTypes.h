@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayAbilitySpec.h"
 #include "GameplayEffectTypes.h"
 #include "MKHAbilityTypes.generated.h"
 
@@ -11,6 +12,24 @@ class AActor;
 class UStaticMesh;
 class UGameplayEffect;
 class UAbilitySystemComponent;
+class UGameplayAbility;
+class UAnimMontage;
+
+/** Allocation counters of the FMKHGameplayEffectContext pool, see FMKHGameplayEffectContext::operator new. */
+struct FMKHEffectContextPoolStats
+{
+	/** Contexts handed out since startup. */
+	uint64 NumAllocations = 0;
+
+	/** Allocations that reached the heap: new pool chunks, plus contexts of derived types that bypass the pool. */
+	uint64 NumHeapAllocations = 0;
+
+	/** Pooled contexts currently referenced by a handle. */
+	int32 NumLive = 0;
+
+	/** Recycled blocks waiting to be reused. */
+	int32 NumFree = 0;
+};
 
 /**
  * Custom gameplay effect context used by Arena to transport extended effect metadata.
@@ -48,9 +67,35 @@ struct FMKHGameplayEffectContext : public FGameplayEffectContext
 		return NewContext;
 	}
 
-	/** Serializes custom context data for replication and prediction rollback. */
+	/**
+	 * Serializes custom context data for replication and prediction rollback.
+	 * The hit result goes through NetSerializeCompactHit and the crit flag lives in the RepBits.
+	 */
 	virtual bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess) override;
 
+	/**
+	 * Compact hit encoding for effect contexts: impact point (0.1 cm), impact normal, hit actor and bone index.
+	 * Trace start/end, physical material, face/item indices and penetration data are not sent; on load
+	 * Location/Normal mirror the impact values and the bone is resolved on the actor's skeletal mesh.
+	 */
+	static MAKHIA_API
+	bool NetSerializeCompactHit(FArchive& Ar, UPackageMap* Map, FHitResult& Hit);
+
+	/**
+	 * Contexts live in a recycling pool: every new (AllocGameplayEffectContext, Duplicate) pops a block from a free
+	 * list and the delete run when the last FGameplayEffectContextHandle lets go pushes it back, so steady-state
+	 * combat never reaches the heap for contexts. Blocks the engine mallocs itself (handle replication) are freed normally.
+	 */
+	static MAKHIA_API
+	void* operator new(size_t Size);
+
+	static MAKHIA_API
+	void operator delete(void* Ptr);
+
+	/** Returns a snapshot of the pool counters. */
+	static MAKHIA_API
+	FMKHEffectContextPoolStats GetPoolStats();
+
 private:
 
 	/** Replicated flag indicating whether the effect was generated by a critical hit. */
@@ -76,10 +121,25 @@ struct FProjectileParams
 {
 	GENERATED_BODY()
 
-	/** Projectile actor class to spawn when the ability triggers. */
-	UPROPERTY(EditDefaultsOnly)
+	/** Projectile actor class to spawn when the ability triggers. Unused when bSimulated. */
+	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "!bSimulated"))
 	TSubclassOf<AMKHProjectileBase> ProjectileClass;
 
+	/**
+	 * Simulates the projectile in UProjectileSimulationSubsystem instead of spawning ProjectileClass: no actor, instanced
+	 * rendering, only the spawn and the impact replicated. Meant for skills firing many projectiles.
+	 */
+	UPROPERTY(EditDefaultsOnly)
+	bool bSimulated = false;
+
+	/** Collision sphere radius of simulated projectiles. */
+	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "bSimulated"))
+	float CollisionRadius = 32.f;
+
+	/** Seconds a simulated projectile flies before it expires without impact. */
+	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "bSimulated"))
+	float MaxLifetime = 5.f;
+
 	/** Optional static mesh override used by projectile visuals. */
 	UPROPERTY(EditDefaultsOnly)
 	TObjectPtr<UStaticMesh> ProjectileMesh;
@@ -101,6 +161,125 @@ struct FProjectileParams
 	float Bounciness = 0.6f;
 };
 
+/**
+ * Identifies one projectile of an ability activation on every machine: the activation's prediction key and the
+ * shot's index within it. The owning client matches its predicted projectile with the server's one through it.
+ */
+USTRUCT()
+struct FMKHProjectileShotId
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int16 PredictionKey = 0;
+
+	UPROPERTY()
+	uint8 ShotIndex = 0;
+
+	/** Only activations predicted by a client have a key. */
+	bool IsValid() const { return PredictionKey != 0; }
+
+	bool operator==(const FMKHProjectileShotId& Other) const
+	{
+		return PredictionKey == Other.PredictionKey && ShotIndex == Other.ShotIndex;
+	}
+
+	friend uint32 GetTypeHash(const FMKHProjectileShotId& ShotId)
+	{
+		return HashCombine(::GetTypeHash(ShotId.PredictionKey), ::GetTypeHash(ShotId.ShotIndex));
+	}
+};
+
+/**
+ * Per-grant configuration of an equipment ability. UMKHAbilitySystemComponent keeps one per granted spec, keyed by
+ * its handle and replicated to the owner. Abilities read their values from it, so granting never writes the ability's
+ * class default object.
+ */
+USTRUCT(BlueprintType)
+struct FMKHAbilityGrantConfig
+{
+	GENERATED_BODY()
+
+	/** Spec this configuration belongs to. */
+	UPROPERTY()
+	FGameplayAbilitySpecHandle Handle;
+
+	/** Input the spec is bound to: the rolled skill slot for skills, the ability's default input otherwise. */
+	UPROPERTY(BlueprintReadOnly)
+	FGameplayTag InputTag;
+
+	/** Attack context from the equipment definition; projectile abilities look their projectile up with it. */
+	UPROPERTY(BlueprintReadOnly)
+	FGameplayTag ContextTag;
+
+	/** Weapon damage multiplier for damage abilities. */
+	UPROPERTY(BlueprintReadOnly)
+	float DamagePercent = 1.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsSkillAbility = false;
+
+	/** Skill cooldown duration and the tags it grants; empty for basic attacks. */
+	UPROPERTY(BlueprintReadOnly)
+	float CooldownTime = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	FGameplayTagContainer CooldownTags;
+};
+
+/** A gameplay event of an attack montage, at the montage position its notify fires. */
+USTRUCT(BlueprintType)
+struct FMKHCombatTimelineEvent
+{
+	GENERATED_BODY()
+
+	/** Event sent to the avatar, one of the MKHGameplayTags::Event combat tags. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FGameplayTag EventTag;
+
+	/** Montage position in seconds. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float Time = 0.f;
+
+	bool operator==(const FMKHCombatTimelineEvent& Other) const
+	{
+		return EventTag == Other.EventTag && FMath::IsNearlyEqual(Time, Other.Time);
+	}
+};
+
+/**
+ * Combat events of an attack montage baked in the editor, so servers can send them without evaluating the animation.
+ * See UMKHDamageAbility::BakeCombatTimeline.
+ */
+USTRUCT(BlueprintType)
+struct FMKHCombatTimeline
+{
+	GENERATED_BODY()
+
+	/** Montage the events were read from; a timeline baked for another montage is ignored. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TSoftObjectPtr<UAnimMontage> SourceMontage;
+
+	/** Events sorted by time. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TArray<FMKHCombatTimelineEvent> Events;
+
+	/** HashNotifies of the source montage at bake time; notify edits saved without re-baking the ability change it. */
+	UPROPERTY(VisibleAnywhere)
+	uint32 NotifyHash = 0;
+
+	/** True when this timeline holds events baked from Montage's current notifies. */
+	bool IsBakedFor(const UAnimMontage* Montage) const;
+
+	/** Hashes the notifies of Montage that combat events are baked from. */
+	static uint32 HashNotifies(const UAnimMontage* Montage);
+
+	bool operator==(const FMKHCombatTimeline& Other) const
+	{
+		return SourceMontage == Other.SourceMontage && Events == Other.Events && NotifyHash == Other.NotifyHash;
+	}
+};
+
 /** Runtime payload used to build and apply damage gameplay effects. */
 USTRUCT(BlueprintType)
 struct FDamageEffectInfo
@@ -127,6 +306,10 @@ struct FDamageEffectInfo
 	UPROPERTY(BlueprintReadWrite)
 	TObjectPtr<UAbilitySystemComponent> TargetASC = nullptr;
 
+	/** Ability the damage comes from, stored in the effect context (cues, telemetry). Optional. */
+	UPROPERTY(BlueprintReadWrite)
+	TObjectPtr<UGameplayAbility> SourceAbility = nullptr;
+
 	//UPROPERTY(BlueprintReadWrite)
 	//TSubclassOf<UDamageType> DamageTypeClass;
 };
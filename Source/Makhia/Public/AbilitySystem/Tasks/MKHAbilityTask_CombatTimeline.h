@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Abilities/Tasks/AbilityTask.h"
+#include "AbilitySystem/MKHAbilityTypes.h"
+#include "MKHAbilityTask_CombatTimeline.generated.h"
+
+class UAnimMontage;
+
+/**
+ * Sends the events of a baked combat timeline to the ability system component as the montage reaches their positions,
+ * in place of the montage's notifies. Follows the montage position while it plays, so section jumps (combos) and
+ * play rate are honoured, and elapsed time otherwise. Events carry the owning ability as OptionalObject.
+ */
+UCLASS()
+class MAKHIA_API UMKHAbilityTask_CombatTimeline : public UAbilityTask
+{
+	GENERATED_BODY()
+
+public:
+
+	UMKHAbilityTask_CombatTimeline(const FObjectInitializer& ObjectInitializer);
+
+	/**
+	 * Starts sending the events of Timeline, timed against Montage.
+	 * @param OwningAbility Ability that owns the task; ending it stops the timeline.
+	 * @param Montage The montage the ability plays, the one Timeline was baked from.
+	 * @param Timeline The baked events.
+	 */
+	static UMKHAbilityTask_CombatTimeline* PlayCombatTimeline(UGameplayAbility* OwningAbility, UAnimMontage* Montage, const FMKHCombatTimeline& Timeline);
+
+	virtual void Activate() override;
+	virtual void TickTask(float DeltaTime) override;
+
+private:
+
+	/** Sends every event in (LastPosition, Position]. Returns false if the task finished while handling them. */
+	bool SendEvents(float Position);
+
+	UPROPERTY()
+	TObjectPtr<UAnimMontage> Montage;
+
+	TArray<FMKHCombatTimelineEvent> Events;
+
+	/** Montage position reached on the previous tick. */
+	float LastPosition = -UE_KINDA_SMALL_NUMBER;
+
+	/** Time since activation, used while the montage is not playing on this machine. */
+	float ElapsedTime = 0.f;
+
+	bool bMontageWasPlaying = false;
+};
@@ -6,10 +6,13 @@
 #include "GameplayTagContainer.h"
 #include "GameFramework/Character.h"
 #include "AbilitySystemInterface.h"
+#include "Equipment/EquipmentTypes.h"
 #include "CharacterBase.generated.h"
 
 class UMKHAbilitySystemComponent;
 class UMKHAttributeSet;
+class UEquipmentDefinition;
+class UEquipmentInstance;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnHealthChangedSignature, float, OldHealth, float, CurrentHealth, float, MaxHealth);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnStaminaChangedSignature, float, OldStamina, float, CurrentStamina, float, MaxStamina);
@@ -29,6 +32,27 @@ public:
 
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Server only: mirrors the definition equipped in a slot so remote clients can build its visuals locally. */
+	void SetEquippedVisual(const FGameplayTag& SlotTag, TSubclassOf<UEquipmentDefinition> EquipmentDefinition, bool bSpawnActorsLocally);
+
+	/** Server only: clears the mirrored visual of a slot. */
+	void ClearEquippedVisual(const FGameplayTag& SlotTag);
+
+	/**
+	 * Dedicated servers only tick the montages of the mesh (Makhia.Combat.ServerMontageOnlyAnimation): combat events come
+	 * from baked timelines and root motion keeps working, but bones are not refreshed. Whatever reads bone or socket
+	 * transforms over several frames holds full pose evaluation meanwhile. Every acquire needs a matching release.
+	 */
+	void AcquireServerPose();
+	void ReleaseServerPose();
+
+	/** Evaluates the pose once when nothing holds it, for one-off socket reads (e.g. a projectile spawn point). */
+	void RefreshServerPose();
+
 	UPROPERTY(BlueprintAssignable, Category = "Delegates")
 	FOnHealthChangedSignature OnHealthChanged;
 
@@ -61,5 +85,29 @@ protected:
 
 	UPROPERTY(BlueprintReadOnly, meta = (AllowPrivateAccess = true))
 	TObjectPtr<UMKHAttributeSet> MKHAttributeSet;
+
+	UFUNCTION()
+	void OnRep_EquippedVisuals(const TArray<FEquippedVisual>& OldVisuals);
+
+private:
+	/** Builds the visual's leader-pose followers and, when requested, non-replicated copies of its actors on this machine. */
+	void SpawnLocalEquipmentVisual(const FEquippedVisual& Visual);
+
+	/** Destroys the local copies spawned for a slot, if any. */
+	void DestroyLocalEquipmentVisual(const FGameplayTag& SlotTag);
+
+	/** What this character wears, sent to every client except the owner (which reads its own equipment list). */
+	UPROPERTY(ReplicatedUsing = OnRep_EquippedVisuals)
+	TArray<FEquippedVisual> EquippedVisuals;
+
+	/** Dedicated servers: picks the mesh tick option from the pose holds. Other net modes keep the mesh's own option. */
+	void UpdateMeshAnimTickOption();
+
+	/** Outstanding AcquireServerPose calls. */
+	int32 NumServerPoseHolds = 0;
+
+	/** Cosmetic equipment instances spawned on this machine from EquippedVisuals, keyed by slot. */
+	UPROPERTY(Transient)
+	TMap<FGameplayTag, TObjectPtr<UEquipmentInstance>> LocalEquipmentVisuals;
 	
 };
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "AbilityLatencySubsystem.generated.h"
+
+class UGameplayAbility;
+struct FGameplayAbilityActivationInfo;
+
+/** Points of an ability's life that are timestamped. Every sample is the time since the first stage of its timeline. */
+UENUM()
+enum class EAbilityLatencyStage : uint8
+{
+	/** Key press in AMKHPlayerController::AbilityInputPressed (owning client). Starts the client timeline. */
+	InputPressed,
+	/** ActivateAbility ran. Starts the server timeline; on the client it is measured from the key press. */
+	Activated,
+	/** The server caught up with the activation's prediction key (owning client). */
+	ServerConfirmed,
+	/** The HitScanStart gameplay event reached the melee ability (server). */
+	HitScanStart,
+	/** First damage effect applied for the activation (server). */
+	DamageApplied,
+	Count UMETA(Hidden)
+};
+
+/** Log2 latency histogram in milliseconds: bucket 0 holds < 1 ms, bucket N holds [2^(N-1), 2^N) ms. */
+struct FAbilityLatencyHistogram
+{
+	static constexpr int32 NumBuckets = 14;
+
+	int64 Buckets[NumBuckets] = {};
+	int64 Count = 0;
+	double SumMs = 0.0;
+	double MinMs = 0.0;
+	double MaxMs = 0.0;
+
+	void Add(double Ms);
+
+	/** Upper bound of the bucket holding the given percentile (0-1). */
+	double GetPercentileMs(double Percentile) const;
+
+	static double GetBucketUpperMs(int32 Bucket) { return static_cast<double>(1ll << Bucket); }
+};
+
+/**
+ * Input-to-hit latency of abilities, per machine (in PIE the client and server worlds keep separate data).
+ * Each active ability instance has a timeline tied to its activation prediction key; stages recorded under another
+ * key are ignored. The owning client measures key press -> activation -> server confirmation, the server
+ * measures activation -> HitScanStart -> damage. Samples go into per-ability histograms.
+ * Makhia.Ability.Latency logs them for every game world, Makhia.Ability.LatencyDump writes them to
+ * Saved/Telemetry as CSV. Makhia.Ability.LatencyTracking turns recording off.
+ */
+UCLASS()
+class MAKHIA_API UAbilityLatencySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Remembers a key press; the next activation on this machine within a short window is measured from it. */
+	static void MarkInputPressed(const UObject* WorldContextObject);
+
+	/** Starts the timeline of an activation and, on a predicting client, waits for the server to confirm its key. */
+	static void MarkActivated(const UGameplayAbility* Ability, const FGameplayAbilityActivationInfo& ActivationInfo);
+
+	/** Records Stage for the ability's current activation, once per activation. */
+	static void MarkStage(const UGameplayAbility* Ability, EAbilityLatencyStage Stage);
+
+	/** Drops the ability's timeline when it ends. */
+	static void EndTimeline(const UGameplayAbility* Ability);
+
+	/** Clears every histogram of this world. */
+	void Reset();
+
+	/** Logs one line per ability and stage. */
+	void LogHistograms() const;
+
+	/** Writes the histograms to Saved/Telemetry/AbilityLatency-<NetMode>-<date>.csv. Returns the file written, or empty. */
+	FString DumpCsv() const;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** One activation: when each stage was reached (0 = not yet), in FPlatformTime seconds. */
+	struct FTimeline
+	{
+		FName AbilityName;
+		int16 PredictionKey = 0;
+		double StartTime = 0.0;
+		double StageTimes[static_cast<int32>(EAbilityLatencyStage::Count)] = {};
+	};
+
+	struct FAbilityHistograms
+	{
+		FAbilityLatencyHistogram Stages[static_cast<int32>(EAbilityLatencyStage::Count)];
+	};
+
+	static UAbilityLatencySubsystem* Get(const UObject* WorldContextObject);
+
+	void AddSample(FName AbilityName, EAbilityLatencyStage Stage, double Ms);
+
+	/** Time of the last key press not consumed by an activation yet, 0 when none. */
+	double PendingInputTime = 0.0;
+
+	/** Active ability instance -> its current activation. */
+	TMap<FObjectKey, FTimeline> Timelines;
+
+	/** Ability class name -> histograms. */
+	TMap<FName, FAbilityHistograms> Histograms;
+};
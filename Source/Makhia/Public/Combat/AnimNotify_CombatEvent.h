@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "GameplayTagContainer.h"
+#include "AnimNotify_CombatEvent.generated.h"
+
+/**
+ * Sends a combat gameplay event (hit scan window, combo window, projectile spawn) to the owner of the mesh.
+ * UMKHDamageAbility::BakeCombatTimeline reads EventTag directly; other notifies are matched by name.
+ */
+UCLASS(meta = (DisplayName = "Combat Event"))
+class MAKHIA_API UAnimNotify_CombatEvent : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual FString GetNotifyName_Implementation() const override;
+
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
+
+	/** Event sent to the owning actor. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat", meta = (Categories = "Event"))
+	FGameplayTag EventTag;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Combat/MKHCombatNetRelay.h"
+#include "CombatHitNotifySubsystem.generated.h"
+
+struct FMKHDamageResolution;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnCombatHitSignature, AActor*, Target, float, Damage, bool, bCriticalHit, bool, bShieldBroken);
+
+/**
+ * Hit notifications for damage numbers, hit flashes and similar cosmetics.
+ * The server collects every resolved damage event of a frame and sends them as a single unreliable multicast
+ * (one FMKHHitBatch on an always-relevant AMKHCombatNetRelay) instead of one notification per hit.
+ * Each machine then fans the batch out locally through OnCombatHit.
+ * Tunable: Makhia.Combat.MaxHitsPerBatch.
+ */
+UCLASS()
+class MAKHIA_API UCombatHitNotifySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Queues a resolved damage event on Target for this frame's batch. Server only. */
+	void QueueHit(AActor* Target, const FMKHDamageResolution& Resolution, bool bCriticalHit);
+
+	/** Fans a received batch out through OnCombatHit. Called by the relay on every machine that gets the multicast. */
+	void DispatchHitBatch(const FMKHHitBatch& Batch);
+
+	/** The relay spawned at begin play, for other combat systems to multicast through. Null on clients. */
+	AMKHCombatNetRelay* GetNetRelay() const { return NetRelay; }
+
+	/** Fired locally once per hit in each received batch. Targets that are not relevant on this client are skipped. */
+	UPROPERTY(BlueprintAssignable, Category = "Combat")
+	FOnCombatHitSignature OnCombatHit;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Builds and sends the batch for the hits queued so far; anything over the batch limit waits for the next frame. */
+	void FlushPendingHits();
+
+	struct FPendingHit
+	{
+		TWeakObjectPtr<AActor> Target;
+		float Damage = 0.f;
+		bool bCriticalHit = false;
+		bool bShieldBroken = false;
+	};
+
+	/** Hits queued since the last flush. Game thread only. */
+	TArray<FPendingHit> PendingHits;
+
+	/** Spawned on the server at begin play; clients receive it through replication. */
+	UPROPERTY(Transient)
+	TObjectPtr<AMKHCombatNetRelay> NetRelay;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+/** One resolved hit, as written by UMKHAttributeSet after shield and health have been updated. */
+struct FCombatTelemetryRecord
+{
+	/** World time of the hit. */
+	double Timestamp = 0.0;
+
+	/** Instigator, target and ability class names. Names are copied as indices, the writer thread resolves them. */
+	FName Source;
+	FName Target;
+	FName Ability;
+
+	/** Damage before the exec calc (SetByCaller) and after it (crit applied). */
+	float BaseDamage = 0.f;
+	float FinalDamage = 0.f;
+
+	/** How the final damage was split between the target's shield and health. */
+	float ShieldAbsorbed = 0.f;
+	float HealthLost = 0.f;
+
+	bool bCriticalHit = false;
+};
+
+/**
+ * Per-hit combat log for balance and anti-cheat analysis, cheap enough to leave on in production.
+ * The game thread copies records into a fixed-size single-producer/single-consumer ring (no locks, no allocation);
+ * a background thread drains it to Saved/Telemetry/CombatTelemetry-<date>.csv. When the writer falls behind,
+ * records are dropped and counted rather than blocking the frame.
+ * Toggle with Makhia.Combat.Telemetry 1/0.
+ */
+class MAKHIA_API FCombatTelemetry final : public FRunnable
+{
+public:
+
+	static FCombatTelemetry& Get();
+
+	/** Call sites check this before building a record. */
+	static bool IsEnabled() { return bEnabled.load(std::memory_order_relaxed); }
+
+	/** Copies a record into the ring. Game thread only; drops the record if the ring is full. */
+	void Record(const FCombatTelemetryRecord& Record);
+
+	/** Opens a new file and starts the writer thread. */
+	void Start();
+
+	/** Flushes what is left, stops the writer thread and closes the file. */
+	void Stop();
+
+	/** Records lost to a full ring since the last Start. */
+	uint64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+
+	// FRunnable
+	virtual uint32 Run() override;
+
+private:
+
+	/** Power of two, about 0.8 MB of records: a few seconds of heavy combat between flushes. */
+	static constexpr uint64 Capacity = 1 << 14;
+
+	/** Writer wake-up interval. */
+	static constexpr uint32 FlushIntervalMs = 250;
+
+	/** Writes every record published so far and hands the slots back to the producer. Writer thread only. */
+	void Drain();
+
+	static std::atomic<bool> bEnabled;
+
+	/** Ring storage, allocated on the first Start and kept afterwards. */
+	TUniquePtr<FCombatTelemetryRecord[]> Records;
+
+	/** Next slot the producer writes; published with release ordering. */
+	std::atomic<uint64> WriteIndex = 0;
+
+	/** Next slot the writer reads; released back to the producer after each drain. */
+	std::atomic<uint64> ReadIndex = 0;
+
+	std::atomic<uint64> NumDropped = 0;
+	std::atomic<bool> bStopping = false;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	TUniquePtr<IFileHandle> File;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class UCapsuleComponent;
+
+/**
+ * Server-side lag compensation for melee hit scans.
+ * Every registered pawn's collision capsule is recorded once per frame into a short history ring. The layout is
+ * frame-major SoA: one contiguous block of locations and half heights per frame. Recording 128 pawns writes two
+ * flat arrays with no per-pawn allocation.
+ * Hit scans sweep against the capsules as they stood at the attacker's view time. Pawns are never moved, so
+ * rewinding triggers no overlaps or physics. The rewind is capped by Makhia.LagComp.MaxRewindMs.
+ */
+UCLASS()
+class MAKHIA_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Starts recording Pawn's root capsule. Pawns without a capsule root are ignored. Server only. */
+	void RegisterPawn(APawn* Pawn);
+
+	/** Stops recording Pawn and frees its slot. */
+	void UnregisterPawn(APawn* Pawn);
+
+	/** True if Actor is a pawn whose capsule is recorded, i.e. SweepRewound covers it. */
+	bool IsRecorded(const AActor* Actor) const;
+
+	/**
+	 * Sweeps a sphere of Radius from Start to End against every recorded capsule as it stood ViewDelay seconds ago.
+	 * ViewDelay is clamped to the rewind window. IgnoreActor (usually the attacker) is skipped.
+	 * Hits are sorted by distance along the sweep; none of them is blocking.
+	 * @return True if anything was hit.
+	 */
+	bool SweepRewound(const FVector& Start, const FVector& End, float Radius, float ViewDelay, const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const;
+
+	/** Returns the longest rewind the server accepts, in seconds. */
+	static float GetMaxRewindSeconds();
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Frames kept per pawn; covers the rewind window down to a 4 ms server frame. */
+	static constexpr int32 NumFrames = 64;
+
+	/** Writes the current capsule of every slot into the next frame of the ring. */
+	void RecordFrame(double Time);
+
+	/** Grows every per-slot and per-frame array to hold NewCapacity slots, keeping the recorded history. */
+	void SetSlotCapacity(int32 NewCapacity);
+
+	/** The two recorded frames around a rewind time and the blend between them; shared by every slot sampled at it. */
+	struct FRewindFrames
+	{
+		/** Last frame recorded at or before the time; INDEX_NONE when the time is older than the history. */
+		int32 Older = INDEX_NONE;
+
+		/** First frame recorded after the time; INDEX_NONE when Older is the newest frame. */
+		int32 Newer = INDEX_NONE;
+
+		float Alpha = 1.f;
+	};
+
+	/** Finds the frames around Time. */
+	FRewindFrames FindRewindFrames(double Time) const;
+
+	/** Interpolates Slot's capsule between Frames. Returns false if the slot has no history in either frame. */
+	bool SampleSlot(int32 Slot, const FRewindFrames& Frames, FVector& OutLocation, float& OutHalfHeight) const;
+
+	FORCEINLINE int32 HistoryIndex(int32 Frame, int32 Slot) const { return Frame * SlotCapacity + Slot; }
+
+	/** Per slot: the recorded capsule (null for free slots) and its radius. */
+	TArray<TWeakObjectPtr<UCapsuleComponent>> Capsules;
+	TArray<float> Radii;
+
+	TArray<int32> FreeSlots;
+	TMap<TObjectKey<APawn>, int32> SlotsByPawn;
+	int32 SlotCapacity = 0;
+
+	/** History, NumFrames blocks of SlotCapacity entries. Valid marks slots that were live when the frame was recorded. */
+	TArray<FVector> Locations;
+	TArray<float> HalfHeights;
+	TBitArray<> Valid;
+
+	/** Server time of each frame in the ring, and the ring head. */
+	double FrameTimes[NumFrames] = {};
+	int32 NewestFrame = INDEX_NONE;
+	int32 NumRecordedFrames = 0;
+};
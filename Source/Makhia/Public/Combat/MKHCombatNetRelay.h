@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AbilitySystem/MKHAbilityTypes.h"
+#include "Engine/NetSerialization.h"
+#include "MKHCombatNetRelay.generated.h"
+
+class UProjectileInfo;
+
+/** One frame of hits, serialized as a target table plus packed per-hit entries. */
+USTRUCT()
+struct FMKHHitBatch
+{
+	GENERATED_BODY()
+
+	/** A single hit: index into Targets, damage rounded to whole points, crit and shield-break flags. */
+	struct FHit
+	{
+		uint16 TargetIndex = 0;
+		uint16 Damage = 0;
+		bool bCriticalHit = false;
+		bool bShieldBroken = false;
+	};
+
+	/** Upper bounds accepted on receive; the server never builds bigger batches. */
+	static constexpr int32 MaxTargets = 256;
+	static constexpr int32 MaxHits = 1024;
+
+	/** Every actor hit this frame, sent once however many hits it took. */
+	TArray<TObjectPtr<AActor>> Targets;
+
+	TArray<FHit> Hits;
+
+	/** Targets as object references, hits as a packed index, a packed damage value and two flag bits. */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMKHHitBatch> : public TStructOpsTypeTraitsBase2<FMKHHitBatch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Projectiles fired together by the server in one frame, see UProjectileSimulationSubsystem. Everything a client needs
+ * to simulate them exactly like the server: origin and directions are quantized before the server simulates them too,
+ * and the projectile parameters are looked up by tag in the relay's UProjectileInfo on every machine.
+ */
+USTRUCT()
+struct FMKHProjectileVolley
+{
+	GENERATED_BODY()
+
+	/** Id of the first projectile; the others follow in Directions order. */
+	UPROPERTY()
+	uint32 FirstId = 0;
+
+	/** Server world time the volley was fired at; clients catch up from it. */
+	UPROPERTY()
+	double SpawnTime = 0.0;
+
+	/** Ignored by the projectiles' sweeps. */
+	UPROPERTY()
+	TObjectPtr<AActor> Owner;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	TArray<FVector_NetQuantize100> Directions;
+
+	/** Key of the volley's FProjectileParams in AMKHCombatNetRelay::GetProjectileInfo. */
+	UPROPERTY()
+	FGameplayTag ProjectileTag;
+};
+
+/** A simulated projectile that ended on the server by hitting something. */
+USTRUCT()
+struct FMKHProjectileImpact
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint32 Id = 0;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Location;
+};
+
+/**
+ * Always-relevant actor the server spawns once per world to carry hit batches to every client
+ * in one unreliable multicast per frame, and simulated projectile events likewise. Owned by UCombatHitNotifySubsystem.
+ * Its only replicated state is the projectile table, sent once, so its net update frequency is minimal and senders
+ * call ForceNetUpdate after a multicast; senders also keep to at most net.MaxRPCPerNetUpdate unreliable multicasts
+ * per frame between them.
+ */
+UCLASS(NotPlaceable, Transient)
+class MAKHIA_API AMKHCombatNetRelay : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	AMKHCombatNetRelay();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Projectile parameters simulated volleys refer to by tag; the game mode's table, replicated to clients on spawn. */
+	UProjectileInfo* GetProjectileInfo() const { return ProjectileInfo; }
+
+	/** Server: sets the table before the relay first replicates. */
+	void SetProjectileInfo(UProjectileInfo* InProjectileInfo) { ProjectileInfo = InProjectileInfo; }
+
+	/** Delivers one frame of hits; clients (and a listen server's local player) fan them out through the subsystem. */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastHitBatch(const FMKHHitBatch& Batch);
+
+	/** Delivers the projectile volleys fired this frame; a lost one would leave its projectiles invisible. */
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastProjectileVolleys(const TArray<FMKHProjectileVolley>& Volleys);
+
+	/** Delivers the projectile impacts of this frame; clients that miss one find it with their own sweeps or let it expire. */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastProjectileImpacts(const TArray<FMKHProjectileImpact>& Impacts);
+
+private:
+
+	UPROPERTY(Replicated)
+	TObjectPtr<UProjectileInfo> ProjectileInfo;
+};
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatTimelineBakeCommandlet.generated.h"
+
+/**
+ * Re-bakes the combat timeline of every UMKHDamageAbility blueprint and saves the ones that changed, e.g. after
+ * attack montages were edited. Returns a non-zero exit code when a montage's windows do not pair up:
+ *   UnrealEditor-Cmd Makhia.uproject -run=CombatTimelineBake
+ */
+UCLASS()
+class MAKHIA_API UCombatTimelineBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UCombatTimelineBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
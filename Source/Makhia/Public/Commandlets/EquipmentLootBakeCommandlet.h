@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "EquipmentLootBakeCommandlet.generated.h"
+
+/**
+ * Re-bakes and saves every UEquipmentLootTable asset of the project.
+ * Returns a non-zero exit code when a source is missing or a roll tag does not resolve, so build scripts can run it before cooking:
+ *   UnrealEditor-Cmd Makhia.uproject -run=EquipmentLootBake
+ */
+UCLASS()
+class MAKHIA_API UEquipmentLootBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UEquipmentLootBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
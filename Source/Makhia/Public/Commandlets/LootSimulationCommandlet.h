@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LootSimulationCommandlet.generated.h"
+
+/**
+ * Rolls millions of equipment items on every core and writes drop distributions and stat value histograms as CSV.
+ * Runs headless, e.g. on a Linux build machine:
+ *   UnrealEditor-Cmd Makhia.uproject -run=LootSimulation -nullrhi -unattended
+ *     -ItemDefinitions=/Game/... -StatEffects=/Game/... -RarityTable=/Game/... [-LootTable=/Game/...]
+ *     [-Rolls=1000000] [-Seed=N] [-Output=Dir]
+ * With -LootTable the baked asset is rolled instead of the DataTables.
+ * The same seed and roll count give the same CSVs on any machine; only the timings depend on the core count.
+ */
+UCLASS()
+class MAKHIA_API ULootSimulationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	ULootSimulationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
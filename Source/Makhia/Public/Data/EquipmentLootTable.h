@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Equipment/EquipmentTypes.h"
+#include "Equipment/Rarity/RarityDefinition.h"
+#include "Libraries/EquipmentRollLibrary.h"
+#include "UObject/ObjectKey.h"
+#include "EquipmentLootTable.generated.h"
+
+class UEquipmentDefinition;
+class UEquipmentStatEffects;
+class UItemTypesToTables;
+
+/** Contiguous slice of one of the baked candidate arrays. */
+USTRUCT()
+struct FBakedLootRange
+{
+	GENERATED_BODY()
+
+	/** Index of the first element of the slice. */
+	UPROPERTY()
+	int32 First = 0;
+
+	/** Number of elements in the slice. */
+	UPROPERTY()
+	int32 Num = 0;
+};
+
+/** Hot data of one rollable candidate: the row it expands to and its selection weight. */
+USTRUCT()
+struct FBakedLootCandidate
+{
+	GENERATED_BODY()
+
+	/** Index into the baked row array of the matching kind (stats or abilities). */
+	UPROPERTY()
+	int32 RowIndex = INDEX_NONE;
+
+	/** Relative probability weight copied from ProbabilityToSelect. */
+	UPROPERTY()
+	float Weight = 0.f;
+};
+
+/** Roll range of one baked stat row, kept apart from the full row so draws stay on a few cache lines. */
+USTRUCT()
+struct FBakedStatRange
+{
+	GENERATED_BODY()
+
+	/** Copy of FEquipmentStatEffectDefinition::MinStatLevel. */
+	UPROPERTY()
+	float MinStatLevel = 1.f;
+
+	/** Copy of FEquipmentStatEffectDefinition::MaxStatLevel. */
+	UPROPERTY()
+	float MaxStatLevel = 1.f;
+
+	/** Copy of FEquipmentStatEffectDefinition::bFractionalStat. */
+	UPROPERTY()
+	bool bFractionalStat = false;
+};
+
+/** Baked roll pools of one equipment definition. */
+USTRUCT()
+struct FBakedLootPool
+{
+	GENERATED_BODY()
+
+	/** Equipment definition the pools were baked from. */
+	UPROPERTY()
+	TSubclassOf<UEquipmentDefinition> EquipmentClass = nullptr;
+
+	/** Slice of StatCandidates built from PossibleStatRolls. */
+	UPROPERTY()
+	FBakedLootRange StatCandidates;
+
+	/** Slice of AbilityCandidates built from PossibleAbilityRolls. */
+	UPROPERTY()
+	FBakedLootRange AbilityCandidates;
+
+	/** Slice of BasicAbilityRows built from BasicAbilitiesGranted. */
+	UPROPERTY()
+	FBakedLootRange BasicAbilities;
+
+	/** True when the definition equips into a weapon slot (only weapons receive abilities). */
+	UPROPERTY()
+	bool bIsWeapon = false;
+};
+
+/**
+ * Read-only loot data baked from the item definition tables, the stat effect tables and the rarity table.
+ * Every equipment definition's pools are flattened into contiguous arrays so rolling never touches a DataTable,
+ * never looks rows up by name and can run on any thread once the asset is loaded.
+ * The asset is re-baked on every save in the editor and fails data validation and the cook while a tag does not resolve;
+ * use the EquipmentLootBake commandlet from build scripts.
+ */
+UCLASS()
+class MAKHIA_API UEquipmentLootTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	/** Re-bakes the table; a failed bake logs its errors, which fails the cook. */
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/** Reports every missing source and unresolved tag Bake would hit as a validation error. */
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+
+	/**
+	 * Rebuilds all baked arrays from the source assets.
+	 * @param OutErrors Receives one message per missing source or unresolved tag.
+	 * @return True when every tag resolved to a row.
+	 */
+	bool Bake(TArray<FString>& OutErrors);
+
+	/** Editor button wrapper around Bake that logs the result. */
+	UFUNCTION(CallInEditor, Category = "Custom Values | Bake")
+	void BakeLootTable();
+#endif
+
+	/** Selects a rarity with the baked weights. Returns nullptr when no rarity is rollable. */
+	const FRarityDefinition* RollRarity(FRandomStream& Stream) const;
+
+	/**
+	 * Rolls the stat effects and abilities of one item with the baked pools.
+	 * @param EquipmentClass Equipment definition of the item.
+	 * @param Rarity         Rarity driving how many stats and abilities are rolled.
+	 * @param Stream         Random stream the draws are taken from.
+	 * @param OutPackage     Receives the rolled package.
+	 * @return False when EquipmentClass was not part of the bake.
+	 */
+	bool RollEffectPackage(const UClass* EquipmentClass, const FRarityDefinition& Rarity, FRandomStream& Stream,
+		FEquipmentEffectPackage& OutPackage) const;
+
+	/** Returns whether EquipmentClass was part of the bake. */
+	bool HasPool(const UClass* EquipmentClass) const { return PoolIndexByClass.Contains(TObjectKey<UClass>(EquipmentClass)); }
+
+	/** Appends the class of every baked pool to OutClasses. */
+	void GetEquipmentClasses(TArray<TSubclassOf<UEquipmentDefinition>>& OutClasses) const;
+
+#if WITH_EDITORONLY_DATA
+	/** Item tables scanned for equipment definitions to bake. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Sources")
+	TObjectPtr<UItemTypesToTables> ItemDefinitions;
+
+	/** Stat and ability tables the definitions' roll tags are resolved against. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Sources")
+	TObjectPtr<UEquipmentStatEffects> StatEffects;
+
+	/** Rarity table baked into the rarity rows. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Sources")
+	TObjectPtr<UDataTable> RarityTable;
+#endif
+
+private:
+
+	/** Rebuilds the transient lookup map and alias tables from the baked arrays. */
+	void BuildRuntimeData();
+
+	/** One pool per baked equipment definition. */
+	UPROPERTY(VisibleAnywhere, Category = "Custom Values | Baked")
+	TArray<FBakedLootPool> Pools;
+
+	/** Passive stat candidates of every pool, laid out back to back. */
+	UPROPERTY()
+	TArray<FBakedLootCandidate> StatCandidates;
+
+	/** Active ability candidates of every pool, laid out back to back. */
+	UPROPERTY()
+	TArray<FBakedLootCandidate> AbilityCandidates;
+
+	/** AbilityRows indices of the guaranteed abilities of every pool. */
+	UPROPERTY()
+	TArray<int32> BasicAbilityRows;
+
+	/** Roll range of each entry of StatRows. */
+	UPROPERTY()
+	TArray<FBakedStatRange> StatRanges;
+
+	/** Roll weight of each entry of RarityRows. */
+	UPROPERTY()
+	TArray<float> RarityWeights;
+
+	/** Full stat rows copied into rolled packages, deduplicated across pools. */
+	UPROPERTY()
+	TArray<FEquipmentStatEffectDefinition> StatRows;
+
+	/** Full ability rows copied into rolled packages, deduplicated across pools. */
+	UPROPERTY()
+	TArray<FEquipmentAbilityDefinition> AbilityRows;
+
+	/** Rollable rarity rows. */
+	UPROPERTY(VisibleAnywhere, Category = "Custom Values | Baked")
+	TArray<FRarityDefinition> RarityRows;
+
+	/** Pool index per equipment definition class. */
+	TMap<TObjectKey<UClass>, int32> PoolIndexByClass;
+
+	/** Alias table of each pool's stat candidates, parallel to Pools. */
+	TArray<FEquipmentAliasTable> StatAliasTables;
+
+	/** Alias table of each pool's ability candidates, parallel to Pools. */
+	TArray<FEquipmentAliasTable> AbilityAliasTables;
+
+	/** Alias table over RarityWeights. */
+	FEquipmentAliasTable RarityAliasTable;
+};
@@ -19,5 +19,9 @@ public:
 
 	UPROPERTY(EditDefaultsOnly)
 	TMap<FGameplayTag, TObjectPtr<UDataTable>> MasterStatMap;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 	
 };
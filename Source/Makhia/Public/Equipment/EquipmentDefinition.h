@@ -9,6 +9,7 @@
 
 class UEquipmentInstance;
 class AEquipmentActor;
+class USkeletalMesh;
 
 /** Defines one actor to spawn when the equipment instance gets equipped. */
 USTRUCT()
@@ -55,10 +56,17 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Stats")
 	FGameplayTagContainer PossibleStatRolls;
 
-	/** Visual actors that are spawned and attached while this item is equipped. */
+	/** Visual actors that are spawned and attached while this item is equipped (rigid pieces such as weapons). */
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Actors")
 	TArray<FEquipmentActorToSpawn> ActorsToSpawn;
 
+	/**
+	 * Skinned pieces (armor, clothing) rendered as leader-pose followers of the character mesh.
+	 * They share the character's pose instead of spawning, ticking and attaching an actor each.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Actors")
+	TArray<TSoftObjectPtr<USkeletalMesh>> SkinnedMeshes;
+
 	/** Candidate active ability tags used by the roll system for this equipment definition. */
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Ability")
 	FGameplayTagContainer PossibleAbilityRolls;
@@ -9,6 +9,8 @@
 struct FEquipmentActorToSpawn;
 class AEquipmentActor;
 class ACharacter;
+class USkeletalMesh;
+class USkeletalMeshComponent;
 
 /**
  * Runtime object created per equipped item to manage spawned actors and equip lifecycle callbacks.
@@ -25,21 +27,31 @@ public:
 	/** Called right before this instance is unequipped and removed. */
 	virtual void OnUnEquipped();
 
-	/** Spawns and attaches all actor specs defined by the equipment definition. */
-	void SpawnEquipmentActors(const TArray<FEquipmentActorToSpawn>& ActorsToSpawn, float WeaponDamage);
-	/** Destroys all actors spawned by this instance and clears runtime references. */
+	/**
+	 * Spawns and attaches all actor specs defined by the equipment definition.
+	 * @param bReplicateActors When false the actors only exist on this machine (cosmetic copies, or the server's hit detection copy).
+	 */
+	void SpawnEquipmentActors(const TArray<FEquipmentActorToSpawn>& ActorsToSpawn, float WeaponDamage, bool bReplicateActors = true);
+	/** Adds the skinned pieces to the owning character as leader-pose followers. Skipped on dedicated servers. */
+	void AttachSkinnedMeshes(const TArray<TSoftObjectPtr<USkeletalMesh>>& SkinnedMeshes);
+	/** Destroys all actors and follower components spawned by this instance and clears runtime references. */
 	void DestroySpawnedActors();
 
 	/** Returns the runtime actors currently spawned by this equipment instance. */
 	const TArray<TObjectPtr<AActor>>& GetSpawnedActors() const;
+
+	/** True when the actors and followers were spawned (or are loading) for Character. */
+	bool HasVisualsOn(const ACharacter* Character) const;
 	
 private:
 	/** Spawns one actor from a spec and stores it if creation succeeds. */
-	void SpawnActorFromSpecification(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage);
+	void SpawnActorFromSpecification(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage, bool bReplicateActors);
 	/** Requests asynchronous class loading, then spawns the actor when loading completes. */
-	void RequestAsyncSpawn(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage);
+	void RequestAsyncSpawn(const FEquipmentActorToSpawn& ActorToSpawn, ACharacter* OwningCharacter, float WeaponDamage, bool bReplicateActors);
 	/** Finalizes deferred actor spawn, attachment, and optional weapon damage initialization. */
 	void FinalizeSpawnedActor(AEquipmentActor* SpawnedActor, ACharacter* OwningCharacter, const FName& AttachName, float WeaponDamage) const;
+	/** Creates and registers one follower component driven by the character mesh. */
+	void AddLeaderPoseFollower(USkeletalMesh* SkeletalMesh, ACharacter* OwningCharacter);
 	/** Applies weapon damage only when the spawned actor is a weapon actor type. */
 	static void ApplyWeaponDamageIfWeapon(AEquipmentActor* SpawnedActor, float WeaponDamage);
 	/** Returns the owning character resolved from this object's outer hierarchy. */
@@ -49,4 +61,11 @@ private:
 	UPROPERTY()
 	TArray<TObjectPtr<AActor>> SpawnedActors;
 
+	/** Leader-pose follower components added to the character for skinned pieces. */
+	UPROPERTY()
+	TArray<TObjectPtr<USkeletalMeshComponent>> FollowerComponents;
+
+	/** Character the current visuals belong to; late async loads for any other character are dropped. */
+	TWeakObjectPtr<ACharacter> VisualCharacter;
+
 };
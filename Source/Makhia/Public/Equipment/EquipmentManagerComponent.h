@@ -13,7 +13,9 @@ class UEquipmentManagerComponent;
 class UEquipmentDefinition;
 class UEquipmentInstance;
 class UMKHAbilitySystemComponent;
-class UInventoryItem;
+class UInventoryComponent;
+class ACharacterBase;
+struct FRPGInventoryEntry;
 
 USTRUCT(BlueprintType)
 struct FRPGEquipmentEntry : public FFastArraySerializerItem
@@ -105,8 +107,13 @@ struct FRPGEquipmentList : public FFastArraySerializer
 	/** Finds a mutable entry by slot. */
 	FRPGEquipmentEntry* FindEntryBySlotMutable(const FGameplayTag& SlotTag);
 
+	/** Rebuilds the visuals of every entry that has none on the owner's current character, e.g. after possessing a new pawn. */
+	void RefreshEquipmentVisuals();
+
 	/** Returns a copy of the current replicated entries. */
 	void GetEntries(TArray<FRPGEquipmentEntry>& OutEntries) const { OutEntries = Entries; }
+	/** Returns a read-only view of the current replicated entries without copying them. */
+	const TArray<FRPGEquipmentEntry>& GetEntries() const { return Entries; }
 
 	// FFastArraySerializer Contract
 	/** Handles replicated removals on clients. */
@@ -133,6 +140,15 @@ private:
 	/** Removes gameplay side effects (stats and abilities) for a valid entry. */
 	void RemoveEntryEffects(FRPGEquipmentEntry& Entry);
 
+	/** Returns whether equipment actors are spawned per machine instead of being replicated. */
+	bool UsesLocalCosmeticActors() const;
+	/** Returns the character currently controlled by the owner, if any. */
+	ACharacterBase* GetOwningCharacter() const;
+	/** Creates the entry's runtime instance (if missing) and builds its local-only visuals on this machine. */
+	void SpawnLocalEquipmentVisuals(FRPGEquipmentEntry& Entry);
+	/** Server: spawns the entry's actors and followers and mirrors it on the character for remote clients. */
+	void SpawnAuthorityEquipmentVisuals(FRPGEquipmentEntry& Entry);
+
 	/** Replicated container of equipped entries. */
 	UPROPERTY()
 	TArray<FRPGEquipmentEntry> Entries;
@@ -172,11 +188,19 @@ public:
 	/** Registers the component replicated properties. */
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	/** Equips an entry, forwarding to server when called by a client. */
-	void EquipItem(const FRPGEquipmentEntry& InEntry);
+	/**
+	 * Requests equipping an inventory item. Only the ItemID crosses the network: the server resolves the
+	 * entry from its own inventory and routes it through UInventoryComponent::UseItem for validation.
+	 * IDs that do not resolve to an equipment item are ignored, so the request cannot use consumables.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Equipment|Operations")
+	void EquipItem(int64 ItemID);
+
+	/** Server only: builds the entry from the owner's inventory list and equips it. Called once the inventory accepted the use. */
+	void EquipFromInventory(int64 ItemID);
 
-	/** Builds a replication-safe FRPGEquipmentEntry from a UInventoryItem. */
-	static FRPGEquipmentEntry BuildEquipmentEntry(const UInventoryItem* InventoryItem);
+	/** Builds a replication-safe FRPGEquipmentEntry from a server-side inventory entry. */
+	static FRPGEquipmentEntry BuildEquipmentEntry(const FRPGInventoryEntry& InventoryEntry, TSubclassOf<UEquipmentDefinition> EquipmentClass);
 	
 	/** Unequips by original ItemID by resolving its target slot. */
 	UFUNCTION(BlueprintCallable, Category = "Equipment|Operations")
@@ -196,11 +220,27 @@ public:
 	/** Returns the equipment entry associated with the slot, if any. */
 	FRPGEquipmentEntry* GetEquipmentEntryBySlot(const FGameplayTag& SlotTag) const;
 
+	/** Rebuilds missing equipment visuals on the owner's current character. Called when the owning controller possesses a pawn. */
+	void RefreshEquipmentVisuals() { EquipmentList.RefreshEquipmentVisuals(); }
+
+	/** Returns whether equipment actors are spawned locally on every machine instead of replicated by the server. */
+	bool ShouldSpawnCosmeticActorsLocally() const { return bSpawnCosmeticActorsLocally; }
+
 private:
 
+	/**
+	 * When true the server spawns non-replicated equipment actors (weapons only on dedicated servers, for hit detection)
+	 * and every client spawns its own cosmetic copies from the replicated entries, saving actor channels and bandwidth.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Replication")
+	bool bSpawnCosmeticActorsLocally = true;
+
+	/** Returns the inventory component of the owner, which is the only trusted source of equippable entries. */
+	UInventoryComponent* GetOwnerInventoryComponent() const;
+
 	/** Reliable server RPC for equip requests coming from clients. */
 	UFUNCTION(Server, Reliable)
-	void ServerEquipItem(FRPGEquipmentEntry InEntry);
+	void ServerEquipItem(int64 ItemID);
 
 	/** Reliable server RPC for unequip requests coming from clients. */
 	UFUNCTION(Server, Reliable)
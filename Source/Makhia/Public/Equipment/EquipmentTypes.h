@@ -10,6 +10,7 @@
 
 class UGameplayEffect;
 class UGameplayAbility;
+class UEquipmentDefinition;
 
 /** Runtime handles to all GAS grants produced by an equipped item. */
 USTRUCT()
@@ -144,4 +145,23 @@ struct FEquipmentEffectPackage
 	UPROPERTY(BlueprintReadOnly)
 	TArray<FEquipmentAbilityDefinition> Abilities = TArray<FEquipmentAbilityDefinition>();
 	
-};
\ No newline at end of file
+};
+
+/** Replicated description of what a character wears in one slot, enough for any client to spawn the visuals locally. */
+USTRUCT()
+struct FEquippedVisual
+{
+	GENERATED_BODY()
+
+	/** Equipment slot the visual belongs to. */
+	UPROPERTY()
+	FGameplayTag SlotTag = FGameplayTag();
+
+	/** Definition whose visuals are built on the receiving machine. */
+	UPROPERTY()
+	TSubclassOf<UEquipmentDefinition> EquipmentDefinition = nullptr;
+
+	/** True when the definition's actors are spawned locally too; otherwise only skinned followers are (actors replicate). */
+	UPROPERTY()
+	bool bSpawnActorsLocally = false;
+};
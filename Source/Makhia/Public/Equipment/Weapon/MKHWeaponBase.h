@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "AbilitySystem/MKHAbilityTypes.h"
 #include "Equipment/EquipmentActor.h"
+#include "UObject/ObjectKey.h"
+#include "WorldCollision.h"
 #include "MKHWeaponBase.generated.h"
 
 struct FDamageEffectInfo;
@@ -21,17 +23,34 @@ public:
 	/** Creates default scene points used for hit scan traces and projectile spawning. */
 	AMKHWeaponBase();
 
-	/** Blueprint event used to execute a weapon-specific hit scan implementation. */
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	virtual void Tick(float DeltaSeconds) override;
+
+	/**
+	 * Server: sweeps the blade from where it was on the previous scan to where it is now. The capsule of HitScanRadius
+	 * around TraceStart-TraceEnd is sub-stepped so fast swings do not tunnel, and the sweeps are submitted
+	 * asynchronously; their hits are damaged on the next frame. Runs every frame of a swing; Blueprint overrides replace it.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void HitScan();
+	virtual void HitScan_Implementation();
 	
-	/** Blueprint event fired when hit scan begins with prepared damage context. */
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	/** Server: starts a swing dealing DamageEffectInfo, each target at most once. Blueprint overrides replace the native scan. */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void HitScanStart(FDamageEffectInfo DamageEffectInfo);
+	virtual void HitScanStart_Implementation(FDamageEffectInfo DamageEffectInfo);
 	
-	/** Blueprint event fired when hit scan ends. */
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	/** Server: scans the last stretch of the swing and stops; pending sweeps are still damaged next frame. */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void HitScanEnd();
+	virtual void HitScanEnd_Implementation();
+
+	/**
+	 * Server: sweeps HitScanRadius from TraceStart to TraceEnd against pawns as the attacking player saw them
+	 * (see ULagCompensationSubsystem). The owner is ignored. Use it in HitScan for pawn hits instead of a world trace.
+	 * @return True if any pawn was hit.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Custom Values | Hit Scan")
+	bool LagCompensatedSweep(TArray<FHitResult>& OutHits) const;
 	
 	/** Sets the runtime base damage value used by abilities reading from the weapon actor. */
 	void SetWeaponDamage(float InDamage);
@@ -72,8 +91,46 @@ protected:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Custom Values | Hit Scan")
 	float HitScanRadius = 0.f;
 
+	/** Object type swept by the native hit scan. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Hit Scan")
+	TEnumAsByte<ECollisionChannel> HitScanObjectType = ECC_Pawn;
+
 private:
 	
 	/** Base damage value assigned from the equipment definition when equipped. */
 	float WeaponDamage = 0.f;
+
+	/** Reads the results of the sweeps submitted on earlier frames; this frame's sweeps stay pending. */
+	void CollectSwingSweeps();
+
+	/** Keeps Hit for this frame's damage if its actor has not been hit during the swing yet. */
+	void AddSwingHit(const FHitResult& Hit);
+
+	/** Applies this frame's new hits as one batch. */
+	void ApplySwingHits();
+
+	/** True between HitScanStart and HitScanEnd. */
+	bool bSwingActive = false;
+
+	/** Pawn hits come from the lag compensation history (remote attackers) instead of the world sweeps. */
+	bool bRewindPawns = false;
+
+	/** Blade position at the previous scan. */
+	FVector LastTraceStart = FVector::ZeroVector;
+	FVector LastTraceEnd = FVector::ZeroVector;
+
+	/** Every actor the swing has reached since HitScanStart, whether it took damage or not. */
+	TSet<FObjectKey> SwingHitTargets;
+
+	/** An async sweep awaiting its results, which are readable from the frame after it was submitted. */
+	struct FPendingSweep
+	{
+		FTraceHandle Handle;
+		uint64 Frame = 0;
+	};
+
+	TArray<FPendingSweep> PendingSweeps;
+
+	/** New hits of this frame. */
+	TArray<FHitResult> FrameHits;
 };
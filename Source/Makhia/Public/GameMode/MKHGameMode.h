@@ -21,6 +21,14 @@ public:
 	UCharacterClassInfo* GetCharacterClassDefaultInfo() const;
 	UProjectileInfo* GetProjectileInfo() const;
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	/** Seed every loot roll of this match derives from. */
+	int32 GetMatchLootSeed() const { return MatchLootSeed; }
+
+	/** Returns the seed of the next drop: the match seed combined with a per-match drop counter. */
+	int32 NextLootDropSeed();
+
 private:
 
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Class Defaults")
@@ -28,4 +36,12 @@ private:
 	
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Projectiles")
 	TObjectPtr<UProjectileInfo> ProjectileInfo;
+
+	/** Match loot seed used when non-zero, otherwise a random one is picked. The ?LootSeed= URL option overrides both. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values | Loot")
+	int32 FixedLootSeed = 0;
+
+	int32 MatchLootSeed = 0;
+
+	uint32 LootDropCounter = 0;
 };
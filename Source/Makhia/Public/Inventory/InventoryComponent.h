@@ -14,6 +14,7 @@ class UInventoryItem;
 class UInventoryComponent;
 class UItemTypesToTables;
 class UEquipmentStatEffects;
+class UEquipmentLootTable;
 struct FStreamableHandle;
 struct FStreamableManager;
 
@@ -49,6 +50,10 @@ struct FRPGInventoryEntry : public FFastArraySerializerItem
 	UPROPERTY(BlueprintReadOnly)
 	FGameplayTag RarityTag = FGameplayTag();
 
+	/** Seed the rarity, stats and abilities were rolled from. Together with ItemTag it regenerates the item. */
+	UPROPERTY(BlueprintReadOnly, NotReplicated)
+	int32 RollSeed = 0;
+
 	/** True when the item is currently assigned to a quick slot. */
 	UPROPERTY(BlueprintReadOnly, NotReplicated)
 	bool bIsQuickSlotted = false;
@@ -68,6 +73,21 @@ struct FRPGInventoryEntry : public FFastArraySerializerItem
 	}
 };
 
+/**
+ * Assets an equipment roll reads. They are never written while rolling,
+ * so a copy can be handed to a worker thread together with the entry to fill.
+ */
+struct FEquipmentRollSources
+{
+	const UEquipmentLootTable* LootTable = nullptr;
+	const UEquipmentStatEffects* StatsData = nullptr;
+	/** Non-const so the game thread can subscribe the roll caches to its change delegate. */
+	UDataTable* RarityTable = nullptr;
+
+	/** Returns whether either the baked loot table or both DataTable sources are available. */
+	bool CanRoll() const { return LootTable || (StatsData && RarityTable); }
+};
+
 DECLARE_MULTICAST_DELEGATE_OneParam(FInventoryItemChangedSignature, const FRPGInventoryEntry& /*DirtyEntry*/);
 DECLARE_MULTICAST_DELEGATE_OneParam(FInventoryItemRemovedSignature, const int64 /*RemovedItemID*/);
 DECLARE_MULTICAST_DELEGATE_OneParam(FInventoryQuickSlotRelocatedSignature, const FRPGInventoryEntry& /*EntryToRelocate*/);
@@ -87,6 +107,19 @@ struct FRPGInventoryList : public FFastArraySerializer
 
 	/** Adds an item to the list, optionally handling stacking and generation. */
 	void AddItem(const FGameplayTag& ItemTag, int32 NumItems = 1);
+
+	/** Inserts an entry whose equipment fields were already rolled (stacking non-equipment items), then assigns its ID. */
+	void AddRolledEntry(FRPGInventoryEntry&& RolledEntry);
+
+	/**
+	 * Fills the equipment-specific fields of NewEntry (rarity, stats, abilities) from a stream seeded with RollSeed.
+	 * Touches nothing but its arguments, so it can run on any thread.
+	 */
+	static void RollEquipmentEntry(FRPGInventoryEntry& NewEntry, TSubclassOf<UEquipmentDefinition> EquipmentClass, int32 RollSeed,
+		const FEquipmentRollSources& Sources);
+
+	/** Returns the roll assets currently bound to this list (server only). */
+	FEquipmentRollSources GetRollSources() const;
 	
 	/** Removes a specified number of items from an entry. */
 	void RemoveItem(const FRPGInventoryEntry& InventoryEntry, int32 NumItems = 1);
@@ -94,14 +127,17 @@ struct FRPGInventoryList : public FFastArraySerializer
 	/** Checks if the inventory contains at least NumItems of the given ItemID. */
 	bool HasEnough(int64 ItemID, int32 NumItems) const;
 	
-	/** Generates a unique 64-bit ID for a new item. */
-	int64 GenerateID();
+	/** Generates a unique 64-bit ID for a new item, drawing the signature bits from Stream. */
+	int64 GenerateID(FRandomStream& Stream);
 	
 	/** Sets the data table used for rolling stats. */
 	void SetStats(UEquipmentStatEffects* InStats);
 	
 	/** Sets the data table used for rolling rarity. */
 	void SetRarityTable(UDataTable* InRarityTable);
+
+	/** Sets the baked loot table that replaces the stat and rarity tables when rolling. */
+	void SetLootTable(UEquipmentLootTable* InLootTable);
 	
 	/** Adds an already unequipped item back to the list cleanly. */
 	void AddUnEquippedItem(UInventoryItem* Item);
@@ -163,6 +199,10 @@ private:
 	UPROPERTY(NotReplicated)
 	TWeakObjectPtr<UDataTable> WeakRarityTable;
 
+	/** Weak ref to the baked loot table, preferred over the stat and rarity tables when set. */
+	UPROPERTY(NotReplicated)
+	TWeakObjectPtr<UEquipmentLootTable> WeakLootTable;
+
 	/** Tries to find an existing stackable entry and increment its quantity. Returns true if stacked. */
 	bool TryStackItem(const FGameplayTag& ItemTag, int32 NumItems);
 	/** Marks an entry dirty and broadcasts a change event on authority. */
@@ -170,9 +210,6 @@ private:
 	/** Handles relocation of any existing entry already assigned to a target quick slot. */
 	void RelocateQuickSlotOccupant(FRPGInventoryEntry& EntryToAssign, const FGameplayTag& QuickSlotTag);
 
-	/** Fills the equipment-specific fields of NewEntry (rarity, stats, abilities). */
-	void RollEquipmentEntry(FRPGInventoryEntry& NewEntry, const FMasterItemDefinition& ItemDef);
-
 	/** Marks an entry dirty and broadcasts it if running with authority. */
 	void BroadcastNewEntry(FRPGInventoryEntry& NewEntry);
 
@@ -244,6 +281,26 @@ public:
 	/** Adds an item entry that was unequipped back to the inventory properly. */
 	void AddUnEquippedItemEntry(UInventoryItem* Item);
 
+	/**
+	 * Adds an item through the world's loot pipeline: the roll runs on a worker task and the entry is inserted
+	 * on a later frame within the commit budget. Falls back to AddItem when no pipeline is available.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory|Operations")
+	void AddItemDeferred(const FGameplayTag& ItemTag, int32 NumItems = 1);
+
+	/** Inserts an entry rolled by the loot pipeline. Server only. */
+	void AddRolledItem(FRPGInventoryEntry&& RolledEntry);
+
+	/** Returns the roll seed of the next drop, derived from the match seed when the game mode provides one. */
+	int32 NextLootDropSeed() const;
+
+	/**
+	 * Rolls the equipment item a logged (ItemTag, RollSeed) pair produced, without adding it to the inventory.
+	 * Server only: the roll data is not available on clients.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory|Queries")
+	FRPGInventoryEntry RegenerateRolledItem(const FGameplayTag& ItemTag, int32 RollSeed);
+
 	// -------------------------------------------------------------------------
 	// QuickSlot Management
 	// -------------------------------------------------------------------------
@@ -324,6 +381,10 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values|Rarity")
 	TObjectPtr<UDataTable> RarityTable;
 
+	/** Baked roll data. When set, equipment rolls read only this asset and skip the tables above. */
+	UPROPERTY(EditDefaultsOnly, Category = "Custom Values|Rarity")
+	TObjectPtr<UEquipmentLootTable> LootTable;
+
 	/** Master tag-to-table definition mapping for items. */
 	UPROPERTY(EditDefaultsOnly, Category = "Custom Values|Item Definitions")
 	TObjectPtr<UItemTypesToTables> InventoryDefinitions;
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayTagContainer.h"
+#include "Containers/Queue.h"
+#include "Tasks/Task.h"
+#include "Inventory/InventoryComponent.h"
+#include "LootPipelineSubsystem.generated.h"
+
+/**
+ * Server-side loot pipeline that keeps mass drops (e.g. a whole wave dying in one frame) off the game thread.
+ * Drops are captured on the game thread (definition lookup and seed), rolled in batches on worker tasks from
+ * read-only roll data, and committed into the inventories on later frames within a time budget.
+ * Tunables: Makhia.Loot.CommitBudgetMs, Makhia.Loot.MaxCommitsPerFrame, Makhia.Loot.RollBatchSize.
+ */
+UCLASS()
+class MAKHIA_API ULootPipelineSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Queues NumItems of ItemTag for Inventory. Equipment is rolled on a worker task; everything is inserted
+	 * through UInventoryComponent::AddRolledItem on a later frame. Server only.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory|Loot")
+	void QueueDrop(UInventoryComponent* Inventory, const FGameplayTag& ItemTag, int32 NumItems = 1);
+
+	/** Returns the number of queued drops that have not been committed yet. */
+	UFUNCTION(BlueprintPure, Category = "Inventory|Loot")
+	int32 GetNumPendingDrops() const { return NumPendingDrops; }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** A drop captured on the game thread; everything a worker needs to roll it without touching UObjects' mutable state. */
+	struct FLootRollRequest
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+		FRPGInventoryEntry Entry;
+		TSubclassOf<UEquipmentDefinition> EquipmentClass;
+		FEquipmentRollSources Sources;
+	};
+
+	/** A rolled drop waiting for its game-thread commit. */
+	struct FRolledLoot
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+		FRPGInventoryEntry Entry;
+	};
+
+	/** Launches one worker task per batch of pending requests. */
+	void LaunchRollTasks();
+
+	/** Inserts completed drops into their inventories until the frame budget runs out. */
+	void CommitRolledLoot();
+
+	/** Requests queued this frame, launched on the next tick. Game thread only. */
+	TArray<FLootRollRequest> PendingRequests;
+
+	/** Finished drops, produced by workers and consumed by the game thread. */
+	TQueue<FRolledLoot, EQueueMode::Mpsc> RolledLoot;
+
+	/** Roll tasks that may still be running; waited on before the subsystem goes away. */
+	TArray<UE::Tasks::FTask> RollTasks;
+
+	/** Drops queued but not committed yet. Game thread only. */
+	int32 NumPendingDrops = 0;
+};
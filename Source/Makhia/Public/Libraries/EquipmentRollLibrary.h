@@ -14,9 +14,55 @@ struct FEquipmentStatEffectDefinition;
 struct FEquipmentAbilityDefinition;
 struct FRarityDefinition;
 
+/**
+ * Vose alias table: O(n) build, O(1) weighted draw regardless of the number of candidates.
+ */
+struct MAKHIA_API FEquipmentAliasTable
+{
+	/** Rebuilds the table from non-negative weights. Leaves the table empty if every weight is zero. */
+	void Build(TConstArrayView<float> Weights);
+
+	/**
+	 * Draws one index from two independent uniforms in [0, 1).
+	 * @return Selected index, or INDEX_NONE when the table is empty.
+	 */
+	int32 Sample(float ColumnRoll, float CoinRoll) const;
+
+	/** Returns the number of candidates. */
+	int32 Num() const { return Probability.Num(); }
+
+	/** Returns whether the table has no candidates. */
+	bool IsEmpty() const { return Probability.IsEmpty(); }
+
+	/** Draws one index using two fractions of Stream. */
+	int32 Sample(FRandomStream& Stream) const
+	{
+		const float ColumnRoll = Stream.GetFraction();
+		return Sample(ColumnRoll, Stream.GetFraction());
+	}
+
+private:
+
+	/** Probability of keeping the column index instead of its alias. */
+	TArray<float> Probability;
+
+	/** Fallback index for each column. */
+	TArray<int32> Alias;
+};
+
+/** Cached, immutable candidate pool with its alias table. Row pointers point into the source DataTables. */
+template<typename RowType>
+struct TEquipmentRollPool
+{
+	TArray<const RowType*> Rows;
+	FEquipmentAliasTable AliasTable;
+};
+
 /**
  * Static library that handles all equipment roll logic: rarity selection,
  * passive stat rolling, and active ability rolling.
+ * Candidate pools are built once per equipment definition / rarity table and invalidated when a source table changes.
+ * Every roll draws from the caller's FRandomStream, so a seed reproduces the exact result and each thread can own its stream.
  */
 UCLASS()
 class MAKHIA_API UEquipmentRollLibrary : public UBlueprintFunctionLibrary
@@ -29,31 +75,35 @@ public:
 	 * Selects a rarity tag from the RarityTable using weighted probability.
 	 * Returns the FRarityDefinition pointer for the selected row (nullptr on failure).
 	 */
-	static const FRarityDefinition* RollRarity(const UDataTable* RarityTable);
+	static const FRarityDefinition* RollRarity(const UDataTable* RarityTable, FRandomStream& Stream);
 
 	/**
 	 * Rolls passive stat effects for an equipment item.
 	 * @param EquipmentCDO  The equipment CDO whose PossibleStatRolls define the candidate pool.
 	 * @param StatData      The master stat data asset containing DataTables per tag category.
 	 * @param NumStats      How many passive stats to attempt rolling (driven by rarity).
+	 * @param Stream        Random stream the draws are taken from.
 	 * @return Array of rolled stat effect definitions with their CurrentValue already set.
 	 */
 	static TArray<FEquipmentStatEffectDefinition> RollPassiveStats(
 		const UEquipmentDefinition* EquipmentCDO,
 		const UEquipmentStatEffects* StatData,
-		int32 NumStats);
+		int32 NumStats,
+		FRandomStream& Stream);
 
 	/**
 	 * Rolls active abilities for a weapon.
 	 * @param EquipmentCDO  The equipment CDO whose PossibleAbilityRolls define the candidate pool.
 	 * @param StatData      The master stat data asset containing DataTables per tag category.
 	 * @param NumAbilities  How many active abilities to attempt rolling (driven by rarity).
+	 * @param Stream        Random stream the draws are taken from.
 	 * @return Array of rolled ability definitions.
 	 */
 	static TArray<FEquipmentAbilityDefinition> RollActiveAbilities(
 		const UEquipmentDefinition* EquipmentCDO,
 		const UEquipmentStatEffects* StatData,
-		int32 NumAbilities);
+		int32 NumAbilities,
+		FRandomStream& Stream);
 
 	/**
 	 * Resolves explicit ability tags into ability definitions.
@@ -65,12 +115,40 @@ public:
 		const FGameplayTagContainer& AbilityTags,
 		const UEquipmentStatEffects* StatData);
 
+	/** Rolls a stat level in [MinStatLevel, MaxStatLevel], truncated to an integer value unless bFractionalStat. */
+	static float RollStatLevel(float MinStatLevel, float MaxStatLevel, bool bFractionalStat, FRandomStream& Stream);
+
+	/** Drops every cached candidate pool. Called automatically when a watched DataTable changes. */
+	static void InvalidateRollCaches();
+
+	/**
+	 * Game thread: builds the pools a roll of EquipmentCDO draws from and subscribes the caches to the tables' change
+	 * delegates, so rolls on worker threads only read published pools. EquipmentCDO may be null to prewarm the rarity pool only.
+	 */
+	static void PrewarmRollCaches(const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData, UDataTable* RarityTable);
+
 private:
 
+	using FStatPool = TEquipmentRollPool<FEquipmentStatEffectDefinition>;
+	using FAbilityPool = TEquipmentRollPool<FEquipmentAbilityDefinition>;
+	using FRarityPool = TEquipmentRollPool<FRarityDefinition>;
+
+	/** Returns the cached stat pool for the definition, building it on first use. */
+	static TSharedPtr<const FStatPool, ESPMode::ThreadSafe> GetStatPool(const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData);
+
+	/** Returns the cached ability pool for the definition, building it on first use. */
+	static TSharedPtr<const FAbilityPool, ESPMode::ThreadSafe> GetAbilityPool(const UEquipmentDefinition* EquipmentCDO, const UEquipmentStatEffects* StatData);
+
+	/** Returns the cached rarity pool for the table, building it on first use. */
+	static TSharedPtr<const FRarityPool, ESPMode::ThreadSafe> GetRarityPool(const UDataTable* RarityTable);
+
 	/**
-	 * Performs a weighted random selection over an array of weights.
-	 * @param Weights  Array of positive weights (one per candidate).
-	 * @return Index of the selected element, or -1 if the array is empty.
+	 * Builds a candidate pool by resolving every tag against the first matching MasterStatMap table.
+	 * Rows with a non-positive ProbabilityToSelect are skipped.
 	 */
-	static int32 WeightedRandomSelect(const TArray<float>& Weights);
+	template<typename RowType>
+	static void BuildTagPool(const FGameplayTagContainer& PossibleTags, const UEquipmentStatEffects* StatData, TEquipmentRollPool<RowType>& OutPool);
+
+	/** Subscribes the cache invalidation to a DataTable's change delegate (once per table). Game thread only. */
+	static void WatchDataTable(UDataTable* DataTable);
 };
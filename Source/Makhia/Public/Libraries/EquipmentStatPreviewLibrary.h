@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "AttributeSet.h"
+#include "EquipmentStatPreviewLibrary.generated.h"
+
+class UAbilitySystemComponent;
+class UEquipmentManagerComponent;
+class UInventoryItem;
+struct FEquipmentEffectPackage;
+
+/** Current and previewed value of a single attribute touched by an equipment comparison. */
+USTRUCT(BlueprintType)
+struct FEquipmentStatPreviewEntry
+{
+	GENERATED_BODY()
+
+	/** Attribute affected by either the equipped or the candidate package. */
+	UPROPERTY(BlueprintReadOnly)
+	FGameplayAttribute Attribute = FGameplayAttribute();
+
+	/** Value with the currently equipped packages. */
+	UPROPERTY(BlueprintReadOnly)
+	float CurrentValue = 0.f;
+
+	/** Value the attribute would have once the candidate is equipped. */
+	UPROPERTY(BlueprintReadOnly)
+	float PreviewValue = 0.f;
+
+	/** Returns PreviewValue - CurrentValue. */
+	float GetDelta() const { return PreviewValue - CurrentValue; }
+};
+
+/** Result of a side-effect-free equipment comparison. */
+USTRUCT(BlueprintType)
+struct FEquipmentStatPreview
+{
+	GENERATED_BODY()
+
+	/** One entry per attribute modified by the equipped or candidate packages. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FEquipmentStatPreviewEntry> Entries = TArray<FEquipmentStatPreviewEntry>();
+
+	/** False when some stat effect could not be evaluated (class not loaded or non-static magnitude). */
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsComplete = true;
+};
+
+/**
+ * Evaluates what equipping an item would do to the owner's attributes without applying anything to the ASC.
+ * Modifiers are read from the gameplay effect CDOs referenced by the stat packages and aggregated with the
+ * same formula GAS uses, so tooltips can show exact numbers before the player commits to the swap.
+ */
+UCLASS()
+class MAKHIA_API UEquipmentStatPreviewLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Compares the candidate item against whatever currently occupies its equipment slot.
+	 * @param OwnerASC          ASC whose attribute base values are used as the starting point (read only).
+	 * @param EquipmentManager  Equipment manager providing the currently equipped packages.
+	 * @param CandidateItem     Inventory item the player is hovering.
+	 * @param OutPreview        Resulting per-attribute values.
+	 * @return False when the inputs cannot be resolved into a comparison.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Equipment|Preview")
+	static bool PreviewEquipmentSwap(const UAbilitySystemComponent* OwnerASC, const UEquipmentManagerComponent* EquipmentManager,
+		const UInventoryItem* CandidateItem, FEquipmentStatPreview& OutPreview);
+
+	/**
+	 * Core evaluator: base values + ActivePackages against base values + ActivePackages - ReplacedPackage + CandidatePackage.
+	 * @param OwnerASC          ASC whose attribute base values are read.
+	 * @param ActivePackages    Packages of every currently equipped item.
+	 * @param ReplacedPackage   Package leaving the slot (may be nullptr when the slot is empty).
+	 * @param CandidatePackage  Package entering the slot.
+	 * @param OutPreview        Resulting per-attribute values.
+	 */
+	static void EvaluatePackages(const UAbilitySystemComponent* OwnerASC, TConstArrayView<const FEquipmentEffectPackage*> ActivePackages,
+		const FEquipmentEffectPackage* ReplacedPackage, const FEquipmentEffectPackage& CandidatePackage, FEquipmentStatPreview& OutPreview);
+
+	/** Drops the cached modifier definitions. Done automatically on blueprint recompiles, hot reload and effect edits. */
+	static void ResetModifierCache();
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "GameplayTagContainer.h"
+#include "GameplayEffectTypes.h"
 #include "MKHAbilitySystemLibrary.generated.h"
 
 struct FRPGInventoryEntry;
@@ -30,6 +31,18 @@ public:
 	UFUNCTION(BlueprintCallable)
 	static void ApplyDamageEffect(const FDamageEffectInfo& DamageEffectInfo);
 
+	/**
+	 * Applies one swing/explosion to every hit target. The outgoing spec (and the snapshot of the source's
+	 * CritChance/CritDamageMod) is built once; each target gets its own context, hit result and crit roll.
+	 * Hits on the same actor are applied once. DamageEffectInfo.TargetASC is ignored.
+	 */
+	UFUNCTION(BlueprintCallable)
+	static void ApplyDamageEffectToHits(const FDamageEffectInfo& DamageEffectInfo, const TArray<FHitResult>& Hits);
+
+	/** Same as ApplyDamageEffectToHits for targets found without a trace (overlaps, radial queries). */
+	UFUNCTION(BlueprintCallable)
+	static void ApplyDamageEffectToTargets(const FDamageEffectInfo& DamageEffectInfo, const TArray<AActor*>& TargetActors);
+
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set Loose Tag Count Static"))
 	static void K2_SetLooseTagCountStatic(UAbilitySystemComponent* ASC, FGameplayTag Tag, int32 NewCount);
 
@@ -37,6 +50,15 @@ public:
 	static T* GetDataTableRowByTag(const UDataTable* DataTable, const FGameplayTag& Tag);
 
 	static void AssignDynamicSkillInputTag(FRPGInventoryEntry& NewEntry);
+
+private:
+
+	/** Builds the outgoing damage spec shared by every target of one application. */
+	static FGameplayEffectSpecHandle MakeDamageSpec(const FDamageEffectInfo& DamageEffectInfo);
+
+	/** Applies the shared spec to one target with a context of its own, so per-target data (crit, hit) stays separate. */
+	static void ApplyDamageSpecToTarget(FGameplayEffectSpec& DamageSpec, const FGameplayEffectContextHandle& SourceContext,
+		UAbilitySystemComponent* TargetASC, const FHitResult* Hit);
 };
 
 template<typename T>
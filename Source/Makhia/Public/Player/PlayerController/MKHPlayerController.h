@@ -69,6 +69,12 @@ protected:
 
 	virtual void BeginPlay() override;
 
+	/** Server: rebuilds equipment visuals on the newly possessed pawn. */
+	virtual void OnPossess(APawn* InPawn) override;
+
+	/** Owning client: rebuilds the local equipment visuals once the possessed pawn replicates. */
+	virtual void OnRep_Pawn() override;
+
 	UFUNCTION(BlueprintCallable)
 	void ChangeMappingContext(const UInputMappingContext* NewMappingContext) const;
 
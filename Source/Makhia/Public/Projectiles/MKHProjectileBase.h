@@ -35,6 +35,33 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = "Projectile | Damage")
 	FDamageEffectInfo DamageEffectInfo;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// ==========================================
+	// Prediction
+	// ==========================================
+
+	/**
+	 * Owning client: makes this locally spawned projectile a cosmetic stand-in for ShotId. It deals no damage, hides on
+	 * impact, and gives way to the server's projectile when that one replicates. Call before FinishSpawning.
+	 */
+	void InitPredicted(const FMKHProjectileShotId& InShotId);
+
+	/** Server: tags the projectile with the shot the owning client predicted. Call before FinishSpawning. */
+	void SetShotId(const FMKHProjectileShotId& InShotId) { ShotId = InShotId; }
+
+	/**
+	 * Server: advances the projectile by DeltaSeconds at once, overlaps and hits included, so a remote shooter's shot
+	 * starts about where its predicted copy already is.
+	 */
+	void CatchUp(float DeltaSeconds);
+
+	/** True for a client's predicted stand-in. */
+	bool IsPredicted() const { return bPredicted; }
+
+	virtual void PostNetReceiveLocationAndRotation() override;
+	virtual void PostNetReceiveVelocity(const FVector& NewVelocity) override;
+
 	// ==========================================
 	// Collision Events
 	// ==========================================
@@ -79,4 +106,23 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "Projectile | Components")
 	TObjectPtr<UProjectileMovementComponent> ProjectileMovementComponent;
 
+	/** Shot this projectile belongs to; set only for shots a client predicted, and replicated to that client alone. */
+	UPROPERTY(Replicated)
+	FMKHProjectileShotId ShotId;
+
+	/** This is a client's stand-in, see InitPredicted. */
+	bool bPredicted = false;
+
+	/** The stand-in reached something and is hidden, waiting for the server's projectile. */
+	bool bPredictedImpact = false;
+
+	/** The owning client moved this server projectile onto its stand-in; replicated movement would pull it back by half a round trip. */
+	bool bMergedPrediction = false;
+
+	/** Owning client: takes over (or culls) the stand-in of this server projectile. */
+	void ReconcileWithPrediction();
+
+	/** Hides the stand-in where it hit; the server's projectile resolves the hit. */
+	void EndPrediction();
+
 };
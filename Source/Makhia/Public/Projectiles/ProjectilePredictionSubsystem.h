@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AbilitySystem/MKHAbilityTypes.h"
+#include "ProjectilePredictionSubsystem.generated.h"
+
+class AMKHProjectileBase;
+
+/**
+ * Owning client: projectiles spawned ahead of the server by predicted projectile abilities, until the server's
+ * projectile for the same shot replicates and takes over (see AMKHProjectileBase::InitPredicted).
+ * Tunables: Makhia.Combat.ProjectileMergeDistance, Makhia.Combat.ProjectilePredictionTimeout.
+ */
+UCLASS()
+class MAKHIA_API UProjectilePredictionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Records Projectile as the predicted copy of ShotId. */
+	void AddPrediction(const FMKHProjectileShotId& ShotId, AMKHProjectileBase* Projectile);
+
+	/** Removes and returns the predicted copy of ShotId, if it is still around. */
+	AMKHProjectileBase* TakePrediction(const FMKHProjectileShotId& ShotId);
+
+	/** Destroys every predicted projectile of an activation the server rejected. */
+	void CullPredictions(int16 PredictionKey);
+
+	/** Returns the number of predicted projectiles waiting for their server copy. */
+	int32 GetNumPredictions() const { return Predictions.Num(); }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	TMap<FMKHProjectileShotId, TWeakObjectPtr<AMKHProjectileBase>> Predictions;
+};
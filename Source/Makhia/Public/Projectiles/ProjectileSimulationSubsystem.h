@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AbilitySystem/MKHAbilityTypes.h"
+#include "Combat/MKHCombatNetRelay.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UProjectileInfo;
+class UStaticMesh;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSimulatedProjectileImpactSignature, FVector, Location);
+
+/**
+ * Actor-less projectiles for FProjectileParams with bSimulated, kept as parallel arrays and stepped together.
+ * Each projectile advances in fixed steps counted from its spawn time, so a client seeded with the same volley
+ * (see FMKHProjectileVolley) flies it along the same path as the server. The server multicasts volleys and impacts
+ * through AMKHCombatNetRelay; clients only sweep against world geometry and drop projectiles on the server's impacts.
+ * The sweeps of a step run as one parallel batch. Non-dedicated machines draw one instanced mesh per projectile mesh.
+ * Tunables: Makhia.Projectile.StepRate, Makhia.Projectile.MaxStepsPerFrame, Makhia.Projectile.ParallelSweeps.
+ */
+UCLASS()
+class MAKHIA_API UProjectileSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Server: fires one projectile per direction from Origin, flying the UProjectileInfo parameters of ProjectileTag.
+	 * Every projectile applies DamageEffectInfo to the first actor with an ability system it hits; Owner is never hit.
+	 * Calls with the same owner, tag and origin in one frame are sent to clients as a single volley.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Projectile")
+	void SpawnVolley(const FGameplayTag& ProjectileTag, const FVector& Origin, const TArray<FVector>& Directions, AActor* Owner, const FDamageEffectInfo& DamageEffectInfo);
+
+	/** Starts simulating volleys fired by the server, caught up to the server's time. Called by the relay with its table. */
+	void ReceiveVolleys(const TArray<FMKHProjectileVolley>& Volleys, const UProjectileInfo* ProjectileInfo);
+
+	/** Ends the projectiles the server saw impact. Called by the relay. */
+	void ReceiveImpacts(const TArray<FMKHProjectileImpact>& Impacts);
+
+	/** Returns the number of projectiles in flight on this machine. */
+	UFUNCTION(BlueprintPure, Category = "Projectile")
+	int32 GetNumProjectiles() const { return Ids.Num(); }
+
+	/** Fired locally when a projectile ends on a hit, for impact effects. */
+	UPROPERTY(BlueprintAssignable, Category = "Projectile")
+	FOnSimulatedProjectileImpactSignature OnProjectileImpact;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Appends the projectiles of Volley from FirstShot on. DamageSlot is INDEX_NONE on clients. */
+	void AddProjectiles(const FMKHProjectileVolley& Volley, int32 FirstShot, const FProjectileParams& Params, int32 DamageSlot);
+
+	/** Steps every projectile whose next step ends at or before Now, round after round. */
+	void Simulate(double Now);
+
+	/** Sweeps the step of each projectile in StepIndices, in parallel. */
+	void SweepStep(float StepTime);
+
+	/** Moves, bounces or ends the projectiles of the step from their sweep results. */
+	void ResolveStep(float StepTime);
+
+	/** Swap-removes the projectile at Index from every array. */
+	void RemoveProjectile(int32 Index);
+
+	/** Applies the damage of this frame's impacts, grouped per damage slot. */
+	void ApplyPendingDamage();
+
+	/** Multicasts the volleys of this frame and the oldest impacts, one unreliable multicast per frame. */
+	void FlushNetEvents();
+
+	/** Matches the instanced meshes to the projectiles' positions. */
+	void UpdateInstances();
+
+	/** Returns the render group of Mesh, creating its instanced mesh component on first use. */
+	int32 FindOrAddMeshGroup(UStaticMesh* Mesh);
+
+	/** Server world time, which every machine steps projectiles against. */
+	double GetSimulationTime() const;
+
+	// Projectile state, one entry per projectile in every array
+	TArray<uint32> Ids;
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> GravityZ;
+	/** Negative for projectiles that end on their first blocking hit. */
+	TArray<float> Bounciness;
+	TArray<float> Radii;
+	/** Server time each projectile has been simulated up to. */
+	TArray<double> SimTimes;
+	TArray<double> ExpireTimes;
+	TArray<TWeakObjectPtr<AActor>> Owners;
+	/** Slot in DamageSlots; INDEX_NONE on clients. */
+	TArray<int32> DamageIndices;
+	/** Slot in MeshGroups; INDEX_NONE when not drawn. */
+	TArray<int32> MeshIndices;
+
+	// Per-step scratch, indexed like StepIndices
+	TArray<int32> StepIndices;
+	TArray<const AActor*> StepOwners;
+	/** Sweep hits of each stepping projectile, nearest first. Never shrunk, so the inner arrays keep their memory. */
+	TArray<TArray<FHitResult>> StepHits;
+
+	/** Damage shared by the projectiles of one SpawnVolley call; referenced here so the source stays valid while they fly. */
+	UPROPERTY(Transient)
+	TArray<FDamageEffectInfo> DamageSlots;
+
+	/** Projectiles still flying per damage slot. */
+	TArray<int32> DamageSlotRefs;
+
+	/** Slots whose last projectile ended this frame, freed once their damage is applied. */
+	TArray<int32> ReleasedDamageSlots;
+	TArray<int32> FreeDamageSlots;
+
+	struct FPendingDamage
+	{
+		int32 DamageSlot = INDEX_NONE;
+		FHitResult Hit;
+		bool bApplied = false;
+	};
+
+	/** Impacts on actors with an ability system since the last tick. Server only. */
+	TArray<FPendingDamage> PendingDamage;
+
+	/** Volleys and impacts to multicast at the end of the tick. Server only. */
+	TArray<FMKHProjectileVolley> PendingVolleys;
+	TArray<FMKHProjectileImpact> PendingImpacts;
+
+	uint32 NextId = 1;
+
+	/** Holds the instanced mesh components; spawned on the first drawn projectile. */
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> InstanceActor;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UStaticMesh>> MeshGroups;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> MeshInstances;
+
+	/** Per mesh group, the instance transforms of the frame. */
+	TArray<TArray<FTransform>> InstanceTransforms;
+};